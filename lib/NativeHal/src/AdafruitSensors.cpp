@@ -0,0 +1,122 @@
+#include "Adafruit_BME280.h"
+#include "Adafruit_INA219.h"
+#include "Adafruit_SHT31.h"
+#include "Arduino.h"
+#include "Sim.h"
+#include "SimI2CDevices.h"
+#include <cmath>
+
+bool Adafruit_INA219::begin(TwoWire* wire) {
+    _wire = wire;
+    _wire->beginTransmission(_address);
+    return _wire->endTransmission() == 0;
+}
+
+float Adafruit_INA219::_readValue(uint8_t reg, float scale) {
+    SimINA219* device = static_cast<SimINA219*>(TwoWire::device(_address));
+    if (!device) return 0.0f;
+    _wire->beginTransmission(_address);
+    _wire->write(reg);
+    _wire->endTransmission();
+    _wire->requestFrom(_address, (uint8_t)2);
+    int16_t raw = (int16_t)((_wire->read() << 8) | _wire->read());
+    return raw * scale;
+}
+
+float Adafruit_INA219::getBusVoltage_V() {
+    SimINA219* device = static_cast<SimINA219*>(TwoWire::device(_address));
+    return device ? device->busVoltage_V : 0.0f;
+}
+
+float Adafruit_INA219::getShuntVoltage_mV() {
+    return _readValue(0x01, 0.01f);
+}
+
+float Adafruit_INA219::getCurrent_mA() {
+    SimINA219* device = static_cast<SimINA219*>(TwoWire::device(_address));
+    return device ? device->current_mA : 0.0f;
+}
+
+bool Adafruit_SHT31::begin(uint8_t address) {
+    _address = address;
+    _wire->beginTransmission(_address);
+    return _wire->endTransmission() == 0;
+}
+
+void Adafruit_SHT31::heater(bool enable) {
+    _wire->beginTransmission(_address);
+    _wire->write(0x30);
+    _wire->write(enable ? 0x6D : 0x66);
+    _wire->endTransmission();
+}
+
+bool Adafruit_SHT31::isHeaterEnabled() {
+    SimSHT31* device = static_cast<SimSHT31*>(TwoWire::device(_address));
+    return device && device->heater;
+}
+
+bool Adafruit_SHT31::_readBoth(float* t, float* h) {
+    // Single shot, high repeatability, with the library's blocking wait.
+    _wire->beginTransmission(_address);
+    _wire->write(0x24);
+    _wire->write(0x00);
+    if (_wire->endTransmission() != 0) return false;
+    delay(20);
+    uint8_t data[6];
+    if (_wire->requestFrom(_address, (uint8_t)6) != 6) return false;
+    for (int i = 0; i < 6; i++) data[i] = (uint8_t)_wire->read();
+    *t = -45.0f + 175.0f * ((data[0] << 8) | data[1]) / 65535.0f;
+    *h = 100.0f * ((data[3] << 8) | data[4]) / 65535.0f;
+    return true;
+}
+
+float Adafruit_SHT31::readTemperature() {
+    float t, h;
+    return _readBoth(&t, &h) ? t : NAN;
+}
+
+float Adafruit_SHT31::readHumidity() {
+    float t, h;
+    return _readBoth(&t, &h) ? h : NAN;
+}
+
+bool Adafruit_BME280::begin(uint8_t address, TwoWire* wire) {
+    _address = address;
+    _wire = wire;
+    _wire->beginTransmission(_address);
+    return _wire->endTransmission() == 0;
+}
+
+void Adafruit_BME280::setSampling(sensor_mode mode, sensor_sampling tempSampling, sensor_sampling pressSampling,
+                                  sensor_sampling humSampling, sensor_filter filter, standby_duration duration) {
+    (void)filter;
+    (void)duration;
+    _wire->beginTransmission(_address);
+    _wire->write(0xF2);
+    _wire->write((uint8_t)humSampling);
+    _wire->endTransmission();
+    _wire->beginTransmission(_address);
+    _wire->write(0xF4);
+    _wire->write((uint8_t)((tempSampling << 5) | (pressSampling << 2) | mode));
+    _wire->endTransmission();
+}
+
+bool Adafruit_BME280::takeForcedMeasurement() {
+    delay(10);
+    return true;
+}
+
+float Adafruit_BME280::readTemperature() {
+    SimBME280* device = static_cast<SimBME280*>(TwoWire::device(_address));
+    return device ? device->tempC : NAN;
+}
+
+float Adafruit_BME280::readPressure() {
+    SimBME280* device = static_cast<SimBME280*>(TwoWire::device(_address));
+    return device ? device->pressure_hPa * 100.0f : NAN;
+}
+
+float Adafruit_BME280::readHumidity() {
+    SimBME280* device = static_cast<SimBME280*>(TwoWire::device(_address));
+    return device ? device->humidity : NAN;
+}
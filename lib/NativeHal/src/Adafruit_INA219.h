@@ -0,0 +1,25 @@
+#ifndef NATIVE_ADAFRUIT_INA219_H
+#define NATIVE_ADAFRUIT_INA219_H
+
+#include <stdint.h>
+#include "Wire.h"
+
+class Adafruit_INA219 {
+  private:
+    uint8_t _address;
+    TwoWire* _wire = nullptr;
+    float _readValue(uint8_t reg, float scale);
+
+  public:
+    explicit Adafruit_INA219(uint8_t address = 0x40) : _address(address) {}
+    bool begin(TwoWire* wire = &Wire);
+    void setCalibration_32V_2A() {}
+    void setCalibration_32V_1A() {}
+    void setCalibration_16V_400mA() {}
+    float getBusVoltage_V();
+    float getShuntVoltage_mV();
+    float getCurrent_mA();
+    float getPower_mW() { return getBusVoltage_V() * getCurrent_mA(); }
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef NATIVE_ADAFRUIT_SHT31_H
+#define NATIVE_ADAFRUIT_SHT31_H
+
+#include <stdint.h>
+#include "Wire.h"
+
+class Adafruit_SHT31 {
+  private:
+    uint8_t _address = 0x44;
+    TwoWire* _wire;
+    bool _readBoth(float* t, float* h);
+
+  public:
+    explicit Adafruit_SHT31(TwoWire* wire = &Wire) : _wire(wire) {}
+    bool begin(uint8_t address = 0x44);
+    void heater(bool enable);
+    bool isHeaterEnabled();
+    float readTemperature();
+    float readHumidity();
+    bool readBoth(float* t, float* h) { return _readBoth(t, h); }
+};
+
+#endif
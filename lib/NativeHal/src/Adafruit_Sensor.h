@@ -0,0 +1,3 @@
+#ifndef NATIVE_ADAFRUIT_SENSOR_H
+#define NATIVE_ADAFRUIT_SENSOR_H
+#endif
@@ -0,0 +1,227 @@
+#include "Arduino.h"
+#include "Sim.h"
+#ifdef ESP32
+#include "driver/ledc.h"
+#else
+#include "coredecls.h"
+#endif
+#include <random>
+
+static std::mt19937 g_random(1);
+
+unsigned long millis() {
+    return Sim::millis();
+}
+
+unsigned long micros() {
+    return (unsigned long)Sim::micros();
+}
+
+void delay(unsigned long ms) {
+    Sim::stats().delayCalls++;
+    Sim::stats().sleptMicros += (uint64_t)ms * 1000;
+    Sim::advanceMicros((uint64_t)ms * 1000);
+}
+
+#ifndef ESP32
+void esp_schedule() {
+    // esp_delay() checks its condition after every simulation event, so there is nothing to post.
+}
+#endif
+
+void delayMicroseconds(unsigned int us) {
+    Sim::advanceMicros(us);
+}
+
+void yield() {
+    Sim::advanceMicros(0);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    Sim::pinMode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    Sim::writeDigital(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+    return Sim::getDigital(pin);
+}
+
+int analogRead(uint8_t pin) {
+    return Sim::getAnalog(pin);
+}
+
+void analogWrite(uint8_t pin, int value) {
+    Sim::writePwm(pin, value);
+}
+
+void analogWriteFreq(uint32_t freq) {
+    (void)freq;
+}
+
+void analogWriteRange(uint32_t range) {
+    (void)range;
+}
+
+void attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int mode) {
+    Sim::attachInterrupt(pin, fn, arg, mode);
+}
+
+void detachInterrupt(uint8_t pin) {
+    Sim::detachInterrupt(pin);
+}
+
+#ifdef ESP32
+static int g_ledcPins[16][4];
+static int g_ledcPinCount[16];
+static uint32_t g_ledcDuty[16];
+static uint32_t g_taskNotifications = 0;
+
+void analogSetPinAttenuation(uint8_t pin, int attenuation) {
+    (void)pin;
+    (void)attenuation;
+}
+
+uint16_t touchRead(uint8_t pin) {
+    return (uint16_t)Sim::getTouch(pin);
+}
+
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolutionBits) {
+    (void)channel;
+    (void)resolutionBits;
+    return frequency;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+    if (channel >= 16 || g_ledcPinCount[channel] >= 4) return;
+    g_ledcPins[channel][g_ledcPinCount[channel]++] = pin;
+}
+
+void ledcDetachPin(uint8_t pin) {
+    for (int channel = 0; channel < 16; channel++) {
+        for (int i = 0; i < g_ledcPinCount[channel]; i++) {
+            if (g_ledcPins[channel][i] == pin) {
+                g_ledcPins[channel][i] = g_ledcPins[channel][--g_ledcPinCount[channel]];
+                return;
+            }
+        }
+    }
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    if (channel >= 16) return;
+    g_ledcDuty[channel] = duty;
+    for (int i = 0; i < g_ledcPinCount[channel]; i++) {
+        Sim::writePwm(g_ledcPins[channel][i], (int)duty);
+    }
+}
+
+struct LedcFade {
+    ledc_cb_t callback;
+    void* arg;
+    uint32_t target;
+    int durationMs;
+};
+static LedcFade g_ledcFades[16];
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+esp_err_t ledc_cb_register(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_cbs_t* cbs, void* user_arg) {
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    LedcFade& fade = g_ledcFades[speed_mode * 8 + channel];
+    fade.callback = cbs ? cbs->fade_cb : nullptr;
+    fade.arg = user_arg;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty, int max_fade_time_ms) {
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    LedcFade& fade = g_ledcFades[speed_mode * 8 + channel];
+    fade.target = target_duty;
+    fade.durationMs = max_fade_time_ms;
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_fade_mode_t fade_mode) {
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    int index = speed_mode * 8 + channel;
+    LedcFade fade = g_ledcFades[index];
+    auto finish = [index, fade, speed_mode, channel]() {
+        // The hardware ramps the pins on its own; only the end result is written here.
+        g_ledcDuty[index] = fade.target;
+        for (int i = 0; i < g_ledcPinCount[index]; i++) {
+            Sim::writePwm(g_ledcPins[index][i], (int)fade.target);
+        }
+        if (fade.callback) {
+            ledc_cb_param_t param = { LEDC_FADE_END_EVT, (uint32_t)speed_mode, (uint32_t)channel, fade.target };
+            fade.callback(&param, fade.arg);
+        }
+    };
+    if (fade_mode == LEDC_FADE_WAIT_DONE) {
+        delay(fade.durationMs);
+        finish();
+    } else {
+        Sim::at(Sim::millis() + fade.durationMs, finish);
+    }
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) return 0;
+    return g_ledcDuty[speed_mode * 8 + channel];
+}
+
+void esp_deep_sleep(uint64_t timeUs) {
+    ESP.deepSleep(timeUs);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    // There is only the loop task.
+    return &g_taskNotifications;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    // Sleep until an interrupt (fired by a simulation event) notifies the task.
+    if (g_taskNotifications == 0 && ticksToWait > 0) {
+        uint64_t start = Sim::micros();
+        Sim::advanceUntil((uint64_t)ticksToWait * 1000, []() { return g_taskNotifications > 0; });
+        Sim::stats().delayCalls++;
+        Sim::stats().sleptMicros += Sim::micros() - start;
+    }
+    uint32_t value = g_taskNotifications;
+    if (clearOnExit) {
+        g_taskNotifications = 0;
+    } else if (value > 0) {
+        g_taskNotifications--;
+    }
+    return value;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    (void)task;
+    g_taskNotifications++;
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdTRUE;
+}
+#endif
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    if (inMax == inMin) return outMin;
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+long random(long max) {
+    return max > 0 ? (long)(g_random() % (unsigned long)max) : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+    g_random.seed(seed);
+}
@@ -0,0 +1,121 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host-side stand-in for the ESP8266 and ESP32 Arduino cores. Only the API surface used by
+// the firmware is provided; everything is backed by the simulation in Sim.h. Build with -DESP32
+// to get the ESP32 flavour (12 bit ADC, LEDC, touch pads, task notifications).
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Esp.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#ifndef ESP32
+// NodeMCU pin mapping. On ESP32 the firmware maps D-pins itself (see Configuration.h).
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+#define A0 17
+#endif
+#define LED_BUILTIN 2
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define F(s) (s)
+
+using std::max;
+using std::min;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void analogWriteFreq(uint32_t freq);
+void analogWriteRange(uint32_t range);
+
+void attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+#define NOT_AN_INTERRUPT -1
+#ifdef ESP32
+#define digitalPinToInterrupt(p) ((p) < 40 ? (int)(p) : NOT_AN_INTERRUPT)
+#else
+// GPIO16 (D0) has no interrupt on the ESP8266.
+#define digitalPinToInterrupt(p) ((p) < 16 ? (int)(p) : NOT_AN_INTERRUPT)
+#endif
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+template <typename T>
+T constrain(T x, T low, T high) { return x < low ? low : (x > high ? high : x); }
+
+#ifdef ESP32
+#define ADC_11db 3
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+void analogSetPinAttenuation(uint8_t pin, int attenuation);
+uint16_t touchRead(uint8_t pin);
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolutionBits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcDetachPin(uint8_t pin);
+void ledcWrite(uint8_t channel, uint32_t duty);
+void esp_deep_sleep(uint64_t timeUs);
+
+// FreeRTOS task notifications, enough for a single loop task woken from interrupts.
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+TaskHandle_t xTaskGetCurrentTaskHandle();
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+#else
+#define RTC_DATA_ATTR
+#endif
+
+void setup();
+void loop();
+
+#endif
@@ -0,0 +1,112 @@
+#include "DallasTemperature.h"
+#include "Arduino.h"
+#include "Sim.h"
+#include <map>
+
+static std::map<uint8_t, std::vector<SimOneWireSensor>>& buses() {
+    static std::map<uint8_t, std::vector<SimOneWireSensor>> map;
+    return map;
+}
+
+static int g_sensorsPerBus = 0;
+
+static SimOneWireSensor makeSensor(uint8_t pin, uint8_t serial, float tempC) {
+    SimOneWireSensor sensor = {{0x28, serial, pin, 0x00, 0x00, 0x00, 0x00, 0x00}, tempC};
+    // Last byte is the ROM CRC; the simulation does not check it.
+    sensor.rom[7] = (uint8_t)(0x28 ^ serial ^ pin);
+    return sensor;
+}
+
+void Sim::setOneWireSensorsPerBus(int count) {
+    g_sensorsPerBus = count;
+}
+
+std::vector<SimOneWireSensor>& OneWire::sensors(uint8_t pin) {
+    auto it = buses().find(pin);
+    if (it != buses().end()) return it->second;
+
+    // First use of a bus nobody populated explicitly: attach the default sensors.
+    std::vector<SimOneWireSensor>& list = buses()[pin];
+    for (int i = 0; i < g_sensorsPerBus; i++) {
+        list.push_back(makeSensor(pin, (uint8_t)(i + 1), 19.5f + 1.5f * i));
+    }
+    return list;
+}
+
+void OneWire::addSensor(uint8_t pin, uint8_t serial, float tempC) {
+    buses()[pin].push_back(makeSensor(pin, serial, tempC));
+}
+
+void DallasTemperature::begin() {
+    // Enumerating the bus costs a reset + search per device.
+    Sim::advanceMicros(3000 * (getDeviceCount() + 1));
+}
+
+uint8_t DallasTemperature::getDeviceCount() {
+    return (uint8_t)OneWire::sensors(_wire->pin()).size();
+}
+
+bool DallasTemperature::getAddress(uint8_t* address, uint8_t index) {
+    std::vector<SimOneWireSensor>& list = OneWire::sensors(_wire->pin());
+    if (index >= list.size()) return false;
+    memcpy(address, list[index].rom, 8);
+    return true;
+}
+
+const SimOneWireSensor* DallasTemperature::_find(const uint8_t* address) {
+    for (const SimOneWireSensor& sensor : OneWire::sensors(_wire->pin())) {
+        if (memcmp(sensor.rom, address, 8) == 0) return &sensor;
+    }
+    return nullptr;
+}
+
+bool DallasTemperature::isConnected(const uint8_t* address) {
+    return _find(address) != nullptr;
+}
+
+int16_t DallasTemperature::millisToWaitForConversion(uint8_t bits) {
+    switch (bits) {
+        case 9: return 94;
+        case 10: return 188;
+        case 11: return 375;
+        default: return 750;
+    }
+}
+
+DallasTemperature::request_t DallasTemperature::requestTemperatures() {
+    _conversionStart = millis();
+    _converting = true;
+    if (_waitForConversion) {
+        delay(millisToWaitForConversion(_resolution));
+        _converting = false;
+    }
+    return {true, _conversionStart};
+}
+
+DallasTemperature::request_t DallasTemperature::requestTemperaturesByAddress(const uint8_t* address) {
+    (void)address;
+    return requestTemperatures();
+}
+
+bool DallasTemperature::isConversionComplete() {
+    if (_converting && millis() - _conversionStart >= (unsigned long)millisToWaitForConversion(_resolution)) {
+        _converting = false;
+    }
+    return !_converting;
+}
+
+float DallasTemperature::getTempC(const uint8_t* address) {
+    // Reading the scratchpad of one device: reset + match ROM + 9 bytes.
+    Sim::advanceMicros(1500);
+    const SimOneWireSensor* sensor = _find(address);
+    if (!sensor || !isConversionComplete()) return DEVICE_DISCONNECTED_C;
+    return sensor->tempC;
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index) {
+    // Without a cached address the library searches the bus first.
+    Sim::advanceMicros(3000 * (index + 1));
+    DeviceAddress address;
+    if (!getAddress(address, index)) return DEVICE_DISCONNECTED_C;
+    return getTempC(address);
+}
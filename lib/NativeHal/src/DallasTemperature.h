@@ -0,0 +1,49 @@
+#ifndef NATIVE_DALLAS_TEMPERATURE_H
+#define NATIVE_DALLAS_TEMPERATURE_H
+
+#include <stdint.h>
+#include "OneWire.h"
+
+typedef uint8_t DeviceAddress[8];
+
+#define DEVICE_DISCONNECTED_C -127
+#define DEVICE_DISCONNECTED_F -196.6
+#define DEVICE_DISCONNECTED_RAW -7040
+
+class DallasTemperature {
+  private:
+    OneWire* _wire;
+    bool _waitForConversion = true;
+    uint8_t _resolution = 12;
+    unsigned long _conversionStart = 0;
+    bool _converting = false;
+
+    const SimOneWireSensor* _find(const uint8_t* address);
+
+  public:
+    struct request_t {
+        bool result;
+        unsigned long timestamp;
+        operator bool() const { return result; }
+    };
+
+    explicit DallasTemperature(OneWire* wire) : _wire(wire) {}
+    void begin();
+    uint8_t getDeviceCount();
+    bool getAddress(uint8_t* address, uint8_t index);
+    bool isConnected(const uint8_t* address);
+    void setWaitForConversion(bool wait) { _waitForConversion = wait; }
+    bool getWaitForConversion() { return _waitForConversion; }
+    void setResolution(uint8_t bits) { _resolution = bits; }
+    uint8_t getResolution() { return _resolution; }
+    int16_t millisToWaitForConversion(uint8_t bits);
+    int16_t millisToWaitForConversion() { return millisToWaitForConversion(_resolution); }
+    request_t requestTemperatures();
+    request_t requestTemperaturesByAddress(const uint8_t* address);
+    bool isConversionComplete();
+    float getTempC(const uint8_t* address);
+    float getTempCByIndex(uint8_t index);
+    static float toFahrenheit(float celsius) { return celsius * 1.8f + 32.0f; }
+};
+
+#endif
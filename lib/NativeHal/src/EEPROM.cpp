@@ -0,0 +1,33 @@
+#include "EEPROM.h"
+#include "Sim.h"
+
+EEPROMClass EEPROM;
+
+void EEPROMClass::begin(size_t size) {
+    // Erased flash reads back as 0xFF.
+    if (_flash.size() < size) _flash.resize(size, 0xFF);
+    _data.assign(_flash.begin(), _flash.begin() + size);
+}
+
+bool EEPROMClass::commit() {
+    Sim::stats().eepromCommits++;
+    // A commit erases and rewrites the whole sector, which takes a few milliseconds.
+    Sim::advanceMicros(5000);
+    if (_flash.size() < _data.size()) _flash.resize(_data.size(), 0xFF);
+    std::copy(_data.begin(), _data.end(), _flash.begin());
+    return true;
+}
+
+bool EEPROMClass::end() {
+    bool ok = commit();
+    _data.clear();
+    return ok;
+}
+
+uint8_t EEPROMClass::read(int address) const {
+    return (address >= 0 && (size_t)address < _data.size()) ? _data[address] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address >= 0 && (size_t)address < _data.size()) _data[address] = value;
+}
@@ -0,0 +1,44 @@
+#ifndef NATIVE_EEPROM_H
+#define NATIVE_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// Emulated EEPROM: a RAM image that is "committed" to a simulated flash sector.
+class EEPROMClass {
+  private:
+    std::vector<uint8_t> _data;
+    std::vector<uint8_t> _flash;
+
+  public:
+    void begin(size_t size);
+    bool commit();
+    bool end();
+    size_t length() const { return _data.size(); }
+    uint8_t read(int address) const;
+    void write(int address, uint8_t value);
+    uint8_t* getDataPtr() { return _data.data(); }
+    const uint8_t* getConstDataPtr() const { return _data.data(); }
+
+    template <typename T>
+    T& get(int address, T& value) {
+        if (address >= 0 && address + sizeof(T) <= _data.size()) {
+            memcpy((void*)&value, _data.data() + address, sizeof(T));
+        }
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value) {
+        if (address >= 0 && address + sizeof(T) <= _data.size()) {
+            memcpy(_data.data() + address, (const void*)&value, sizeof(T));
+        }
+        return value;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1 @@
+#include "HTTPClient.h"
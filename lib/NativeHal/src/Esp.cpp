@@ -0,0 +1,81 @@
+#include "Esp.h"
+#include "Sim.h"
+#include <malloc.h>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+EspClass ESP;
+
+// RTC user memory survives deep sleep (512 bytes on the ESP8266).
+static uint32_t g_rtcMemory[128];
+
+uint32_t EspClass::getFreeHeap() {
+    size_t used = Sim::stats().heapInUse;
+    return used >= Sim::heapSize() ? 0 : (uint32_t)(Sim::heapSize() - used);
+}
+
+uint32_t EspClass::getMaxFreeBlockSize() {
+    // The host allocator does not fragment like umm_malloc; report the free heap.
+    return getFreeHeap();
+}
+
+uint8_t EspClass::getHeapFragmentation() {
+    return 0;
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(Sim::micros() * getCpuFreqMHz());
+}
+
+void EspClass::restart() {
+    throw Sim::Reset{"restart", 0};
+}
+
+void EspClass::deepSleep(uint64_t timeUs) {
+    throw Sim::Reset{"deepSleep", timeUs};
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+    if (offset * 4 + size > sizeof(g_rtcMemory)) return false;
+    memcpy(data, (uint8_t*)g_rtcMemory + offset * 4, size);
+    return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+    if (offset * 4 + size > sizeof(g_rtcMemory)) return false;
+    memcpy((uint8_t*)g_rtcMemory + offset * 4, data, size);
+    return true;
+}
+
+// Count every heap allocation so the report can show per-config heap use.
+void* operator new(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    Sim::Stats& stats = Sim::stats();
+    stats.heapInUse += malloc_usable_size(p);
+    if (stats.heapInUse > stats.heapPeak) stats.heapPeak = stats.heapInUse;
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    Sim::stats().heapInUse -= malloc_usable_size(p);
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
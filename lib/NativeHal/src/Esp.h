@@ -0,0 +1,24 @@
+#ifndef NATIVE_ESP_H
+#define NATIVE_ESP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class EspClass {
+  public:
+    uint32_t getFreeHeap();
+    uint32_t getMaxFreeBlockSize();
+    uint32_t getMaxAllocHeap() { return getMaxFreeBlockSize(); }
+    uint8_t getHeapFragmentation();
+    uint32_t getCycleCount();
+    uint8_t getCpuFreqMHz() { return 80; }
+    uint32_t getChipId() { return 0x00C0FFEE; }
+    [[noreturn]] void restart();
+    [[noreturn]] void deepSleep(uint64_t timeUs);
+    bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+    bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,103 @@
+#include "FS.h"
+#include "LittleFS.h"
+#include "Sim.h"
+#include <string.h>
+
+fs::FS LittleFS;
+
+namespace fs {
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!_data || !_writable) return 0;
+    // A power cut keeps what reached the flash; LittleFS itself would roll back to the last
+    // sync, so torn files here are the harder case.
+    size_t written = Sim::takeFsSteps(size);
+    if (_position + written > _data->size()) _data->resize(_position + written);
+    memcpy(_data->data() + _position, buffer, written);
+    _position += written;
+    Sim::stats().fsBytesWritten += written;
+    if (written < size) throw Sim::Reset{"power cut", 0};
+    return size;
+}
+
+int File::read() {
+    if (!_data || _position >= _data->size()) return -1;
+    return (*_data)[_position++];
+}
+
+int File::peek() {
+    if (!_data || _position >= _data->size()) return -1;
+    return (*_data)[_position];
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!_data || _position >= _data->size()) return 0;
+    size_t n = _data->size() - _position;
+    if (n > size) n = size;
+    memcpy(buffer, _data->data() + _position, n);
+    _position += n;
+    return n;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_data) return false;
+    size_t base = mode == SeekSet ? 0 : mode == SeekCur ? _position : _data->size();
+    if (base + pos > _data->size()) return false;
+    _position = base + pos;
+    return true;
+}
+
+#ifdef ESP32
+bool FS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    _mounted = true;
+    return true;
+}
+#else
+bool FS::begin() {
+    _mounted = true;
+    return true;
+}
+#endif
+
+bool FS::format() {
+    _files.clear();
+    return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+    if (!_mounted) return File();
+    auto it = _files.find(path);
+    bool write = mode[0] == 'w' || mode[0] == 'a' || strchr(mode, '+') != nullptr;
+    if (it == _files.end()) {
+        if (mode[0] == 'r') return File();
+        it = _files.emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+    }
+    if (mode[0] == 'w' && !it->second->empty()) {
+        if (Sim::takeFsSteps(1) == 0) throw Sim::Reset{"power cut", 0};
+        it->second->clear();
+    }
+    Sim::stats().fsOpens++;
+    return File(it->second, path, mode[0] == 'a' ? it->second->size() : 0, write);
+}
+
+bool FS::exists(const char* path) {
+    return _mounted && _files.count(path) > 0;
+}
+
+bool FS::remove(const char* path) {
+    if (!_mounted || _files.count(path) == 0) return false;
+    if (Sim::takeFsSteps(1) == 0) throw Sim::Reset{"power cut", 0};
+    return _files.erase(path) > 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    auto it = _files.find(from);
+    if (!_mounted || it == _files.end()) return false;
+    // Atomic, as in LittleFS.
+    if (Sim::takeFsSteps(1) == 0) throw Sim::Reset{"power cut", 0};
+    _files[to] = it->second;
+    _files.erase(from);
+    return true;
+}
+
+}
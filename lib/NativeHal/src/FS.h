@@ -0,0 +1,75 @@
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Print.h"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+// A file of the simulated flash filesystem. Contents live in RAM for the length of the run.
+class File : public Stream {
+  private:
+    std::shared_ptr<std::vector<uint8_t>> _data;
+    size_t _position = 0;
+    bool _writable = false;
+    std::string _name;
+
+  public:
+    File() {}
+    File(std::shared_ptr<std::vector<uint8_t>> data, const std::string& name, size_t position, bool writable)
+        : _data(data), _position(position), _writable(writable), _name(name) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override { return _data ? (int)(_data->size() - _position) : 0; }
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const { return _position; }
+    size_t size() const { return _data ? _data->size() : 0; }
+    const char* name() const { return _name.c_str(); }
+    void close() { _data.reset(); }
+    operator bool() const { return (bool)_data; }
+};
+
+class FS {
+  private:
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> _files;
+    bool _mounted = false;
+
+  public:
+#ifdef ESP32
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+#else
+    bool begin();
+#endif
+    void end() { _mounted = false; }
+    bool format();
+    File open(const char* path, const char* mode = "r");
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+};
+
+}
+
+using fs::File;
+using fs::FS;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif
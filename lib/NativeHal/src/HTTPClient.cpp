@@ -0,0 +1,65 @@
+#include "HTTPClient.h"
+#include "Sim.h"
+#include "SimNetwork.h"
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+    _client = &client;
+    _url = url;
+    return url.startsWith("http://");
+}
+
+bool HTTPClient::begin(WiFiClient& client, const String& host, uint16_t port, const String& uri) {
+    return begin(client, "http://" + host + ":" + String(port) + uri);
+}
+
+void HTTPClient::end() {
+    if (!_reuse && _client) _client->stop();
+    _response = "";
+}
+
+void HTTPClient::addHeader(const String& name, const String& value, bool first, bool replace) {
+    (void)name;
+    (void)value;
+    (void)first;
+    (void)replace;
+}
+
+int HTTPClient::POST(const uint8_t* payload, size_t size) {
+    (void)payload;
+    if (!_client) return HTTPC_ERROR_CONNECTION_REFUSED;
+    if (!_client->connected()) {
+        int start = _url.indexOf("://") + 3;
+        int end = _url.indexOf('/', start);
+        String host = _url.substring(start, end < 0 ? _url.length() : end);
+        int colon = host.indexOf(':');
+        uint16_t port = colon < 0 ? 80 : (uint16_t)host.substring(colon + 1).toInt();
+        if (colon >= 0) host = host.substring(0, colon);
+        if (!_client->connect(host.c_str(), port)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    Sim::Network& net = Sim::network();
+    if (!net.httpUp) {
+        _client->stop();
+        return HTTPC_ERROR_CONNECTION_LOST;
+    }
+    Sim::stats().httpPosts++;
+    Sim::stats().httpBytes += size;
+    _client->write(payload, size);
+    // One round trip on the LAN.
+    Sim::advanceMicros(15000);
+    _response = net.httpResponse.c_str();
+    return HTTP_CODE_OK;
+}
+
+int HTTPClient::sendRequest(const char* type, Stream* stream, size_t size) {
+    (void)type;
+    (void)stream;
+    return POST(nullptr, size);
+}
+
+String HTTPClient::errorToString(int error) {
+    switch (error) {
+        case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+        case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+        default: return "error " + String(error);
+    }
+}
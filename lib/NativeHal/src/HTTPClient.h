@@ -0,0 +1,39 @@
+#ifndef NATIVE_HTTP_CLIENT_H
+#define NATIVE_HTTP_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+
+// HTTP client that answers from Sim::network() instead of a real server.
+class HTTPClient {
+  private:
+    WiFiClient* _client = nullptr;
+    String _url;
+    String _response;
+    bool _reuse = true;
+    uint16_t _timeout = 5000;
+
+  public:
+    bool begin(WiFiClient& client, const String& url);
+    bool begin(WiFiClient& client, const String& host, uint16_t port, const String& uri = "/");
+    void end();
+    void setReuse(bool reuse) { _reuse = reuse; }
+    void setTimeout(uint16_t timeout) { _timeout = timeout; }
+    void setConnectTimeout(int32_t timeout) { (void)timeout; }
+    void addHeader(const String& name, const String& value, bool first = false, bool replace = true);
+    int POST(const uint8_t* payload, size_t size);
+    int POST(const String& payload) { return POST((const uint8_t*)payload.c_str(), payload.length()); }
+    int sendRequest(const char* type, Stream* stream, size_t size);
+    String getString() { return _response; }
+    int getSize() { return (int)_response.length(); }
+    bool connected() { return _client && _client->connected(); }
+    static String errorToString(int error);
+};
+
+#endif
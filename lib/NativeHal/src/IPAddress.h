@@ -0,0 +1,30 @@
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include <stdint.h>
+#include "WString.h"
+
+class IPAddress {
+  private:
+    uint8_t _octets[4];
+
+  public:
+    IPAddress() : _octets{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _octets{a, b, c, d} {}
+    IPAddress(uint32_t address) {
+        for (int i = 0; i < 4; i++) _octets[i] = (address >> (8 * i)) & 0xFF;
+    }
+    operator uint32_t() const {
+        return (uint32_t)_octets[0] | ((uint32_t)_octets[1] << 8) | ((uint32_t)_octets[2] << 16) | ((uint32_t)_octets[3] << 24);
+    }
+    uint8_t operator[](int index) const { return _octets[index]; }
+    uint8_t& operator[](int index) { return _octets[index]; }
+    bool operator==(const IPAddress& other) const { return (uint32_t)*this == (uint32_t)other; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+    bool isSet() const { return (uint32_t)*this != 0; }
+    bool fromString(const char* address);
+    bool fromString(const String& address) { return fromString(address.c_str()); }
+    String toString() const;
+};
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef NATIVE_LITTLE_FS_H
+#define NATIVE_LITTLE_FS_H
+
+#include "FS.h"
+
+extern fs::FS LittleFS;
+
+#endif
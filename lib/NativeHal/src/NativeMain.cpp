@@ -0,0 +1,73 @@
+// Unit tests under test/ bring their own main().
+#ifndef PIO_UNIT_TESTING
+
+#include "Arduino.h"
+#include "Sim.h"
+#include "SimNetwork.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Entry point of the native build: runs setup() and loop() of the selected room config against
+// the simulated hardware for the given number of simulated seconds, then prints a report.
+// --command sends a JSON command to the device whenever it subscribes, e.g. to compare payload
+// encodings (bytes and encode time per publish) for a room. --outage=<start>,<seconds> takes the
+// access point away for a while, e.g. to watch telemetry being buffered and replayed.
+// --broker-down leaves the MQTT broker unreachable, so every exchange takes the HTTP fallback:
+//
+//   pio run -e native_woodshed && .pio/build/native_woodshed/program 3600
+//   .pio/build/native_woodshed/program 3600 --command='{"dataExchanger":{"setFormat":"msgpack"}}'
+//   .pio/build/native_woodshed/program 7200 --outage=600,1800
+//   .pio/build/native_woodshed/program 3600 --broker-down
+int main(int argc, char** argv) {
+    unsigned long seconds = 3600;
+    std::string command;
+    unsigned long outageStart = 0;
+    unsigned long outageSeconds = 0;
+    bool brokerDown = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--command=", 10) == 0) {
+            command = argv[i] + 10;
+        } else if (strncmp(argv[i], "--outage=", 9) == 0) {
+            char* rest = nullptr;
+            outageStart = strtoul(argv[i] + 9, &rest, 10);
+            outageSeconds = (rest && *rest == ',') ? strtoul(rest + 1, nullptr, 10) : 0;
+        } else if (strcmp(argv[i], "--broker-down") == 0) {
+            brokerDown = true;
+        } else {
+            seconds = strtoul(argv[i], nullptr, 10);
+        }
+    }
+    uint64_t endMicros = (uint64_t)seconds * 1000000;
+
+    Sim::installDefaultScenario();
+    Sim::network().commandOnSubscribe = command;
+    Sim::network().brokerUp = !brokerDown;
+    if (outageSeconds > 0) {
+        Sim::at(outageStart * 1000, []() { Sim::network().apReachable = false; });
+        Sim::at((outageStart + outageSeconds) * 1000, []() { Sim::network().apReachable = true; });
+    }
+
+    unsigned long passes = 0;
+    uint64_t hostNanos = 0;
+    std::string endReason = "time limit";
+
+    try {
+        setup();
+        while (Sim::micros() < endMicros) {
+            auto start = std::chrono::steady_clock::now();
+            loop();
+            hostNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            passes++;
+        }
+    } catch (const Sim::Reset& reset) {
+        endReason = reset.reason;
+    }
+
+    Sim::printReport(passes, hostNanos, endReason.c_str());
+    return 0;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef NATIVE_ONE_WIRE_H
+#define NATIVE_ONE_WIRE_H
+
+#include <stdint.h>
+#include <vector>
+
+// A sensor on a simulated OneWire bus.
+struct SimOneWireSensor {
+    uint8_t rom[8];
+    float tempC;
+};
+
+class OneWire {
+  private:
+    uint8_t _pin;
+
+  public:
+    explicit OneWire(uint8_t pin) : _pin(pin) {}
+    uint8_t pin() const { return _pin; }
+
+    // Sensors attached to the simulated bus on a pin.
+    static std::vector<SimOneWireSensor>& sensors(uint8_t pin);
+    static void addSensor(uint8_t pin, uint8_t serial, float tempC);
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "Preferences.h"
+#include "Sim.h"
+#include <map>
+#include <string.h>
+#include <vector>
+
+// One map per namespace; the default NVS partition holds 504 entries of 32 bytes.
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> g_nvs;
+static const size_t NVS_ENTRIES = 504;
+static const size_t NVS_ENTRY_SIZE = 32;
+
+static size_t entriesFor(size_t length) {
+    // A blob takes a header entry plus its data rounded up to whole entries.
+    return 1 + (length + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE;
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    _namespace = name;
+    _readOnly = readOnly;
+    _started = true;
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) return false;
+    g_nvs[_namespace].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_started || _readOnly) return false;
+    return g_nvs[_namespace].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return _started && g_nvs[_namespace].count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!_started || _readOnly || !key || !value || !length) return 0;
+    g_nvs[_namespace][key].assign((const uint8_t*)value, (const uint8_t*)value + length);
+    Sim::stats().nvsWrites++;
+    Sim::stats().nvsBytesWritten += length;
+    // NVS appends the new entries to the active page and marks the old ones erased; no sector
+    // erase unless a page has to be reclaimed. Roughly 50 us per 32-byte entry programmed.
+    Sim::advanceMicros(50 * entriesFor(length));
+    return length;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!_started) return 0;
+    auto& entries = g_nvs[_namespace];
+    auto it = entries.find(key);
+    return it == entries.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    if (!_started) return 0;
+    auto& entries = g_nvs[_namespace];
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second.size() > maxLength) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::freeEntries() {
+    size_t used = 0;
+    for (auto& ns : g_nvs) {
+        for (auto& entry : ns.second) {
+            used += entriesFor(entry.second.size());
+        }
+    }
+    return used < NVS_ENTRIES ? NVS_ENTRIES - used : 0;
+}
@@ -0,0 +1,27 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Emulated ESP32 NVS through the Preferences API. Entries outlive simulated reboots, like flash.
+class Preferences {
+  private:
+    std::string _namespace;
+    bool _started = false;
+    bool _readOnly = false;
+
+  public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+    size_t putBytes(const char* key, const void* value, size_t length);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+    size_t freeEntries();
+};
+
+#endif
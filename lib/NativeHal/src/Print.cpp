@@ -0,0 +1,28 @@
+#include "Print.h"
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+HardwareSerial Serial;
+
+int Print::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+    if (length <= 0) return length;
+
+    std::vector<char> buffer(length + 1);
+    va_start(args, format);
+    vsnprintf(buffer.data(), buffer.size(), format, args);
+    va_end(args);
+    return (int)write((const uint8_t*)buffer.data(), length);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
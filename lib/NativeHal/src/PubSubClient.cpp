@@ -0,0 +1,198 @@
+#include "PubSubClient.h"
+#include "Sim.h"
+#include "SimNetwork.h"
+
+// Fixed header + topic length prefix, as in the real library.
+static const size_t MQTT_OVERHEAD = 5 + 2;
+
+PubSubClient::PubSubClient() {
+    _buffer.resize(256);
+}
+
+PubSubClient& PubSubClient::setCallback(std::function<void(char*, uint8_t*, unsigned int)> cb) {
+    callback = cb;
+    return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+    if (size == 0) return false;
+    _buffer.assign(size, 0);
+    _buffer.shrink_to_fit();
+    return true;
+}
+
+bool PubSubClient::connect(const char* id) {
+    return connect(id, nullptr, 0, false, nullptr);
+}
+
+bool PubSubClient::connect(const char* id, const char* willTopic, uint8_t willQos, bool willRetain, const char* willMessage) {
+    (void)id;
+    (void)willTopic;
+    (void)willQos;
+    (void)willRetain;
+    (void)willMessage;
+    if (!_client) return false;
+    bool tcp = _client->connected() || (_domain.empty() ? _client->connect(_ip, _port) : _client->connect(_domain.c_str(), _port));
+    if (!tcp) {
+        _state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+    Sim::Network& net = Sim::network();
+    if (!net.brokerUp) {
+        // The real client waits for CONNACK until the socket timeout expires.
+        Sim::advanceMicros((uint64_t)_socketTimeout * 1000000);
+        _client->stop();
+        _state = MQTT_CONNECTION_TIMEOUT;
+        return false;
+    }
+    Sim::advanceMicros(3000);
+    _connected = true;
+    _state = MQTT_CONNECTED;
+    _subscriptions.clear();
+    Sim::stats().mqttConnects++;
+    net.deliver = [this](const std::string& topic, const uint8_t* payload, size_t length) {
+        for (const std::string& filter : _subscriptions) {
+            if (!_matches(filter, topic)) continue;
+            if (length + topic.size() + MQTT_OVERHEAD > _buffer.size()) return;
+            std::vector<char> topicCopy(topic.begin(), topic.end());
+            topicCopy.push_back(0);
+            std::vector<uint8_t> payloadCopy(payload, payload + length);
+            if (callback) callback(topicCopy.data(), payloadCopy.data(), (unsigned int)length);
+            return;
+        }
+    };
+    return true;
+}
+
+void PubSubClient::disconnect() {
+    _connected = false;
+    _state = MQTT_DISCONNECTED;
+    if (_client) _client->stop();
+}
+
+bool PubSubClient::connected() {
+    if (_connected && (!_client || !_client->connected() || !Sim::network().brokerUp)) {
+        _connected = false;
+        _state = MQTT_CONNECTION_LOST;
+    }
+    return _connected;
+}
+
+bool PubSubClient::loop() {
+    return connected();
+}
+
+bool PubSubClient::subscribe(const char* topic, uint8_t qos) {
+    (void)qos;
+    if (!connected()) return false;
+    _subscriptions.push_back(topic);
+    Sim::Network& net = Sim::network();
+    std::string filter(topic);
+    const std::string suffix = "/command";
+    bool jsonCommands = filter.size() > suffix.size() && filter.compare(filter.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+                        filter.find("/msgpack/") == std::string::npos;
+    if (jsonCommands && !net.commandOnSubscribe.empty()) {
+        // Delivered from the event queue, i.e. while the firmware sleeps, like a real broker.
+        std::string command = net.commandOnSubscribe;
+        Sim::at(Sim::millis() + 1, [filter, command]() {
+            Sim::Network& n = Sim::network();
+            if (n.deliver) n.deliver(filter, (const uint8_t*)command.data(), command.size());
+        });
+    }
+    return true;
+}
+
+bool PubSubClient::unsubscribe(const char* topic) {
+    for (size_t i = 0; i < _subscriptions.size(); i++) {
+        if (_subscriptions[i] == topic) {
+            _subscriptions.erase(_subscriptions.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PubSubClient::_matches(const std::string& filter, const std::string& topic) const {
+    size_t f = 0;
+    size_t t = 0;
+    while (f < filter.size()) {
+        if (filter[f] == '#') return true;
+        if (filter[f] == '+') {
+            while (t < topic.size() && topic[t] != '/') t++;
+            f++;
+            continue;
+        }
+        if (t >= topic.size() || filter[f] != topic[t]) return false;
+        f++;
+        t++;
+    }
+    return t == topic.size();
+}
+
+void PubSubClient::_record(const std::string& topic, const uint8_t* payload, size_t length) {
+    Sim::Stats& stats = Sim::stats();
+    stats.mqttPublishes++;
+    stats.mqttBytes += length;
+    if (length > stats.mqttLargestPayload) stats.mqttLargestPayload = length;
+    Sim::Network& net = Sim::network();
+    if (net.onPublish) net.onPublish(topic, payload, length);
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+    return publish(topic, (const uint8_t*)payload, payload ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+    (void)retained;
+    if (!connected()) return false;
+    // The real client copies topic and payload into its buffer before sending.
+    if (length + strlen(topic) + MQTT_OVERHEAD > _buffer.size()) return false;
+    memcpy(_buffer.data(), payload, length);
+    _record(topic, payload, length);
+    return true;
+}
+
+bool PubSubClient::beginPublish(const char* topic, unsigned int length, bool retained) {
+    (void)retained;
+    if (!connected()) return false;
+    _streamTopic = topic;
+    _streamPayload.clear();
+    _streamExpected = length;
+    _streamWritten = 0;
+    _streamStart = std::chrono::steady_clock::now();
+    return true;
+}
+
+// On the device streamed bytes go straight to the socket. They are only kept here when a
+// scenario listens for publishes, so the heap numbers match the device.
+size_t PubSubClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t PubSubClient::write(const uint8_t* buffer, size_t size) {
+    if (!connected()) return 0;
+    if (Sim::network().failedStreamWrites > 0) {
+        Sim::network().failedStreamWrites--;
+        return 0;
+    }
+    if (Sim::network().onPublish) _streamPayload.insert(_streamPayload.end(), buffer, buffer + size);
+    _streamWritten += size;
+    Sim::stats().mqttStreamWrites++;
+    return size;
+}
+
+int PubSubClient::endPublish() {
+    // Like PubSubClient 2.8, which returns 1 whatever was written; a short packet is only counted
+    // as a publish here if it was complete.
+    if (!connected() || _streamWritten != _streamExpected) return 1;
+    Sim::Stats& stats = Sim::stats();
+    stats.mqttEncodeNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _streamStart).count();
+    stats.mqttPublishes++;
+    stats.mqttBytes += _streamWritten;
+    if (_streamWritten > stats.mqttLargestPayload) stats.mqttLargestPayload = _streamWritten;
+    Sim::Network& net = Sim::network();
+    if (net.onPublish) net.onPublish(_streamTopic, _streamPayload.data(), _streamPayload.size());
+    _streamPayload.clear();
+    _streamPayload.shrink_to_fit();
+    return 1;
+}
@@ -0,0 +1,76 @@
+#ifndef NATIVE_PUB_SUB_CLIENT_H
+#define NATIVE_PUB_SUB_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+
+#define MQTT_CONNECTION_TIMEOUT     -4
+#define MQTT_CONNECTION_LOST        -3
+#define MQTT_CONNECT_FAILED         -2
+#define MQTT_DISCONNECTED           -1
+#define MQTT_CONNECTED               0
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+// PubSubClient against the simulated broker. It keeps the real library's buffer
+// semantics (publish() payloads must fit the buffer, beginPublish() streams) so payload
+// and heap numbers match the device.
+class PubSubClient : public Print {
+  private:
+    WiFiClient* _client = nullptr;
+    MQTT_CALLBACK_SIGNATURE;
+    std::vector<uint8_t> _buffer;
+    std::vector<std::string> _subscriptions;
+    std::string _streamTopic;
+    std::vector<uint8_t> _streamPayload;
+    size_t _streamExpected = 0;
+    size_t _streamWritten = 0;
+    std::chrono::steady_clock::time_point _streamStart;
+    bool _connected = false;
+    // Like the real client, a domain is looked up on every connect; an address is used as is.
+    std::string _domain = "broker";
+    IPAddress _ip;
+    uint16_t _port = 1883;
+    uint16_t _socketTimeout = 15;
+    int _state = -1;
+
+    bool _matches(const std::string& filter, const std::string& topic) const;
+    void _record(const std::string& topic, const uint8_t* payload, size_t length);
+
+  public:
+    PubSubClient();
+    PubSubClient& setClient(WiFiClient& client) { _client = &client; return *this; }
+    PubSubClient& setCallback(std::function<void(char*, uint8_t*, unsigned int)> cb);
+    PubSubClient& setServer(const char* domain, uint16_t port) { _domain = domain; _port = port; return *this; }
+    PubSubClient& setServer(IPAddress ip, uint16_t port) { _domain.clear(); _ip = ip; _port = port; return *this; }
+    PubSubClient& setSocketTimeout(uint16_t timeout) { _socketTimeout = timeout; return *this; }
+    PubSubClient& setKeepAlive(uint16_t keepAlive) { (void)keepAlive; return *this; }
+    bool setBufferSize(uint16_t size);
+    uint16_t getBufferSize() { return (uint16_t)_buffer.size(); }
+
+    bool connect(const char* id);
+    bool connect(const char* id, const char* willTopic, uint8_t willQos, bool willRetain, const char* willMessage);
+    void disconnect();
+    bool connected();
+    int state() { return _state; }
+    bool loop();
+    bool subscribe(const char* topic, uint8_t qos = 0);
+    bool unsubscribe(const char* topic);
+
+    bool publish(const char* topic, const char* payload, bool retained = false);
+    bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained = false);
+    bool beginPublish(const char* topic, unsigned int length, bool retained);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int endPublish();
+};
+
+#endif
@@ -0,0 +1,224 @@
+#include "Sim.h"
+#include "Arduino.h"
+#include <cstdio>
+#include <map>
+#include <vector>
+
+namespace {
+
+struct Event {
+    uint64_t atMicros;
+    uint64_t periodMicros;
+    std::function<void()> fn;
+};
+
+struct Pin {
+    int mode = INPUT;
+    int level = LOW;
+    int analog = 0;
+    int touch = 80; // Untouched pad
+    int pwm = 0;
+    void (*isr)(void*) = nullptr;
+    void* isrArg = nullptr;
+    int isrMode = 0;
+};
+
+// Plain values are constant-initialized; containers are function-local because the firmware's
+// static device objects touch pins from their constructors, before main() runs.
+uint64_t g_micros = 0;
+Sim::Stats g_stats;
+#ifdef ESP32
+size_t g_heapSize = 300000;
+#else
+size_t g_heapSize = 81920;
+#endif
+long g_fsStepsLeft = -1;
+
+std::vector<Event>& events() {
+    static std::vector<Event> list;
+    return list;
+}
+
+std::map<int, Pin>& pins() {
+    static std::map<int, Pin> map;
+    return map;
+}
+
+void runDueEvents() {
+    bool ran = true;
+    while (ran) {
+        ran = false;
+        for (size_t i = 0; i < events().size(); i++) {
+            if (events()[i].atMicros <= g_micros) {
+                Event event = events()[i];
+                if (event.periodMicros > 0) {
+                    events()[i].atMicros += event.periodMicros;
+                } else {
+                    events().erase(events().begin() + i);
+                }
+                event.fn();
+                ran = true;
+                break;
+            }
+        }
+    }
+}
+
+}
+
+namespace Sim {
+
+uint64_t micros() {
+    // Reading the clock costs a little time, so busy-wait loops still terminate.
+    g_micros += 1;
+    return g_micros;
+}
+
+unsigned long millis() {
+    return (unsigned long)(micros() / 1000);
+}
+
+void advanceMicros(uint64_t us) {
+    advanceUntil(us, nullptr);
+}
+
+void advanceUntil(uint64_t us, std::function<bool()> stop) {
+    uint64_t target = g_micros + us;
+    // Step through pending events in order so their side effects land at the right time.
+    while (true) {
+        uint64_t next = target;
+        for (const Event& event : events()) {
+            if (event.atMicros < next) next = event.atMicros;
+        }
+        if (next > g_micros) g_micros = next;
+        runDueEvents();
+        if (g_micros >= target || (stop && stop())) break;
+    }
+}
+
+void at(unsigned long atMillis, std::function<void()> fn) {
+    events().push_back({(uint64_t)atMillis * 1000, 0, fn});
+}
+
+void every(unsigned long firstMillis, unsigned long periodMillis, std::function<void()> fn) {
+    events().push_back({(uint64_t)firstMillis * 1000, (uint64_t)periodMillis * 1000, fn});
+}
+
+void pinMode(int pin, int mode) {
+    Pin& p = pins()[pin];
+    p.mode = mode;
+    if (mode == INPUT_PULLUP) p.level = HIGH;
+}
+
+void setDigital(int pin, int level) {
+    Pin& p = pins()[pin];
+    if (p.level == level) return;
+    p.level = level;
+    if (p.isr && (p.isrMode == CHANGE || (p.isrMode == RISING && level == HIGH) || (p.isrMode == FALLING && level == LOW))) {
+        p.isr(p.isrArg);
+    }
+}
+
+int getDigital(int pin) {
+    return pins()[pin].level;
+}
+
+void writeDigital(int pin, int level) {
+    g_stats.digitalWrites++;
+    pins()[pin].level = level;
+}
+
+void setAnalog(int pin, int value) {
+    pins()[pin].analog = value;
+}
+
+int getAnalog(int pin) {
+    return pins()[pin].analog;
+}
+
+void setTouch(int pin, int value) {
+    pins()[pin].touch = value;
+}
+
+int getTouch(int pin) {
+    return pins()[pin].touch;
+}
+
+void writePwm(int pin, int duty) {
+    g_stats.analogWrites++;
+    pins()[pin].pwm = duty;
+}
+
+int getPwm(int pin) {
+    return pins()[pin].pwm;
+}
+
+void attachInterrupt(int pin, void (*fn)(void*), void* arg, int mode) {
+    Pin& p = pins()[pin];
+    p.isr = fn;
+    p.isrArg = arg;
+    p.isrMode = mode;
+}
+
+void detachInterrupt(int pin) {
+    pins()[pin].isr = nullptr;
+}
+
+void pressButton(int pin, unsigned long atMillis, unsigned long durationMs) {
+    at(atMillis, [pin]() { setDigital(pin, LOW); });
+    at(atMillis + durationMs, [pin]() { setDigital(pin, HIGH); });
+}
+
+std::vector<int> buttonPins() {
+    std::vector<int> list;
+    for (auto& entry : pins()) {
+        if (entry.second.mode == INPUT_PULLUP && entry.second.isr) list.push_back(entry.first);
+    }
+    return list;
+}
+
+void cutPowerAfterFsSteps(long steps) {
+    g_fsStepsLeft = steps;
+}
+
+size_t takeFsSteps(size_t steps) {
+    if (g_fsStepsLeft < 0) return steps;
+    size_t taken = steps < (size_t)g_fsStepsLeft ? steps : (size_t)g_fsStepsLeft;
+    g_fsStepsLeft -= taken;
+    return taken;
+}
+
+size_t heapSize() {
+    return g_heapSize;
+}
+
+void setHeapSize(size_t bytes) {
+    g_heapSize = bytes;
+}
+
+Stats& stats() {
+    return g_stats;
+}
+
+void printReport(unsigned long passes, uint64_t hostNanos, const char* endReason) {
+    double simSeconds = g_micros / 1e6;
+    printf("\n--- Native run report ---\n");
+    printf("Ended:              %s\n", endReason);
+    printf("Simulated time:     %.1f s\n", simSeconds);
+    printf("Loop passes:        %lu (%.2f per simulated second)\n", passes, simSeconds > 0 ? passes / simSeconds : 0.0);
+    printf("Host time per pass: %.2f us\n", passes > 0 ? hostNanos / 1000.0 / passes : 0.0);
+    printf("Time asleep:        %.1f %%\n", g_micros > 0 ? 100.0 * g_stats.sleptMicros / g_micros : 0.0);
+    printf("MQTT publishes:     %lu (%llu bytes, largest %zu, %lu streamed writes)\n", g_stats.mqttPublishes, (unsigned long long)g_stats.mqttBytes, g_stats.mqttLargestPayload, g_stats.mqttStreamWrites);
+    printf("MQTT per publish:   %.0f bytes, %.1f us host encode time\n",
+           g_stats.mqttPublishes > 0 ? (double)g_stats.mqttBytes / g_stats.mqttPublishes : 0.0,
+           g_stats.mqttPublishes > 0 ? g_stats.mqttEncodeNanos / 1000.0 / g_stats.mqttPublishes : 0.0);
+    printf("HTTP posts:         %lu (%llu bytes)\n", g_stats.httpPosts, (unsigned long long)g_stats.httpBytes);
+    printf("DNS / TCP:          %lu lookups, %lu connects\n", g_stats.dnsLookups, g_stats.tcpConnects);
+    printf("EEPROM commits:     %lu\n", g_stats.eepromCommits);
+    printf("Flash FS:           %lu opens, %llu bytes written\n", g_stats.fsOpens, (unsigned long long)g_stats.fsBytesWritten);
+    printf("NVS writes:         %lu (%llu bytes)\n", g_stats.nvsWrites, (unsigned long long)g_stats.nvsBytesWritten);
+    printf("GPIO writes:        %lu digital, %lu pwm\n", g_stats.digitalWrites, g_stats.analogWrites);
+    printf("Heap:               %zu bytes in use, %zu peak\n", g_stats.heapInUse, g_stats.heapPeak);
+}
+
+}
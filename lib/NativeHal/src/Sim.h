@@ -0,0 +1,101 @@
+#ifndef NATIVE_SIM_H
+#define NATIVE_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Simulated hardware behind the native HAL shim. All time is virtual: it only moves
+// forward when the firmware sleeps (delay) or reads the clock, so a run is deterministic
+// and an hour of firmware time takes a fraction of a second on the host.
+namespace Sim {
+
+// Thrown by ESP.restart() and deep sleep to end the current boot.
+struct Reset {
+    std::string reason;
+    uint64_t sleepMicros;
+};
+
+struct Stats {
+    unsigned long delayCalls = 0;
+    uint64_t sleptMicros = 0;
+    unsigned long digitalWrites = 0;
+    unsigned long analogWrites = 0;
+    unsigned long eepromCommits = 0;
+    unsigned long fsOpens = 0;
+    uint64_t fsBytesWritten = 0;
+    unsigned long nvsWrites = 0;
+    uint64_t nvsBytesWritten = 0;
+    unsigned long mqttConnects = 0;
+    unsigned long mqttPublishes = 0;
+    uint64_t mqttBytes = 0;
+    size_t mqttLargestPayload = 0;
+    unsigned long mqttStreamWrites = 0;
+    uint64_t mqttEncodeNanos = 0; // Host time between beginPublish() and endPublish()
+    unsigned long httpPosts = 0;
+    uint64_t httpBytes = 0;
+    unsigned long wifiConnects = 0;
+    unsigned long dnsLookups = 0;
+    unsigned long tcpConnects = 0;
+    size_t heapInUse = 0;
+    size_t heapPeak = 0;
+};
+
+// --- Virtual clock ---
+uint64_t micros();
+unsigned long millis();
+void advanceMicros(uint64_t us);
+// Like advanceMicros(), but returns as soon as stop() is true after an event has run, the way an
+// interrupt ends a sleep early.
+void advanceUntil(uint64_t us, std::function<bool()> stop);
+// Run fn once the virtual clock reaches atMillis.
+void at(unsigned long atMillis, std::function<void()> fn);
+// Run fn every periodMillis, starting at firstMillis.
+void every(unsigned long firstMillis, unsigned long periodMillis, std::function<void()> fn);
+
+// --- GPIO ---
+void pinMode(int pin, int mode);
+void setDigital(int pin, int level); // Drive an input from the outside (buttons).
+int getDigital(int pin);
+void writeDigital(int pin, int level); // Firmware side.
+void setAnalog(int pin, int value);
+int getAnalog(int pin);
+void setTouch(int pin, int value); // ESP32 touch pads; lower means touched.
+int getTouch(int pin);
+void writePwm(int pin, int duty);
+int getPwm(int pin);
+void attachInterrupt(int pin, void (*fn)(void*), void* arg, int mode);
+void detachInterrupt(int pin);
+// Simulate a button press on an active-low input: low for durationMs, starting at atMillis.
+void pressButton(int pin, unsigned long atMillis, unsigned long durationMs);
+// Active-low inputs with an interrupt attached, i.e. the buttons of the running config.
+std::vector<int> buttonPins();
+
+// --- OneWire ---
+// Every OneWire bus the firmware opens gets this many sensors unless it was populated explicitly.
+void setOneWireSensorsPerBus(int count);
+
+// --- Flash filesystem ---
+// Cuts the power after this many more filesystem steps: one per byte written, one per remove or
+// rename. The write that runs out stops part way and Sim::Reset{"power cut"} is thrown. A
+// negative count, the default, never cuts.
+void cutPowerAfterFsSteps(long steps);
+// Called by the filesystem before it changes anything: how many of the steps it may take.
+size_t takeFsSteps(size_t steps);
+
+// --- Heap accounting (fed by the global operator new/delete) ---
+size_t heapSize();
+void setHeapSize(size_t bytes);
+
+Stats& stats();
+void printReport(unsigned long passes, uint64_t hostNanos, const char* endReason);
+
+// Installs the default hardware used by every room config (I2C sensors, OneWire buses,
+// battery divider, reachable WiFi and broker).
+void installDefaultScenario();
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "SimI2CDevices.h"
+#include "Sim.h"
+#include <cmath>
+
+void SimRegisterDevice::receive(const uint8_t* data, size_t length) {
+    if (length == 0) return;
+    _pointer = data[0];
+    if (length >= 3) {
+        _registers[_pointer] = (uint16_t)((data[1] << 8) | data[2]);
+    } else if (length == 2) {
+        _registers[_pointer] = data[1];
+    }
+}
+
+size_t SimRegisterDevice::request(uint8_t* data, size_t length) {
+    uint16_t value = _registers[_pointer];
+    if (length >= 2) {
+        data[0] = value >> 8;
+        data[1] = value & 0xFF;
+        return 2;
+    }
+    if (length == 1) {
+        data[0] = value & 0xFF;
+        return 1;
+    }
+    return 0;
+}
+
+SimINA219::SimINA219() {
+    _registers[0x00] = 0x399F; // Power-on config
+}
+
+size_t SimINA219::request(uint8_t* data, size_t length) {
+    // Refresh the measurement registers from the simulated values before each read.
+    _registers[0x01] = (uint16_t)(int16_t)lroundf(shunt_mV * 100.0f);  // 10uV LSB
+    _registers[0x02] = (uint16_t)(lroundf(busVoltage_V * 250.0f) << 3); // 4mV LSB, bits 15..3
+    _registers[0x04] = (uint16_t)(int16_t)lroundf(current_mA / 2.0f);  // Arbitrary LSB for raw reads
+    return SimRegisterDevice::request(data, length);
+}
+
+uint8_t SimSHT31::crc8(const uint8_t* data, size_t length) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void SimSHT31::receive(const uint8_t* data, size_t length) {
+    if (length < 2) return;
+    uint16_t command = (uint16_t)((data[0] << 8) | data[1]);
+    if (command == 0x306D) heater = true;
+    if (command == 0x3066) heater = false;
+    if (command == 0x2400 || command == 0x2C06) _measured = true;
+}
+
+size_t SimSHT31::request(uint8_t* data, size_t length) {
+    if (!_measured || length < 6) return 0;
+    _measured = false;
+    uint16_t rawT = (uint16_t)lroundf((tempC + 45.0f) * 65535.0f / 175.0f);
+    uint16_t rawH = (uint16_t)lroundf(humidity * 65535.0f / 100.0f);
+    data[0] = rawT >> 8;
+    data[1] = rawT & 0xFF;
+    data[2] = crc8(data, 2);
+    data[3] = rawH >> 8;
+    data[4] = rawH & 0xFF;
+    data[5] = crc8(data + 3, 2);
+    return 6;
+}
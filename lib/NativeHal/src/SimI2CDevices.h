@@ -0,0 +1,53 @@
+#ifndef NATIVE_SIM_I2C_DEVICES_H
+#define NATIVE_SIM_I2C_DEVICES_H
+
+#include <stdint.h>
+#include "Wire.h"
+
+// Register-file device: the first written byte selects a register, following bytes
+// (big endian pairs) write it, reads return the selected register.
+class SimRegisterDevice : public SimI2CDevice {
+  protected:
+    uint16_t _registers[256] = {0};
+    uint8_t _pointer = 0;
+
+  public:
+    void receive(const uint8_t* data, size_t length) override;
+    size_t request(uint8_t* data, size_t length) override;
+    uint16_t reg(uint8_t index) const { return _registers[index]; }
+    void setReg(uint8_t index, uint16_t value) { _registers[index] = value; }
+};
+
+// INA219 current/voltage monitor.
+class SimINA219 : public SimRegisterDevice {
+  public:
+    float current_mA = 850.0f;
+    float busVoltage_V = 12.6f;
+    float shunt_mV = 8.5f;
+    SimINA219();
+    size_t request(uint8_t* data, size_t length) override;
+};
+
+// SHT31 temperature/humidity sensor answering single-shot measurement commands.
+class SimSHT31 : public SimI2CDevice {
+  private:
+    bool _measured = false;
+
+  public:
+    float tempC = 21.3f;
+    float humidity = 44.0f;
+    bool heater = false;
+    void receive(const uint8_t* data, size_t length) override;
+    size_t request(uint8_t* data, size_t length) override;
+    static uint8_t crc8(const uint8_t* data, size_t length);
+};
+
+// BME280 environmental sensor. The Adafruit_BME280 shim reads the values directly.
+class SimBME280 : public SimRegisterDevice {
+  public:
+    float tempC = 18.4f;
+    float humidity = 61.0f;
+    float pressure_hPa = 1009.2f;
+};
+
+#endif
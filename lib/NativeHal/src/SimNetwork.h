@@ -0,0 +1,43 @@
+#ifndef NATIVE_SIM_NETWORK_H
+#define NATIVE_SIM_NETWORK_H
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include "IPAddress.h"
+
+namespace Sim {
+
+// The simulated access point, broker and HTTP endpoint.
+struct Network {
+    bool apReachable = true;
+    unsigned long fullConnectMs = 2500; // Scan + association + DHCP
+    unsigned long fastConnectMs = 350;  // Known BSSID/channel, static IP
+    int rssi = -62;
+    int channel = 6;
+    uint8_t bssid[6] = {0x02, 0x00, 0x5E, 0x10, 0x20, 0x30};
+    IPAddress localIp = IPAddress(192, 168, 1, 50);
+    IPAddress gateway = IPAddress(192, 168, 1, 1);
+    IPAddress subnet = IPAddress(255, 255, 255, 0);
+    IPAddress dns = IPAddress(192, 168, 1, 1);
+    IPAddress serverIp = IPAddress(192, 168, 1, 10);
+    unsigned long dnsLookupMs = 20;
+    unsigned long tcpConnectMs = 5;
+    bool brokerUp = true;
+    // The next this many streamed MQTT writes fail, like a socket that stalls mid-publish.
+    int failedStreamWrites = 0;
+    bool httpUp = true;
+    std::string httpResponse = "{}";
+    // Delivered to the device's JSON command topic right after it subscribes (empty = none).
+    std::string commandOnSubscribe;
+    // Called for every MQTT publish; lets a scenario inspect or capture payloads.
+    std::function<void(const std::string& topic, const uint8_t* payload, size_t length)> onPublish;
+    // Deliver an inbound MQTT message to the firmware (set by the PubSubClient shim).
+    std::function<void(const std::string& topic, const uint8_t* payload, size_t length)> deliver;
+};
+
+Network& network();
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "Sim.h"
+#include "Arduino.h"
+#include "SimI2CDevices.h"
+#include "Wire.h"
+
+namespace {
+
+SimINA219 g_loadMeter;
+SimINA219 g_chargeMeter;
+SimSHT31 g_sht31;
+SimBME280 g_bme280;
+
+#ifdef ESP32
+// The room configs map A0 to GPIO34. 1333 of 4095 is 12.6V behind the woodshed divider.
+const int BATTERY_PIN = 34;
+const int BATTERY_RAW = 1333;
+#else
+const int BATTERY_PIN = A0;
+const int BATTERY_RAW = 1023;
+#endif
+
+}
+
+namespace Sim {
+
+void installDefaultScenario() {
+    // I2C sensors at the addresses the configs use.
+    g_chargeMeter.current_mA = 2400.0f;
+    g_chargeMeter.shunt_mV = 18.0f;
+    g_chargeMeter.busVoltage_V = 13.4f;
+    TwoWire::attach(0x40, &g_loadMeter);
+    TwoWire::attach(0x41, &g_chargeMeter);
+    TwoWire::attach(0x44, &g_sht31);
+    TwoWire::attach(0x76, &g_bme280);
+
+    // Two DS18B20s on every OneWire bus, so shared-bus behaviour shows up in every config.
+    setOneWireSensorsPerBus(2);
+
+    setAnalog(BATTERY_PIN, BATTERY_RAW);
+
+    // Slow drift so readings and published values change over time.
+    every(60000, 60000, []() {
+        g_sht31.tempC += 0.1f;
+        g_bme280.pressure_hPa -= 0.05f;
+        g_loadMeter.current_mA = g_loadMeter.current_mA > 1500.0f ? 850.0f : g_loadMeter.current_mA + 50.0f;
+    });
+
+    // Exercise the buttons: a short press every 5 minutes and a 2s hold every 15 minutes.
+    // Buttons attach their interrupts in begin(), so they are looked up once the run is going.
+    every(30000, 300000, []() {
+        for (int pin : buttonPins()) pressButton(pin, millis() + 1, 150);
+    });
+    every(450000, 900000, []() {
+        for (int pin : buttonPins()) pressButton(pin, millis() + 1, 2000);
+    });
+}
+
+}
@@ -0,0 +1,131 @@
+#include "WString.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 16) base = 10;
+    if (value == 0) return "0";
+    std::string out;
+    while (value > 0) {
+        out += "0123456789abcdef"[value % base];
+        value /= base;
+    }
+    std::reverse(out.begin(), out.end());
+    return out;
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    if (value < 0 && base == DEC) {
+        return "-" + formatUnsigned((unsigned long long)(-value), base);
+    }
+    return formatUnsigned((unsigned long long)value, base);
+}
+
+static std::string formatFloat(double value, unsigned char decimals) {
+    if (std::isnan(value)) return "nan";
+    if (std::isinf(value)) return "inf";
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return buffer;
+}
+
+String::String(int value, unsigned char base) : _s(base == DEC ? formatSigned(value, base) : formatUnsigned((unsigned int)value, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+String::String(long value, unsigned char base) : _s(base == DEC ? formatSigned(value, base) : formatUnsigned((unsigned long)value, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+String::String(long long value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+String::String(float value, unsigned char decimals) : _s(formatFloat(value, decimals)) {}
+String::String(double value, unsigned char decimals) : _s(formatFloat(value, decimals)) {}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    if (_s.length() != s._s.length()) return false;
+    for (size_t i = 0; i < _s.length(); i++) {
+        if (tolower((unsigned char)_s[i]) != tolower((unsigned char)s._s[i])) return false;
+    }
+    return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+    if (suffix._s.length() > _s.length()) return false;
+    return _s.compare(_s.length() - suffix._s.length(), suffix._s.length(), suffix._s) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = _s.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+    size_t pos = _s.find(s._s, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+    size_t pos = _s.rfind(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const {
+    if (from >= _s.length()) return String();
+    return String(_s.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.length()) return String();
+    return String(_s.substr(from, to - from));
+}
+
+long String::toInt() const {
+    return strtol(_s.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+    return strtof(_s.c_str(), nullptr);
+}
+
+void String::toLowerCase() {
+    for (auto& c : _s) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (auto& c : _s) c = toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t begin = _s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        _s.clear();
+        return;
+    }
+    size_t end = _s.find_last_not_of(" \t\r\n");
+    _s = _s.substr(begin, end - begin + 1);
+}
+
+void String::replace(const String& from, const String& to) {
+    if (from._s.empty()) return;
+    size_t pos = 0;
+    while ((pos = _s.find(from._s, pos)) != std::string::npos) {
+        _s.replace(pos, from._s.length(), to._s);
+        pos += to._s.length();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index >= _s.length()) return;
+    _s.erase(index, count);
+}
+
+void String::toCharArray(char* buffer, unsigned int size, unsigned int index) const {
+    if (!buffer || size == 0) return;
+    size_t n = 0;
+    if (index < _s.length()) {
+        n = std::min((size_t)size - 1, _s.length() - index);
+        _s.copy(buffer, n, index);
+    }
+    buffer[n] = 0;
+}
@@ -0,0 +1,97 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <stddef.h>
+#include <string>
+
+#define HEX 16
+#define DEC 10
+#define OCT 8
+#define BIN 2
+
+// Host stand-in for the Arduino String class, backed by std::string.
+class String {
+  private:
+    std::string _s;
+
+  public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    String(const String& s) = default;
+    String(String&& s) = default;
+    explicit String(char c) : _s(1, c) {}
+    explicit String(int value, unsigned char base = DEC);
+    explicit String(unsigned int value, unsigned char base = DEC);
+    explicit String(long value, unsigned char base = DEC);
+    explicit String(unsigned long value, unsigned char base = DEC);
+    explicit String(long long value, unsigned char base = DEC);
+    explicit String(unsigned long long value, unsigned char base = DEC);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+
+    String& operator=(const String& s) = default;
+    String& operator=(String&& s) = default;
+    String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    char charAt(unsigned int index) const { return index < _s.length() ? _s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _s[index]; }
+
+    bool concat(const String& s) { _s += s._s; return true; }
+    bool concat(const char* s) { if (s) _s += s; return true; }
+    bool concat(const char* s, unsigned int length) { if (s) _s.append(s, length); return true; }
+    bool concat(char c) { _s += c; return true; }
+    bool concat(int v) { return concat(String(v)); }
+    bool concat(unsigned int v) { return concat(String(v)); }
+    bool concat(long v) { return concat(String(v)); }
+    bool concat(unsigned long v) { return concat(String(v)); }
+    bool concat(float v) { return concat(String(v)); }
+    bool concat(double v) { return concat(String(v)); }
+
+    template <typename T>
+    String& operator+=(const T& v) { concat(v); return *this; }
+
+    bool equals(const String& s) const { return _s == s._s; }
+    bool equals(const char* s) const { return _s == (s ? s : ""); }
+    bool equalsIgnoreCase(const String& s) const;
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.length(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const;
+    int compareTo(const String& s) const { return _s.compare(s._s); }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& s, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+
+    long toInt() const;
+    float toFloat() const;
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+    void replace(const String& from, const String& to);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const;
+
+    const std::string& str() const { return _s; }
+};
+
+inline bool operator==(const String& a, const String& b) { return a.equals(b); }
+inline bool operator==(const String& a, const char* b) { return a.equals(b); }
+inline bool operator==(const char* a, const String& b) { return b.equals(a); }
+inline bool operator!=(const String& a, const String& b) { return !a.equals(b); }
+inline bool operator!=(const String& a, const char* b) { return !a.equals(b); }
+inline bool operator!=(const char* a, const String& b) { return !b.equals(a); }
+inline bool operator<(const String& a, const String& b) { return a.compareTo(b) < 0; }
+
+inline String operator+(const String& a, const String& b) { String r(a); r.concat(b); return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r.concat(b); return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r.concat(b); return r; }
+inline String operator+(const String& a, char b) { String r(a); r.concat(b); return r; }
+
+#endif
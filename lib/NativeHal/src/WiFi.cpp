@@ -0,0 +1,155 @@
+#include "WiFi.h"
+#include "Sim.h"
+#include "SimNetwork.h"
+#include <cstdio>
+
+WiFiClass WiFi;
+
+namespace Sim {
+Network& network() {
+    static Network net;
+    return net;
+}
+}
+
+bool IPAddress::fromString(const char* address) {
+    unsigned int a, b, c, d;
+    char tail;
+    if (!address || sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) return false;
+    if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+    *this = IPAddress(a, b, c, d);
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _octets[0], _octets[1], _octets[2], _octets[3]);
+    return String(buffer);
+}
+
+void WiFiClass::_poll() {
+    if (_connecting && millis() >= _connectedAt) {
+        _connecting = false;
+        _status = Sim::network().apReachable ? WL_CONNECTED : WL_NO_SSID_AVAIL;
+        if (_status == WL_CONNECTED) Sim::stats().wifiConnects++;
+    }
+    if (_status == WL_CONNECTED && !Sim::network().apReachable) {
+        _status = WL_DISCONNECTED;
+    }
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password, int32_t channel, const uint8_t* bssid, bool connect) {
+    (void)ssid;
+    (void)password;
+    Sim::Network& net = Sim::network();
+    // A correct channel/BSSID hint skips the scan; a static IP skips DHCP.
+    bool hinted = bssid && channel == net.channel && memcmp(bssid, net.bssid, 6) == 0;
+    unsigned long duration = net.fullConnectMs;
+    if (hinted) duration = _staticIp ? net.fastConnectMs : (net.fastConnectMs + net.fullConnectMs) / 2;
+    _status = WL_DISCONNECTED;
+    _connecting = connect;
+    _connectedAt = millis() + duration;
+    if (bssid) memcpy(_bssid, bssid, 6);
+    _channel = channel;
+    return _status;
+}
+
+bool WiFiClass::config(IPAddress localIp, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2) {
+    (void)gateway;
+    (void)subnet;
+    (void)dns1;
+    (void)dns2;
+    _staticIp = localIp.isSet();
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+    (void)wifiOff;
+    _status = WL_DISCONNECTED;
+    _connecting = false;
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    begin(nullptr);
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    _poll();
+    return _status;
+}
+
+IPAddress WiFiClass::localIP() {
+    return status() == WL_CONNECTED ? Sim::network().localIp : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    return status() == WL_CONNECTED ? Sim::network().gateway : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask() {
+    return status() == WL_CONNECTED ? Sim::network().subnet : IPAddress();
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t index) {
+    (void)index;
+    return status() == WL_CONNECTED ? Sim::network().dns : IPAddress();
+}
+
+int32_t WiFiClass::RSSI() {
+    return status() == WL_CONNECTED ? Sim::network().rssi : 0;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    if (status() == WL_CONNECTED) memcpy(_bssid, Sim::network().bssid, 6);
+    return _bssid;
+}
+
+int32_t WiFiClass::channel() {
+    return status() == WL_CONNECTED ? Sim::network().channel : _channel;
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    (void)host;
+    if (status() != WL_CONNECTED) return 0;
+    Sim::stats().dnsLookups++;
+    Sim::advanceMicros((uint64_t)Sim::network().dnsLookupMs * 1000);
+    result = Sim::network().serverIp;
+    return 1;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    (void)ip;
+    if (WiFi.status() != WL_CONNECTED) return 0;
+    Sim::stats().tcpConnects++;
+    Sim::advanceMicros((uint64_t)Sim::network().tcpConnectMs * 1000);
+    _connected = true;
+    _port = port;
+    return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) return 0;
+    return connect(ip, port);
+}
+
+uint8_t WiFiClient::connected() {
+    if (_connected && WiFi.status() != WL_CONNECTED) _connected = false;
+    return _connected;
+}
+
+void WiFiClient::stop() {
+    _connected = false;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+    return connected() ? 1 : 0;
+    (void)c;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    (void)buffer;
+    return connected() ? size : 0;
+}
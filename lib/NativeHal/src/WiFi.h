@@ -0,0 +1,62 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <stdint.h>
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } WiFiMode_t;
+#ifndef ESP32
+typedef enum { WIFI_NONE_SLEEP = 0, WIFI_LIGHT_SLEEP = 1, WIFI_MODEM_SLEEP = 2 } WiFiSleepType_t;
+typedef WiFiSleepType_t WiFiSleepType;
+#endif
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+  private:
+    wl_status_t _status = WL_DISCONNECTED;
+    unsigned long _connectedAt = 0;
+    bool _connecting = false;
+    bool _staticIp = false;
+    uint8_t _bssid[6] = {0};
+    int32_t _channel = 0;
+
+    void _poll();
+
+  public:
+    bool mode(WiFiMode_t mode) { (void)mode; return true; }
+    wl_status_t begin(const char* ssid, const char* password = nullptr, int32_t channel = 0, const uint8_t* bssid = nullptr, bool connect = true);
+    bool config(IPAddress localIp, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress());
+    bool disconnect(bool wifiOff = false);
+    bool reconnect();
+    wl_status_t status();
+    bool isConnected() { return status() == WL_CONNECTED; }
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    int32_t RSSI();
+    uint8_t* BSSID();
+    int32_t channel();
+#ifndef ESP32
+    bool setSleepMode(WiFiSleepType_t type) { (void)type; return true; }
+#endif
+    bool setSleep(bool enable) { (void)enable; return true; }
+    bool setAutoReconnect(bool enable) { (void)enable; return true; }
+    void persistent(bool enable) { (void)enable; }
+    bool forceSleepBegin() { disconnect(); return true; }
+    bool forceSleepWake() { return true; }
+    int hostByName(const char* host, IPAddress& result);
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef NATIVE_WIFI_CLIENT_H
+#define NATIVE_WIFI_CLIENT_H
+
+#include <stdint.h>
+#include <string>
+#include "Print.h"
+#include "IPAddress.h"
+
+// TCP client against the simulated network. Data written is collected so the HTTP and
+// MQTT shims can account for it; there is no real socket.
+class WiFiClient : public Stream {
+  private:
+    bool _connected = false;
+    uint16_t _port = 0;
+
+  public:
+    virtual ~WiFiClient() {}
+    virtual int connect(IPAddress ip, uint16_t port);
+    virtual int connect(const char* host, uint16_t port);
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) { (void)timeoutMs; return connect(ip, port); }
+    int connect(const char* host, uint16_t port, int32_t timeoutMs) { (void)timeoutMs; return connect(host, port); }
+    virtual uint8_t connected();
+    virtual void stop();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void setNoDelay(bool noDelay) { (void)noDelay; }
+    uint16_t remotePort() const { return _port; }
+    operator bool() { return connected(); }
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "Wire.h"
+#include <map>
+
+TwoWire Wire;
+
+static std::map<uint8_t, SimI2CDevice*>& devices() {
+    static std::map<uint8_t, SimI2CDevice*> map;
+    return map;
+}
+
+void TwoWire::attach(uint8_t address, SimI2CDevice* device) {
+    devices()[address] = device;
+}
+
+void TwoWire::detach(uint8_t address) {
+    devices().erase(address);
+}
+
+SimI2CDevice* TwoWire::device(uint8_t address) {
+    auto it = devices().find(address);
+    return it == devices().end() ? nullptr : it->second;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _address = address;
+    _txBuffer.clear();
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    SimI2CDevice* target = device(_address);
+    if (!target) return 2; // NACK on address
+    if (!_txBuffer.empty()) target->receive(_txBuffer.data(), _txBuffer.size());
+    _txBuffer.clear();
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop) {
+    (void)sendStop;
+    _rxBuffer.clear();
+    _rxIndex = 0;
+    SimI2CDevice* target = device(address);
+    if (!target) return 0;
+    _rxBuffer.resize(quantity);
+    _rxBuffer.resize(target->request(_rxBuffer.data(), quantity));
+    return (uint8_t)_rxBuffer.size();
+}
+
+size_t TwoWire::write(uint8_t data) {
+    _txBuffer.push_back(data);
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+    _txBuffer.insert(_txBuffer.end(), data, data + quantity);
+    return quantity;
+}
+
+int TwoWire::available() {
+    return (int)(_rxBuffer.size() - _rxIndex);
+}
+
+int TwoWire::read() {
+    return _rxIndex < _rxBuffer.size() ? _rxBuffer[_rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+    return _rxIndex < _rxBuffer.size() ? _rxBuffer[_rxIndex] : -1;
+}
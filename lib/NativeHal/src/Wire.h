@@ -0,0 +1,50 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "Print.h"
+
+// A simulated device on the I2C bus. receive() gets each write transaction,
+// request() fills the bytes for a read transaction.
+class SimI2CDevice {
+  public:
+    virtual ~SimI2CDevice() {}
+    virtual void receive(const uint8_t* data, size_t length) = 0;
+    virtual size_t request(uint8_t* data, size_t length) = 0;
+};
+
+class TwoWire : public Stream {
+  private:
+    uint8_t _address = 0;
+    std::vector<uint8_t> _txBuffer;
+    std::vector<uint8_t> _rxBuffer;
+    size_t _rxIndex = 0;
+
+  public:
+    static void attach(uint8_t address, SimI2CDevice* device);
+    static void detach(uint8_t address);
+    static SimI2CDevice* device(uint8_t address);
+
+    bool begin() { return true; }
+    bool begin(int sda, int scl) { (void)sda; (void)scl; return true; }
+    void setClock(uint32_t frequency) { (void)frequency; }
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t quantity) override;
+    using Print::write;
+    size_t write(int data) { return write((uint8_t)data); }
+    size_t write(unsigned int data) { return write((uint8_t)data); }
+    size_t write(long data) { return write((uint8_t)data); }
+    size_t write(unsigned long data) { return write((uint8_t)data); }
+    int available() override;
+    int read() override;
+    int peek() override;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef NATIVE_COREDECLS_H
+#define NATIVE_COREDECLS_H
+
+// ESP8266 core (3.x) internals used to suspend the loop until an interrupt resumes it.
+
+#include <stdint.h>
+#include "Sim.h"
+
+// Resumes the loop task suspended in esp_delay(). Safe to call from an interrupt handler.
+void esp_schedule();
+
+// Suspends the loop for up to timeoutMs, returning early once blocked() is false after the loop
+// was resumed by esp_schedule().
+template <typename T>
+inline void esp_delay(const uint32_t timeoutMs, T&& blocked) {
+    uint64_t start = Sim::micros();
+    Sim::advanceUntil((uint64_t)timeoutMs * 1000, [&]() { return !blocked(); });
+    Sim::stats().delayCalls++;
+    Sim::stats().sleptMicros += Sim::micros() - start;
+}
+
+#endif
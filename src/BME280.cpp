@@ -1,8 +1,17 @@
 #include "BME280.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 #include "Logger.h"
+#include <Wire.h>
+
+// ctrl_meas register: temperature and pressure oversampling x1, forced mode. Writing it starts
+// one conversion, which takes at most 9.3ms with x1 oversampling on all three channels.
+static const uint8_t BME280_REG_CTRL_MEAS = 0xF4;
+static const uint8_t BME280_CTRL_MEAS_FORCED_X1 = 0x25;
+static const unsigned long BME280_CONVERSION_TIME = 10;
 
 BME280Reader::BME280Reader(String name, uint8_t address, unsigned long interval, int eepromOffset) 
-    : _name(name), _address(address), _interval(interval), _lastUpdateTime(0), _lastReconnectAttempt(0), _eepromOffset(eepromOffset),
+    : _name(name), _address(address), _interval(interval), _lastUpdateTime(0), _lastReconnectAttempt(0), _measurementPending(false), _eepromOffset(eepromOffset),
       _temperature(NAN), _humidity(NAN), _pressure(NAN),
       _tempOffset(0.0), _humOffset(0.0), _pressOffset(0.0),
       _tempSum(0), _humSum(0), _pressSum(0), _readingsCount(0), _available(false) {
@@ -29,6 +38,7 @@ void BME280Reader::begin() {
 
     if (found) {
         _available = true;
+        _configureForcedMode();
         Log.info(("BME280 " + _name + " found at 0x" + String(_address, HEX)).c_str());
     } else {
         Log.error(("BME280 " + _name + " not found").c_str());
@@ -40,7 +50,7 @@ void BME280Reader::begin() {
 
 void BME280Reader::loadConfig() {
     Config config;
-    EEPROM.get(_eepromOffset, config);
+    Settings.get(_eepromOffset, config);
     // Magic number to validate EEPROM data
     if (config.magic == 0xCAFE2801) {
         if (config.interval >= 1000) {
@@ -54,9 +64,17 @@ void BME280Reader::loadConfig() {
 
 void BME280Reader::saveConfig() {
     if (_eepromOffset < 0) return;
-    Config config = { _interval, _tempOffset, _humOffset, _pressOffset, 0xCAFE2801 };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Config config = { (uint32_t)_interval, _tempOffset, _humOffset, _pressOffset, 0xCAFE2801 };
+    Settings.put(_eepromOffset, config);
+}
+
+void BME280Reader::_configureForcedMode() {
+    // Sleep between readings; each startMeasurement() triggers a single forced conversion.
+    _bme.setSampling(Adafruit_BME280::MODE_FORCED,
+                     Adafruit_BME280::SAMPLING_X1,
+                     Adafruit_BME280::SAMPLING_X1,
+                     Adafruit_BME280::SAMPLING_X1,
+                     Adafruit_BME280::FILTER_OFF);
 }
 
 void BME280Reader::update() {
@@ -65,37 +83,80 @@ void BME280Reader::update() {
             _lastReconnectAttempt = millis();
             if (_bme.begin(_address)) {
                 _available = true;
+                _configureForcedMode();
                 Log.info(("BME280 " + _name + " is available again.").c_str());
             }
         }
         return;
     }
 
-    if (millis() - _lastUpdateTime >= _interval) {
-        _lastUpdateTime = millis();
-        
-        float t = _bme.readTemperature();
-        float p = _bme.readPressure() / 100.0F; // Convert Pa to hPa
-        float h = _bme.readHumidity();
-
-        if (!isnan(t) && !isnan(p) && !isnan(h)) {
-            t += _tempOffset;
-            h += _humOffset;
-            p += _pressOffset;
-
-            _temperature = t;
-            _pressure = p;
-            _humidity = h;
-            _tempSum += t;
-            _pressSum += p;
-            _humSum += h;
-            _readingsCount++;
-        } else {
-            Log.warn(("BME280 " + _name + " reading failed. Marking as unavailable.").c_str());
-            _available = false;
-            _lastReconnectAttempt = millis();
+    if (_measurementPending) {
+        if (millis() - _lastUpdateTime >= BME280_CONVERSION_TIME) {
+            collectMeasurement();
         }
+        return;
+    }
+
+    if (millis() - _lastUpdateTime >= _interval) {
+        startMeasurement();
+    }
+}
+
+bool BME280Reader::startMeasurement() {
+    // takeForcedMeasurement() would poll until the conversion is done, so write ctrl_meas directly.
+    _lastUpdateTime = millis();
+    Wire.beginTransmission(_address);
+    Wire.write(BME280_REG_CTRL_MEAS);
+    Wire.write(BME280_CTRL_MEAS_FORCED_X1);
+    _measurementPending = (Wire.endTransmission() == 0);
+
+    if (!_measurementPending) {
+        Log.warn(("BME280 " + _name + " did not accept measurement. Marking as unavailable.").c_str());
+        _available = false;
+        _lastReconnectAttempt = millis();
+    }
+    return _measurementPending;
+}
+
+void BME280Reader::collectMeasurement() {
+    _measurementPending = false;
+
+    // The result registers hold the finished conversion; reading them doesn't start a new one.
+    float t = _bme.readTemperature();
+    float p = _bme.readPressure() / 100.0F; // Convert Pa to hPa
+    float h = _bme.readHumidity();
+
+    if (!isnan(t) && !isnan(p) && !isnan(h)) {
+        t += _tempOffset;
+        h += _humOffset;
+        p += _pressOffset;
+
+        _temperature = t;
+        _pressure = p;
+        _humidity = h;
+        _tempSum += t;
+        _pressSum += p;
+        _humSum += h;
+        _readingsCount++;
+    } else {
+        Log.warn(("BME280 " + _name + " reading failed. Marking as unavailable.").c_str());
+        _available = false;
+        _lastReconnectAttempt = millis();
+    }
+}
+
+bool BME280Reader::measurementPending() {
+    return _measurementPending;
+}
+
+unsigned long BME280Reader::getUpdateDelay() {
+    if (!_available) {
+        return timeUntil(_lastReconnectAttempt, 120000);
+    }
+    if (_measurementPending) {
+        return timeUntil(_lastUpdateTime, BME280_CONVERSION_TIME);
     }
+    return timeUntil(_lastUpdateTime, _interval);
 }
 
 void BME280Reader::addToJson(JsonArray& doc) {
@@ -104,11 +165,7 @@ void BME280Reader::addToJson(JsonArray& doc) {
     nested["subtype"] = "BME280";
     nested["name"] = _name;
     nested["available"] = _available;
-    nested["interval"] = _interval;
     
-    nested["tempCOffset"] = serialized(String(_tempOffset, 2));
-    nested["humOffset"] = serialized(String(_humOffset, 2));
-    nested["pressOffset"] = serialized(String(_pressOffset, 2));
 
     if (_available) {
         float t = _temperature;
@@ -130,34 +187,100 @@ void BME280Reader::addToJson(JsonArray& doc) {
     }
 }
 
-void BME280Reader::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
-        bool changed = false;
+uint32_t BME280Reader::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(_available);
+    fp.add(getConfigFingerprint());
+    // The averages addToJson() would publish, without resetting them.
+    bool averaged = _readingsCount > 0;
+    fp.add(averaged ? _tempSum / _readingsCount : _temperature, 0.1f);
+    fp.add(averaged ? _humSum / _readingsCount : _humidity, 1.0f);
+    fp.add(averaged ? _pressSum / _readingsCount : _pressure, 0.5f);
+    return fp.value();
+}
 
-        if (config.containsKey("setInterval")) {
-            unsigned long newInterval = config["setInterval"].as<unsigned long>();
-            if (newInterval >= 1000 && newInterval != _interval) {
-                _interval = newInterval;
-                changed = true;
-            }
-        }
+void BME280Reader::addConfigToJson(JsonObject& nested) {
+    nested["interval"] = _interval;
+    setFixed(nested, "tempCOffset", _tempOffset, 2);
+    setFixed(nested, "humOffset", _humOffset, 2);
+    setFixed(nested, "pressOffset", _pressOffset, 2);
+}
 
-        if (config.containsKey("setTempCOffset")) {
-            _tempOffset = config["setTempCOffset"].as<float>();
-            changed = true;
-        }
-        if (config.containsKey("setHumOffset")) {
-            _humOffset = config["setHumOffset"].as<float>();
-            changed = true;
-        }
-        if (config.containsKey("setPressOffset")) {
-            _pressOffset = config["setPressOffset"].as<float>();
+uint32_t BME280Reader::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_interval);
+    fp.add(_tempOffset, 0.01f);
+    fp.add(_humOffset, 0.01f);
+    fp.add(_pressOffset, 0.01f);
+    return fp.value();
+}
+
+void BME280Reader::processCommand(JsonObject& config) {
+    bool changed = false;
+
+    if (config.containsKey("setInterval")) {
+        unsigned long newInterval = config["setInterval"].as<unsigned long>();
+        if (newInterval >= 1000 && newInterval != _interval) {
+            _interval = newInterval;
             changed = true;
         }
+    }
 
-        if (changed) saveConfig();
+    if (config.containsKey("setTempCOffset")) {
+        _tempOffset = config["setTempCOffset"].as<float>();
+        changed = true;
+    }
+    if (config.containsKey("setHumOffset")) {
+        _humOffset = config["setHumOffset"].as<float>();
+        changed = true;
     }
+    if (config.containsKey("setPressOffset")) {
+        _pressOffset = config["setPressOffset"].as<float>();
+        changed = true;
+    }
+
+    if (changed) saveConfig();
+}
+
+// The averages published with the exchange span the duty-cycle sleeps in between.
+struct BME280SleepState {
+    float temperature;
+    float humidity;
+    float pressure;
+    float tempSum;
+    float humSum;
+    float pressSum;
+    int readingsCount;
+};
+
+size_t BME280Reader::saveSleepState(uint8_t* buffer, size_t capacity) {
+    BME280SleepState state = { _temperature, _humidity, _pressure, _tempSum, _humSum, _pressSum, _readingsCount };
+    if (capacity < sizeof(state)) return 0;
+    memcpy(buffer, &state, sizeof(state));
+    return sizeof(state);
+}
+
+void BME280Reader::restoreSleepState(const uint8_t* buffer, size_t length) {
+    BME280SleepState state;
+    if (length != sizeof(state)) return;
+    memcpy(&state, buffer, sizeof(state));
+    _temperature = state.temperature;
+    _humidity = state.humidity;
+    _pressure = state.pressure;
+    _tempSum = state.tempSum;
+    _humSum = state.humSum;
+    _pressSum = state.pressSum;
+    _readingsCount = state.readingsCount;
+}
+
+int BME280Reader::getSampleCount() {
+    return 3;
+}
+
+void BME280Reader::getSamples(float* values) {
+    values[0] = _available ? _temperature : NAN;
+    values[1] = _available ? _humidity : NAN;
+    values[2] = _available ? _pressure : NAN;
 }
 
 const String& BME280Reader::getName() {
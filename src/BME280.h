@@ -5,7 +5,6 @@
 #include <Adafruit_Sensor.h>
 #include <Adafruit_BME280.h>
 #include "Device.h"
-#include <EEPROM.h>
 
 class BME280Reader : public Device {
     private:
@@ -15,6 +14,7 @@ class BME280Reader : public Device {
         unsigned long _interval;
         unsigned long _lastUpdateTime;
         unsigned long _lastReconnectAttempt;
+        bool _measurementPending;
         int _eepromOffset;
         
         float _temperature;
@@ -29,23 +29,35 @@ class BME280Reader : public Device {
         int _readingsCount;
         bool _available;
 
+        void loadConfig();
+        void saveConfig();
+        void _configureForcedMode();
+
+    public:
         struct Config {
-            unsigned long interval;
+            uint32_t interval;
             float tempOffset;
             float humOffset;
             float pressOffset;
             uint32_t magic;
         };
 
-        void loadConfig();
-        void saveConfig();
-
-    public:
         BME280Reader(String name, uint8_t address = 0x76, unsigned long interval = 60000, int eepromOffset = -1);
         void begin() override;
         void update() override;
+        unsigned long getUpdateDelay() override;
+        bool startMeasurement() override;
+        void collectMeasurement() override;
+        bool measurementPending() override;
         void addToJson(JsonArray& doc) override;
-        void processJson(JsonObject& doc) override;
+        uint32_t getStateFingerprint() override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
+        void processCommand(JsonObject& command) override;
+        size_t saveSleepState(uint8_t* buffer, size_t capacity) override;
+        void restoreSleepState(const uint8_t* buffer, size_t length) override;
+        int getSampleCount() override;
+        void getSamples(float* values) override;
         const String& getName() override;
 };
 
@@ -1,22 +1,12 @@
 #include <Arduino.h>
 #include "BatteryMonitor.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 #include "DS18B20.h"
 #include <ArduinoJson.h>
-#include <EEPROM.h>
 #include "Logger.h"
 #include <vector>
 
-struct BatteryConfig {
-    float low;
-    float critical;
-    int bufferSize;
-    float adjustment;
-    float temperature;
-    float batteryVoltage;
-    char batteryType[20];
-    uint32_t magic;
-};
-
 // Constructor.
 BatteryMonitor::BatteryMonitor(String name, int pin, float ratio, float lowThreshold, float criticalThreshold, int eepromOffset, int readingsBufferSize, DS18B20* tempReader, float temperature) 
     : _pin(pin), _eepromOffset(eepromOffset), _name(name), _ratio(ratio), _lowThreshold(lowThreshold), _criticalThreshold(criticalThreshold),
@@ -45,8 +35,8 @@ void BatteryMonitor::begin() {
 }
 
 void BatteryMonitor::loadConfig() {
-    BatteryConfig config;
-    EEPROM.get(_eepromOffset, config);
+    Config config;
+    Settings.get(_eepromOffset, config);
     
     // Check for magic number (0xCAFEBABE) to verify valid data exists
     if (config.magic == 0xCAFEBABE) {
@@ -76,11 +66,10 @@ void BatteryMonitor::loadConfig() {
 }
 
 void BatteryMonitor::saveConfig() {
-    BatteryConfig config = { _lowThreshold, _criticalThreshold, _readingsBufferSize, _voltageSensorAdjustmentFactor, _temperature, _batteryVoltage, "", 0xCAFEBABE };
+    Config config = { _lowThreshold, _criticalThreshold, _readingsBufferSize, _voltageSensorAdjustmentFactor, _temperature, _batteryVoltage, "", 0xCAFEBABE };
     strncpy(config.batteryType, _batteryType.c_str(), sizeof(config.batteryType) - 1);
     config.batteryType[sizeof(config.batteryType) - 1] = 0;
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Settings.put(_eepromOffset, config);
 }
 
 float BatteryMonitor::applyAdjustment(float voltage, bool reverse) {
@@ -180,6 +169,10 @@ void BatteryMonitor::update() {
     }
 }
 
+unsigned long BatteryMonitor::getUpdateDelay() {
+    return timeUntil(_lastReadingTime, 900);
+}
+
 float BatteryMonitor::getVoltage() {
     if (_smoothedVoltage < 0) {
         return 0.0;
@@ -223,18 +216,12 @@ void BatteryMonitor::addToJson(JsonArray& doc) {
     nested["type"] = "System";
     nested["subtype"] = "BatteryMonitor";
     nested["name"] = _name;
-    nested["bufferSize"] = _readingsBufferSize;
     
     if (voltage > 0) {
-        nested["voltage"] = serialized(String(voltage, 2));
-        nested["voltageRaw"] = serialized(String(applyAdjustment(voltage, true), 2));
-
-        nested["thresholdLow"] = serialized(String(_lowThreshold, 2));
-        nested["thresholdCritical"] = serialized(String(_criticalThreshold, 2));
-        nested["adjustment"] = serialized(String(_voltageSensorAdjustmentFactor, 3));
-        nested["temperature"] = serialized(String(_temperature, 2));
-        nested["batteryType"] = _batteryType;
-        nested["batteryVoltage"] = serialized(String(_batteryVoltage, 2));
+        setFixed(nested, "voltage", voltage, 2);
+        setFixed(nested, "voltageRaw", applyAdjustment(voltage, true), 2);
+
+        setFixed(nested, "temperature", _temperature, 2);
         nested["isLow"] = isLow();
         nested["isCritical"] = isCritical();
         nested["isBuffering"] = false;
@@ -243,40 +230,106 @@ void BatteryMonitor::addToJson(JsonArray& doc) {
         nested["isBuffering"] = true;
         nested["raw"] = raw;
         float momentary = rawToVoltage(raw);
-        nested["momentary"] = serialized(String(applyAdjustment(momentary), 2));
+        setFixed(nested, "momentary", applyAdjustment(momentary), 2);
     }
 }
 
-void BatteryMonitor::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
-        if (config.containsKey("setLow")) {
-            _lowThreshold = config["setLow"].as<float>();
-        }
-        if (config.containsKey("setCritical")) {
-            _criticalThreshold = config["setCritical"].as<float>();
-        }
-        if (config.containsKey("setBufferSize")) {
-            int newSize = config["setBufferSize"].as<int>();
-            if (newSize > 0 && newSize != _readingsBufferSize) {
-                _readingsBufferSize = newSize;
-                _alpha = 2.0 / (_readingsBufferSize + 1.0);
-            }
-        }
-        if (config.containsKey("setAdjustment")) {
-            _voltageSensorAdjustmentFactor = config["setAdjustment"].as<float>();
-        }
-        if (config.containsKey("setTemperature")) {
-            _temperature = config["setTemperature"].as<float>();
-        }
-        if (config.containsKey("setBatteryType")) {
-            _batteryType = config["setBatteryType"].as<String>();
-        }
-        if (config.containsKey("setBatteryVoltage")) {
-            _batteryVoltage = config["setBatteryVoltage"].as<float>();
+uint32_t BatteryMonitor::getStateFingerprint() {
+    float voltage = getVoltage();
+    if (voltage <= 0) {
+        // Still buffering: the raw reading is published on every exchange.
+        return 0;
+    }
+
+    StateFingerprint fp;
+    fp.add(getConfigFingerprint());
+    fp.add(voltage, 0.05f);
+    fp.add(_temperature, 0.5f);
+    fp.add(isLow());
+    fp.add(isCritical());
+    return fp.value();
+}
+
+void BatteryMonitor::addConfigToJson(JsonObject& nested) {
+    nested["bufferSize"] = _readingsBufferSize;
+    setFixed(nested, "thresholdLow", _lowThreshold, 2);
+    setFixed(nested, "thresholdCritical", _criticalThreshold, 2);
+    setFixed(nested, "adjustment", _voltageSensorAdjustmentFactor, 3);
+    nested["batteryType"] = _batteryType;
+    setFixed(nested, "batteryVoltage", _batteryVoltage, 2);
+}
+
+uint32_t BatteryMonitor::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_readingsBufferSize);
+    fp.add(_lowThreshold, 0.01f);
+    fp.add(_criticalThreshold, 0.01f);
+    fp.add(_voltageSensorAdjustmentFactor, 0.001f);
+    fp.add(_batteryType);
+    fp.add(_batteryVoltage, 0.01f);
+    return fp.value();
+}
+
+void BatteryMonitor::processCommand(JsonObject& config) {
+    if (config.containsKey("setLow")) {
+        _lowThreshold = config["setLow"].as<float>();
+    }
+    if (config.containsKey("setCritical")) {
+        _criticalThreshold = config["setCritical"].as<float>();
+    }
+    if (config.containsKey("setBufferSize")) {
+        int newSize = config["setBufferSize"].as<int>();
+        if (newSize > 0 && newSize != _readingsBufferSize) {
+            _readingsBufferSize = newSize;
+            _alpha = 2.0 / (_readingsBufferSize + 1.0);
         }
-        saveConfig();
     }
+    if (config.containsKey("setAdjustment")) {
+        _voltageSensorAdjustmentFactor = config["setAdjustment"].as<float>();
+    }
+    if (config.containsKey("setTemperature")) {
+        _temperature = config["setTemperature"].as<float>();
+    }
+    if (config.containsKey("setBatteryType")) {
+        _batteryType = config["setBatteryType"].as<String>();
+    }
+    if (config.containsKey("setBatteryVoltage")) {
+        _batteryVoltage = config["setBatteryVoltage"].as<float>();
+    }
+    saveConfig();
+}
+
+// The filter would otherwise start over from a single reading on every duty-cycle wake.
+struct BatterySleepState {
+    float smoothedVoltage;
+    float temperature;
+    bool lowState;
+    bool criticalState;
+};
+
+size_t BatteryMonitor::saveSleepState(uint8_t* buffer, size_t capacity) {
+    BatterySleepState state = { _smoothedVoltage, _temperature, _lowState, _criticalState };
+    if (capacity < sizeof(state)) return 0;
+    memcpy(buffer, &state, sizeof(state));
+    return sizeof(state);
+}
+
+void BatteryMonitor::restoreSleepState(const uint8_t* buffer, size_t length) {
+    BatterySleepState state;
+    if (length != sizeof(state)) return;
+    memcpy(&state, buffer, sizeof(state));
+    _smoothedVoltage = state.smoothedVoltage;
+    _temperature = state.temperature;
+    _lowState = state.lowState;
+    _criticalState = state.criticalState;
+}
+
+int BatteryMonitor::getSampleCount() {
+    return 1;
+}
+
+void BatteryMonitor::getSamples(float* values) {
+    values[0] = _smoothedVoltage < 0 ? NAN : _smoothedVoltage;
 }
 
 const String& BatteryMonitor::getName() {
@@ -37,9 +37,21 @@ class BatteryMonitor : public Device {
     float rawToVoltage(int raw);
 
   public:
+    struct Config {
+        float low;
+        float critical;
+        int bufferSize;
+        float adjustment;
+        float temperature;
+        float batteryVoltage;
+        char batteryType[20];
+        uint32_t magic;
+    };
+
     BatteryMonitor(String name, int pin, float ratio, float lowThreshold, float criticalThreshold, int eepromOffset, int readingsBufferSize, DS18B20* tempReader = nullptr, float temperature = 25.0);
     void begin();
     void update();
+    unsigned long getUpdateDelay() override;
     float getVoltage();
     bool batteryIsConnected();
     bool isLow();
@@ -47,7 +59,14 @@ class BatteryMonitor : public Device {
     bool gotLow();
     bool gotCritical();
     void addToJson(JsonArray& doc) override;
-    void processJson(JsonObject& doc) override;
+    uint32_t getStateFingerprint() override;
+    void addConfigToJson(JsonObject& nested) override;
+    uint32_t getConfigFingerprint() override;
+    void processCommand(JsonObject& command) override;
+    size_t saveSleepState(uint8_t* buffer, size_t capacity) override;
+    void restoreSleepState(const uint8_t* buffer, size_t length) override;
+    int getSampleCount() override;
+    void getSamples(float* values) override;
     const String& getName();
 };
 
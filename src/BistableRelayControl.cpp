@@ -1,13 +1,14 @@
 #include "BistableRelayControl.h"
-#include <EEPROM.h>
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 
-struct BistableRelayConfig {
-    unsigned long autoOffTimer;
-    uint32_t magic;
-};
+// 100ms pulse to latch/unlatch the relay
+static const unsigned long PULSE_DURATION = 100;
 
-BistableRelayControl::BistableRelayControl(String name, int pinOn, int pinOff, int eepromOffset) 
-    : DeviceControl(name), pinOn(pinOn), pinOff(pinOff), _isOn(false), _autoOffTimer(0), _turnOnTime(0), _eepromOffset(eepromOffset) {
+PulseSequencer BistableRelayControl::_sequencer;
+
+BistableRelayControl::BistableRelayControl(String name, int pinOn, int pinOff, int eepromOffset, int rail) 
+    : DeviceControl(name), pinOn(pinOn), pinOff(pinOff), _isOn(false), _autoOffTimer(0), _turnOnTime(0), _eepromOffset(eepromOffset), _rail(rail), _lastPulseId(0) {
     pinMode(pinOn, OUTPUT);
     pinMode(pinOff, OUTPUT);
     
@@ -23,8 +24,8 @@ void BistableRelayControl::begin() {
 }
 
 void BistableRelayControl::loadConfig() {
-    BistableRelayConfig config;
-    EEPROM.get(_eepromOffset, config);
+    Config config;
+    Settings.get(_eepromOffset, config);
     
     if (config.magic == 0xCAFEBABE) {
         _autoOffTimer = config.autoOffTimer;
@@ -33,28 +34,32 @@ void BistableRelayControl::loadConfig() {
 
 void BistableRelayControl::saveConfig() {
     if (_eepromOffset < 0) return;
-    BistableRelayConfig config = { _autoOffTimer, 0xCAFEBABE };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Config config = { (uint32_t)_autoOffTimer, 0xCAFEBABE };
+    Settings.put(_eepromOffset, config);
+}
+
+void BistableRelayControl::_pulse(int pin) {
+    // The state changes right away; the coil pulse follows once the rail is free.
+    _lastPulseId = _sequencer.enqueue(pin, _rail, PULSE_DURATION);
 }
 
 void BistableRelayControl::turnOn() {
     if (pinOn == pinOff && _isOn) return;
-    digitalWrite(pinOn, HIGH);
-    delay(100); // 100ms pulse to latch the relay
-    digitalWrite(pinOn, LOW);
+    _pulse(pinOn);
     _isOn = true;
     _turnOnTime = millis();
 }
 
 void BistableRelayControl::turnOff() {
     if (pinOn == pinOff && !_isOn) return;
-    digitalWrite(pinOff, HIGH);
-    delay(100); // 100ms pulse to unlatch the relay
-    digitalWrite(pinOff, LOW);
+    _pulse(pinOff);
     _isOn = false;
 }
 
+bool BistableRelayControl::isPulsePending() {
+    return _lastPulseId != 0 && _sequencer.isPending(_lastPulseId);
+}
+
 void BistableRelayControl::toggle() {
     if (isOn()) {
         turnOff();
@@ -78,32 +83,44 @@ void BistableRelayControl::setAutoOffTimer(unsigned long duration) {
     }
 }
 
+bool BistableRelayControl::pulsesPending() {
+    return _sequencer.hasPending();
+}
+
+void BistableRelayControl::finishPulses() {
+    _sequencer.finish();
+}
+
 void BistableRelayControl::update() {
+    _sequencer.update();
+
     if (_isOn && _autoOffTimer > 0 && (millis() - _turnOnTime >= _autoOffTimer)) {
         turnOff();
     }
 }
 
-void BistableRelayControl::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        if (doc[_name].is<JsonObject>()) {
-            JsonObject command = doc[_name].as<JsonObject>();
-
-            if (command.containsKey("toggleState") && command["toggleState"].as<bool>()) {
-                toggle();
-            }
-            if (command.containsKey("setState") && command["setState"].is<bool>()) {
-                // Only act if setState is explicitly true or false, ignore null/string/etc.
-                bool state = command["setState"].as<bool>();
-                state ? turnOn() : turnOff();
-            }
-            if (command.containsKey("toggleInternalState") && command["toggleInternalState"].as<bool>()) {
-                toggleInternalState();
-            }
-            if (command.containsKey("setAutoOffTimer")) {
-                setAutoOffTimer(command["setAutoOffTimer"].as<unsigned long>());
-            }
-        }
+unsigned long BistableRelayControl::getUpdateDelay() {
+    unsigned long next = _sequencer.getUpdateDelay();
+    if (_isOn && _autoOffTimer > 0) {
+        next = min(next, timeUntil(_turnOnTime, _autoOffTimer));
+    }
+    return next;
+}
+
+void BistableRelayControl::processCommand(JsonObject& command) {
+    if (command.containsKey("toggleState") && command["toggleState"].as<bool>()) {
+        toggle();
+    }
+    if (command.containsKey("setState") && command["setState"].is<bool>()) {
+        // Only act if setState is explicitly true or false, ignore null/string/etc.
+        bool state = command["setState"].as<bool>();
+        state ? turnOn() : turnOff();
+    }
+    if (command.containsKey("toggleInternalState") && command["toggleInternalState"].as<bool>()) {
+        toggleInternalState();
+    }
+    if (command.containsKey("setAutoOffTimer")) {
+        setAutoOffTimer(command["setAutoOffTimer"].as<unsigned long>());
     }
 }
 
@@ -113,7 +130,10 @@ void BistableRelayControl::addToJson(JsonArray& doc) {
     nested["subtype"] = "BistableRelayControl";
     nested["name"] = _name;
     nested["isOn"] = isOn();
-    nested["autoOffTimer"] = _autoOffTimer;
+    // A pulse is confirmed once the coil has been driven for the full pulse duration.
+    bool pending = isPulsePending();
+    nested["pulsePending"] = pending;
+    nested["pulseConfirmed"] = _lastPulseId != 0 && !pending;
 
     unsigned long remaining = 0;
     if (_isOn && _autoOffTimer > 0) {
@@ -125,6 +145,31 @@ void BistableRelayControl::addToJson(JsonArray& doc) {
     nested["autoOffRemaining"] = remaining;
 }
 
+uint32_t BistableRelayControl::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(isOn());
+    fp.add(getConfigFingerprint());
+    fp.add(isPulsePending());
+    fp.add(_lastPulseId);
+    // The auto-off countdown only counts as a change once per minute.
+    if (_isOn && _autoOffTimer > 0) {
+        fp.add(timeUntil(_turnOnTime, _autoOffTimer) / 60000UL);
+    }
+    return fp.value();
+}
+
+void BistableRelayControl::addConfigToJson(JsonObject& nested) {
+    nested["autoOffTimer"] = _autoOffTimer;
+    nested["rail"] = _rail;
+}
+
+uint32_t BistableRelayControl::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_autoOffTimer);
+    fp.add(_rail);
+    return fp.value();
+}
+
 const String& BistableRelayControl::getName() {
     return _name;
 }
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "DeviceControl.h"
+#include "PulseSequencer.h"
 
 class BistableRelayControl : public DeviceControl {
     private:
@@ -12,10 +13,21 @@ class BistableRelayControl : public DeviceControl {
         unsigned long _autoOffTimer;
         unsigned long _turnOnTime;
         int _eepromOffset;
+        int _rail;
+        unsigned long _lastPulseId;
+
+        // Shared by all latching relays so pulses on the same supply rail never overlap.
+        static PulseSequencer _sequencer;
 
     public:
+        struct Config {
+            uint32_t autoOffTimer;
+            uint32_t magic;
+        };
+
         // Works for both single pin and dual pin bistable relays.
-        BistableRelayControl(String name, int pinOn, int pinOff, int eepromOffset = -1);
+        // Relays on the same rail share a coil supply and are pulsed one at a time.
+        BistableRelayControl(String name, int pinOn, int pinOff, int eepromOffset = -1, int rail = 0);
         void begin();
         void turnOn() override;
         void turnOff() override;
@@ -23,14 +35,24 @@ class BistableRelayControl : public DeviceControl {
         void toggleInternalState();
         bool isOn() override;
         void setAutoOffTimer(unsigned long duration);
+        bool isPulsePending();
+        // Pulses of any latching relay that have not run yet. The state a relay reports only
+        // holds once they have, so the chip must not sleep or restart before.
+        static bool pulsesPending();
+        static void finishPulses();
         void update();
-        void processJson(JsonObject& doc) override;
+        unsigned long getUpdateDelay() override;
+        void processCommand(JsonObject& command) override;
         void addToJson(JsonArray& doc) override;
+        uint32_t getStateFingerprint() override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
         const String& getName();
 
     private:
         void loadConfig();
         void saveConfig();
+        void _pulse(int pin);
 };
 
 #endif
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "CapacitiveSensor.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 
 // Magic number for EEPROM config validation
 #define CAP_SENSOR_MAGIC 0xCAFECA01
@@ -61,6 +63,10 @@ void CapacitiveSensor::update() {
     }
 }
 
+unsigned long CapacitiveSensor::getUpdateDelay() {
+    return timeUntil(_lastUpdateTime, _interval);
+}
+
 int CapacitiveSensor::_readSensor() {
     #ifdef ESP32
         // ESP32 has built-in touch sensors
@@ -95,51 +101,69 @@ void CapacitiveSensor::addToJson(JsonArray& doc) {
     nested["type"] = "Sensor";
     nested["subtype"] = "Capacitive";
     nested["name"] = _name;
+    setFixed(nested, "value", _lastAverageValue, 2);
+    nested["isTouched"] = _isTouched;
+}
+
+uint32_t CapacitiveSensor::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(getConfigFingerprint());
+    fp.add(_isTouched);
+    // Raw touch values wander by a few counts; a tenth of the threshold is a real change.
+    fp.add(_lastAverageValue, _threshold > 10 ? _threshold / 10.0f : 1.0f);
+    return fp.value();
+}
+
+void CapacitiveSensor::addConfigToJson(JsonObject& nested) {
     nested["pin"] = _pin;
     nested["threshold"] = _threshold;
-    nested["value"] = serialized(String(_lastAverageValue, 2));
-    nested["isTouched"] = _isTouched;
     nested["interval"] = _interval;
     nested["triggerOnStateChange"] = _triggerOnStateChange;
 }
 
-void CapacitiveSensor::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
-        bool changed = false;
+uint32_t CapacitiveSensor::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_pin);
+    fp.add(_threshold);
+    fp.add(_interval);
+    fp.add(_triggerOnStateChange);
+    return fp.value();
+}
 
-        if (config.containsKey("setThreshold")) {
-            int newThreshold = config["setThreshold"].as<int>();
-            if (newThreshold > 0 && newThreshold != _threshold) {
-                _threshold = newThreshold;
-                changed = true;
-                Log.info(("CapacitiveSensor " + _name + " threshold updated to " + String(_threshold)).c_str());
-            }
+void CapacitiveSensor::processCommand(JsonObject& config) {
+    bool changed = false;
+
+    if (config.containsKey("setThreshold")) {
+        int newThreshold = config["setThreshold"].as<int>();
+        if (newThreshold > 0 && newThreshold != _threshold) {
+            _threshold = newThreshold;
+            changed = true;
+            Log.info(("CapacitiveSensor " + _name + " threshold updated to " + String(_threshold)).c_str());
         }
-        if (config.containsKey("setInterval")) {
-            unsigned long newInterval = config["setInterval"].as<unsigned long>();
-            if (newInterval >= 50 && newInterval != _interval) { // Minimum interval to avoid excessive reads
-                _interval = newInterval;
-                changed = true;
-                Log.info(("CapacitiveSensor " + _name + " interval updated to " + String(_interval)).c_str());
-            }
+    }
+    if (config.containsKey("setInterval")) {
+        unsigned long newInterval = config["setInterval"].as<unsigned long>();
+        if (newInterval >= 50 && newInterval != _interval) { // Minimum interval to avoid excessive reads
+            _interval = newInterval;
+            changed = true;
+            Log.info(("CapacitiveSensor " + _name + " interval updated to " + String(_interval)).c_str());
         }
-        if (config.containsKey("setTriggerOnStateChange")) {
-            bool newTrigger = config["setTriggerOnStateChange"].as<bool>();
-            if (newTrigger != _triggerOnStateChange) {
-                _triggerOnStateChange = newTrigger;
-                changed = true;
-                Log.info(("CapacitiveSensor " + _name + " triggerOnStateChange updated to " + String(_triggerOnStateChange)).c_str());
-            }
+    }
+    if (config.containsKey("setTriggerOnStateChange")) {
+        bool newTrigger = config["setTriggerOnStateChange"].as<bool>();
+        if (newTrigger != _triggerOnStateChange) {
+            _triggerOnStateChange = newTrigger;
+            changed = true;
+            Log.info(("CapacitiveSensor " + _name + " triggerOnStateChange updated to " + String(_triggerOnStateChange)).c_str());
         }
-
-        if (changed) saveConfig();
     }
+
+    if (changed) saveConfig();
 }
 
 void CapacitiveSensor::loadConfig() {
     Config config = {false, 50, 0}; // Default values for safety
-    EEPROM.get(_eepromOffset, config);
+    Settings.get(_eepromOffset, config);
     if (config.magic == CAP_SENSOR_MAGIC) {
         _threshold = config.threshold;
         _triggerOnStateChange = config.triggerOnStateChange;
@@ -149,8 +173,7 @@ void CapacitiveSensor::loadConfig() {
 void CapacitiveSensor::saveConfig() {
     if (_eepromOffset < 0) return;
     Config config = { _triggerOnStateChange, _threshold, CAP_SENSOR_MAGIC };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Settings.put(_eepromOffset, config);
 }
 
 const String& CapacitiveSensor::getName() {
@@ -4,7 +4,6 @@
 #include <Arduino.h>
 #include "Device.h"
 #include "Logger.h" // For logging
-#include <EEPROM.h> // For saving/loading config
 #include <vector>
 
 class CapacitiveSensor : public Device {
@@ -27,6 +26,11 @@ private:
     static const int BUFFER_SIZE = 300;
     static const int BURST_SIZE = 15;
 
+    void loadConfig();
+    void saveConfig();
+    int _readSensor(); // Helper to read raw sensor value
+    
+public:
     // EEPROM configuration structure
     struct Config {
         bool triggerOnStateChange;
@@ -34,16 +38,15 @@ private:
         uint32_t magic;
     };
 
-    void loadConfig();
-    void saveConfig();
-    int _readSensor(); // Helper to read raw sensor value
-    
-public:
     CapacitiveSensor(String name, int pin, int threshold = 50, unsigned long interval = 100, bool triggerOnStateChange = true, int eepromOffset = -1);
     void begin() override;
     void update() override;
+    unsigned long getUpdateDelay() override;
     void addToJson(JsonArray& doc) override;
-    void processJson(JsonObject& doc) override;
+    uint32_t getStateFingerprint() override;
+    void addConfigToJson(JsonObject& nested) override;
+    uint32_t getConfigFingerprint() override;
+    void processCommand(JsonObject& command) override;
     const String& getName() override;
 
     float getAverage();
@@ -0,0 +1,35 @@
+#ifndef CONFIG_BACKEND_H
+#define CONFIG_BACKEND_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+
+// A device's config record in the image: what one Settings.put() wrote.
+struct ConfigRecord {
+    uint16_t offset;
+    uint16_t length;
+};
+
+// Where ConfigStore persists its image. The store keeps the image in RAM and hands the backend
+// the records that changed since the last commit.
+class ConfigBackend {
+    public:
+        virtual ~ConfigBackend() {}
+        virtual const char* getName() = 0;
+        // Prepares the storage; false if it is not available on this node.
+        virtual bool begin(size_t size) = 0;
+        // Fills the image from the storage. False if it holds no config yet (first boot).
+        virtual bool load(std::vector<uint8_t>& image) = 0;
+        // Persists the given records of the image.
+        virtual bool commit(const std::vector<uint8_t>& image, const std::vector<ConfigRecord>& records) = 0;
+        // Replaces the stored config with the whole image (after a migration).
+        virtual bool store(const std::vector<uint8_t>& image) = 0;
+        // Releases a backend that was only read from during a migration.
+        virtual void end() {}
+        // Housekeeping between commits.
+        virtual void update(const std::vector<uint8_t>& image) {}
+        virtual void addToJson(JsonObject& nested) {}
+};
+
+#endif
\ No newline at end of file
@@ -4,21 +4,33 @@
 
 #ifdef CONFIG_FURNACE_CLOSET
 
+// --- EEPROM ---
+enum EepromRecord { EE_EXCHANGER, EE_FURNACE, EE_FAN, EE_TEMP, EE_WIFI };
+// Records from before the layout stay where deployed nodes have them.
+using Layout = EepromLayout<EepromAt<2, DataExchanger::Config>, EepromAt<300, RelayControl::Config>, EepromAt<400, RelayControl::Config>, EepromAt<500, DS18B20::Config>, WifiLinkCache>;
+const size_t EEPROM_SIZE = Layout::size();
+
 // --- Identity ---
 const char* DEVICE_ID = "furnace_closet_01";
 // Using GPIO 2 (Built-in LED on NodeMCU) for status indication
-DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, 2);
+DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, Layout::offset<EE_EXCHANGER, DataExchanger::Config>());
 
 // --- Devices ---
 static SystemMonitor sysMon("systemMonitor", DEVICE_ID);
 
 // Relay Control on Pins 26, 25
 // Parameters: name, pin, activeLow, pwm, frequency, eepromOffset
-static RelayControl furnaceRelay("furnace", 26, true, false, 1000, 300);
-static RelayControl fanRelay("fan", 25, true, false, 1000, 400);
+static RelayControl furnaceRelay("furnace", 26, true, false, 1000, Layout::offset<EE_FURNACE, RelayControl::Config>());
+static RelayControl fanRelay("fan", 25, true, false, 1000, Layout::offset<EE_FAN, RelayControl::Config>());
 // Temperature Reader on 19
-static DS18B20 temp1(19, "recroom", 0, 500);
+static DS18B20 temp1(19, "recroom", 0, Layout::offset<EE_TEMP, DS18B20::Config>());
 
+// --- Device table ---
+using Devices = DeviceTable<
+    DeviceEntry<sysMon, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<furnaceRelay, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<fanRelay, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<temp1, ROLE_DEVICE | ROLE_PROVIDER>>;
 
 void setupConfiguration() {
     // 1. Assign specific pointers for main loop logic
@@ -27,23 +39,11 @@ void setupConfiguration() {
     statusIndicator = nullptr;
 
     // 2. Configure wiring
+    wifi.setEepromOffset(Layout::offset<EE_WIFI, WifiLinkCache>());
     // No local relay targets for these buttons in this config
 
-    // 3. Populate generic device list (for update loop)
-    allDevices.push_back(&sysMon);
-    allDevices.push_back(&furnaceRelay);
-    allDevices.push_back(&fanRelay);
-    allDevices.push_back(&temp1);
-
-    // 4. Populate switchable list
-    switchableDevices.push_back(&furnaceRelay);
-    switchableDevices.push_back(&fanRelay);
-
-    // 5. Register providers to DataExchanger
-    dataExchanger.addProvider(&sysMon);
-    dataExchanger.addProvider(&furnaceRelay);
-    dataExchanger.addProvider(&fanRelay);
-    dataExchanger.addProvider(&temp1);
+    // 3. Install the device lists and register the providers
+    Devices::install(allDevices, switchableDevices, dataExchanger);
 }
 
 #endif
\ No newline at end of file
@@ -5,18 +5,30 @@
 #ifdef CONFIG_KITCHEN
 
 // This is an ESP32 configuration.
+// --- EEPROM ---
+enum EepromRecord { EE_EXCHANGER, EE_TEMP_KITCHEN, EE_COUNTER_LIGHTS, EE_WIFI };
+// Records from before the layout stay where deployed nodes have them.
+using Layout = EepromLayout<EepromAt<2, DataExchanger::Config>, EepromAt<300, DS18B20::Config>, EepromAt<310, RelayControl::Config>, WifiLinkCache>;
+const size_t EEPROM_SIZE = Layout::size();
+
 // --- Identity ---
 const char* DEVICE_ID = "kitchen_01";
-DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, 2);
+DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, Layout::offset<EE_EXCHANGER, DataExchanger::Config>());
 
 // --- Devices ---
 static SystemMonitor sysMon("systemMonitor", DEVICE_ID);
 
 // 1 Temperature Reader on D25
-static DS18B20 tempKitchen(25, "tempKitchen", 0, 300);
+static DS18B20 tempKitchen(25, "tempKitchen", 0, Layout::offset<EE_TEMP_KITCHEN, DS18B20::Config>());
 
 // 2 PWM Relays
-static RelayControl counterLights("counterLights", std::vector<int>{D7, 21}, false, true, 1000, 310); // D7 is GPIO19 on ESP32
+static RelayControl counterLights("counterLights", std::vector<int>{D7, 21}, false, true, 1000, Layout::offset<EE_COUNTER_LIGHTS, RelayControl::Config>()); // D7 is GPIO19 on ESP32
+
+// --- Device table ---
+using Devices = DeviceTable<
+    DeviceEntry<sysMon, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<tempKitchen, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<counterLights, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>>;
 
 void setupConfiguration() {
     // 1. Assign specific pointers for main loop logic
@@ -25,19 +37,11 @@ void setupConfiguration() {
     statusIndicator = nullptr;
 
     // 2. Configure wiring
+    wifi.setEepromOffset(Layout::offset<EE_WIFI, WifiLinkCache>());
     // No local relay targets for these buttons in this config
 
-    // 3. Populate generic device list (for update loop)
-    allDevices.push_back(&sysMon);
-    allDevices.push_back(&tempKitchen);
-    allDevices.push_back(&counterLights);
-
-    switchableDevices.push_back(&counterLights);
-
-    // 4. Register providers to DataExchanger
-    dataExchanger.addProvider(&sysMon);
-    dataExchanger.addProvider(&tempKitchen);
-    dataExchanger.addProvider(&counterLights);
+    // 3. Install the device lists and register the providers
+    Devices::install(allDevices, switchableDevices, dataExchanger);
 }
 
 #endif
\ No newline at end of file
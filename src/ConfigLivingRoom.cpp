@@ -8,10 +8,16 @@
 
 #ifdef CONFIG_LIVINGROOM
 
+// --- EEPROM ---
+enum EepromRecord { EE_EXCHANGER, EE_SHT, EE_RGB_STRIP, EE_WIFI };
+// Records from before the layout stay where deployed nodes have them.
+using Layout = EepromLayout<EepromAt<2, DataExchanger::Config>, EepromAt<400, SHT31::Config>, EepromAt<300, RGBControl::Config>, WifiLinkCache>;
+const size_t EEPROM_SIZE = Layout::size();
+
 // --- Identity ---
 const char* DEVICE_ID = "livingroom_01";
 // Using GPIO 2 (Built-in LED on NodeMCU) for status indication
-DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, 2);
+DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, Layout::offset<EE_EXCHANGER, DataExchanger::Config>());
 
 // --- Devices ---
 static SystemMonitor sysMon("systemMonitor", DEVICE_ID);
@@ -23,15 +29,23 @@ static PushButtonMonitor btn1("btn1", D3, true);
 //static DS18B20 temp1(D5, "temp1", 0, 430);
 
 // SHT31 Sensor (I2C: D2=SDA, D1=SCL)
-static SHT31 shtSensor("shtSensor", 0x44, 60000, 400);
+static SHT31 shtSensor("shtSensor", 0x44, 60000, Layout::offset<EE_SHT, SHT31::Config>());
 
 // RGB Strip (D8, D6, D7) - Moved Red to D8 to free D1/D2 for I2C
 // Note: D8 (GPIO15) has a built-in pulldown on NodeMCU. D6 & D7 need external 10k pulldowns.
-static RGBControl rgbStrip("woodRackLights", D8, D6, D7, false, 1000, 300);
+static RGBControl rgbStrip("woodRackLights", D8, D6, D7, false, 1000, Layout::offset<EE_RGB_STRIP, RGBControl::Config>());
 
 // Status LED (Built-in LED is usually GPIO 2, Active Low)
 static RelayControl statusLed("statusLed", 2, true);
 
+// --- Device table ---
+using Devices = DeviceTable<
+    DeviceEntry<sysMon, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<btn1, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<shtSensor, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<rgbStrip, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<statusLed, ROLE_DEVICE | ROLE_PROVIDER>>;
+
 void setupConfiguration() {
     // Assign specific pointers for main loop logic
     systemMonitor = &sysMon;
@@ -39,26 +53,14 @@ void setupConfiguration() {
     statusIndicator = &statusLed;
 
     // Configure wiring
+    wifi.setEepromOffset(Layout::offset<EE_WIFI, WifiLinkCache>());
     btn1.setTarget(&rgbStrip);
 
     // Initialize I2C on D2 (SDA) and D1 (SCL)
     Wire.begin(D2, D1);
 
-    // Populate generic device list (for update loop)
-    allDevices.push_back(&sysMon);
-    allDevices.push_back(&btn1);
-    allDevices.push_back(&shtSensor);
-    allDevices.push_back(&rgbStrip);
-    allDevices.push_back(&statusLed);
-
-    switchableDevices.push_back(&rgbStrip);
-
-    // Register providers to DataExchanger
-    dataExchanger.addProvider(&sysMon);
-    dataExchanger.addProvider(&btn1);
-    dataExchanger.addProvider(&shtSensor);
-    dataExchanger.addProvider(&rgbStrip);
-    dataExchanger.addProvider(&statusLed);
+    // Install the device lists and register the providers
+    Devices::install(allDevices, switchableDevices, dataExchanger);
 }
 
 #endif
\ No newline at end of file
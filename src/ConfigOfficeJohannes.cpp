@@ -7,22 +7,37 @@
 #ifdef CONFIG_OFFICE_JOHANNES
 
 // This is an ESP32 configuration.
+
+// --- EEPROM ---
+enum EepromRecord { EE_EXCHANGER, EE_SHT, EE_TANK_SENSOR, EE_WIFI };
+// Records from before the layout stay where deployed nodes have them.
+using Layout = EepromLayout<EepromAt<2, DataExchanger::Config>, EepromAt<400, SHT31::Config>, EepromAt<450, CapacitiveSensor::Config>, WifiLinkCache>;
+const size_t EEPROM_SIZE = Layout::size();
+
 // --- Identity ---
 const char* DEVICE_ID = "office_johannes_01";
-DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, 2);
+DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, Layout::offset<EE_EXCHANGER, DataExchanger::Config>());
 
 // --- Devices ---
 static SystemMonitor sysMon("systemMonitor", DEVICE_ID);
 
 // SHT31 Sensor (I2C: SDA=21, SCL=22)
-static SHT31 shtSensor("shtSensor", 0x44, 60000, 400);
+static SHT31 shtSensor("shtSensor", 0x44, 60000, Layout::offset<EE_SHT, SHT31::Config>());
 
 // Relay Control on D5
 static RelayControl humidifier("humidifier", D5, true);
 static RelayControl fan("fan", 27, true);
 
 // Capacitive Sensor on D1 (GPIO4) - ESP32 Touch Pin T0
-static CapacitiveSensor capacitiveSensor("humidifierTank", D1, 50, 100, false, 450); // Example threshold 50, interval 100ms, triggerOnStateChange=true, EEPROM offset 450
+static CapacitiveSensor capacitiveSensor("humidifierTank", D1, 50, 100, false, Layout::offset<EE_TANK_SENSOR, CapacitiveSensor::Config>()); // Example threshold 50, interval 100ms, triggerOnStateChange=false
+
+// --- Device table ---
+using Devices = DeviceTable<
+    DeviceEntry<sysMon, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<shtSensor, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<humidifier, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<fan, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<capacitiveSensor, ROLE_DEVICE | ROLE_PROVIDER>>;
 
 void setupConfiguration() {
     // 1. Assign specific pointers for main loop logic
@@ -31,25 +46,12 @@ void setupConfiguration() {
     statusIndicator = nullptr;
 
     // 2. Configure wiring
+    wifi.setEepromOffset(Layout::offset<EE_WIFI, WifiLinkCache>());
     // Initialize I2C on ESP32 pins (SDA=21, SCL=22)
     Wire.begin(21, 22);
 
-    // 3. Populate generic device list (for update loop)
-    allDevices.push_back(&sysMon);
-    allDevices.push_back(&shtSensor);
-    allDevices.push_back(&humidifier);
-    allDevices.push_back(&fan);
-    allDevices.push_back(&capacitiveSensor); // Add new sensor
-
-    switchableDevices.push_back(&humidifier);
-    switchableDevices.push_back(&fan);
-
-    // 4. Register providers to DataExchanger
-    dataExchanger.addProvider(&sysMon);
-    dataExchanger.addProvider(&shtSensor);
-    dataExchanger.addProvider(&humidifier);
-    dataExchanger.addProvider(&fan);
-    dataExchanger.addProvider(&capacitiveSensor); // Register new sensor
+    // 3. Install the device lists and register the providers
+    Devices::install(allDevices, switchableDevices, dataExchanger);
 }
 
 #endif
\ No newline at end of file
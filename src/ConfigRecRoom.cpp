@@ -7,10 +7,16 @@
 
 #ifdef CONFIG_RECROOM
 
+// --- EEPROM ---
+enum EepromRecord { EE_EXCHANGER, EE_SHT, EE_WOODSTOVE_TEMP, EE_WOODSTOVE_STATUS, EE_WIFI };
+// Records from before the layout stay where deployed nodes have them.
+using Layout = EepromLayout<EepromAt<2, DataExchanger::Config>, EepromAt<400, SHT31::Config>, EepromAt<300, DS18B20::Config>, EepromAt<500, RGBControl::Config>, WifiLinkCache>;
+const size_t EEPROM_SIZE = Layout::size();
+
 // --- Identity ---
 const char* DEVICE_ID = "recroom_01";
 // Using GPIO 2 (Built-in LED on NodeMCU) for status indication
-DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, 2);
+DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, Layout::offset<EE_EXCHANGER, DataExchanger::Config>());
 
 // --- Devices ---
 static SystemMonitor sysMon("systemMonitor", DEVICE_ID);
@@ -19,17 +25,26 @@ static SystemMonitor sysMon("systemMonitor", DEVICE_ID);
 static PushButtonMonitor btn1("btn1", D3, true);
 
 // SHT31 Sensor (I2C: D2=SDA, D1=SCL)
-static SHT31 shtSensor("shtSensor", 0x44, 60000, 400);
+static SHT31 shtSensor("shtSensor", 0x44, 60000, Layout::offset<EE_SHT, SHT31::Config>());
 
 // 2 Temperature Readers (D5, D6)
-static DS18B20 temp1(D5, "woodstove", 0, 300);
+static DS18B20 temp1(D5, "woodstove", 0, Layout::offset<EE_WOODSTOVE_TEMP, DS18B20::Config>());
 
 // RGB Status Light (D6, D7, D8)
-static RGBControl woodstoveStatus("woodstoveStatusLed", D7, D8, D6, false, 1000, 500);
+static RGBControl woodstoveStatus("woodstoveStatusLed", D7, D8, D6, false, 1000, Layout::offset<EE_WOODSTOVE_STATUS, RGBControl::Config>());
 
 // Status LED (Built-in LED is usually GPIO 2, Active Low)
 static RelayControl statusLed("statusLed", 2, true);
 
+// --- Device table ---
+using Devices = DeviceTable<
+    DeviceEntry<sysMon, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<shtSensor, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<btn1, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<temp1, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<woodstoveStatus, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<statusLed, ROLE_DEVICE | ROLE_PROVIDER>>;
+
 void setupConfiguration() {
     // 1. Assign specific pointers for main loop logic
     systemMonitor = &sysMon;
@@ -37,22 +52,11 @@ void setupConfiguration() {
     statusIndicator = &statusLed;
 
     // 2. Configure wiring
+    wifi.setEepromOffset(Layout::offset<EE_WIFI, WifiLinkCache>());
     // No local relay targets for these buttons in this config
 
-    // 3. Populate generic device list (for update loop)
-    allDevices.push_back(&sysMon);
-    allDevices.push_back(&shtSensor);
-    allDevices.push_back(&btn1);
-    allDevices.push_back(&temp1);
-    allDevices.push_back(&woodstoveStatus);
-    allDevices.push_back(&statusLed);
-
-    // 4. Register providers to DataExchanger
-    dataExchanger.addProvider(&sysMon);
-    dataExchanger.addProvider(&shtSensor);
-    dataExchanger.addProvider(&btn1);
-    dataExchanger.addProvider(&temp1);
-    dataExchanger.addProvider(&woodstoveStatus);
+    // 3. Install the device lists and register the providers
+    Devices::install(allDevices, switchableDevices, dataExchanger);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "ConfigStore.h"
+#include "EepromConfigBackend.h"
+#include "JournalConfigBackend.h"
+#include "NvsConfigBackend.h"
+#include "Logger.h"
+#include <limits.h>
+
+ConfigStore Settings;
+
+static EepromConfigBackend eepromBackend;
+static JournalConfigBackend journalBackend;
+#ifdef ESP32
+static NvsConfigBackend nvsBackend;
+#endif
+
+// Commit once no write has come in for this long...
+static const unsigned long QUIET_PERIOD = 2000;
+// ...but never hold a write back longer than this, even if more keep coming.
+static const unsigned long MAX_DEFER = 30000;
+static const unsigned long HOUR = 3600000;
+// Above this many commits in an hour, something is saving far more often than settings change.
+static const uint32_t WEAR_WARNING_COMMITS = 30;
+
+ConfigStore::ConfigStore()
+    : _backend(nullptr), _firstWrite(0), _lastWrite(0), _commits(0), _unchangedWrites(0), _lastCommitUs(0), _maxCommitUs(0),
+      _hourStart(0), _hourCommits(0), _lastHourCommits(0), _hourComplete(false), _wearWarned(false) {
+}
+
+void ConfigStore::begin(size_t size) {
+    // What an erased EEPROM reads as; no device's magic number matches it.
+    _image.assign(size, 0xFF);
+
+#ifdef ESP32
+    _backend = &nvsBackend;
+#else
+    _backend = &journalBackend;
+#endif
+    if (!_backend->begin(size)) {
+        Log.warn(("ConfigStore: Backend not available, using the EEPROM: " + String(_backend->getName())).c_str());
+        _backend = &eepromBackend;
+        _backend->begin(size);
+    }
+    if (!_backend->load(_image)) {
+        _migrate(size);
+    }
+    Log.info(("ConfigStore: Config backend: " + String(_backend->getName())).c_str());
+}
+
+// First boot with this backend: take the config over from the one used before, newest first.
+void ConfigStore::_migrate(size_t size) {
+#ifdef ESP32
+    ConfigBackend* sources[] = { &journalBackend, &eepromBackend };
+#else
+    ConfigBackend* sources[] = { &eepromBackend };
+#endif
+    for (ConfigBackend* source : sources) {
+        if (source == _backend || !source->begin(size)) {
+            continue;
+        }
+        bool found = source->load(_image);
+        source->end();
+        if (found) {
+            Log.info(("ConfigStore: Migrated the config from: " + String(source->getName())).c_str());
+            break;
+        }
+    }
+    _backend->store(_image);
+}
+
+void ConfigStore::write(int offset, const void* data, size_t length) {
+    if (offset < 0 || offset + length > _image.size()) {
+        Log.error(("ConfigStore: Write outside the config image at offset " + String(offset)).c_str());
+        return;
+    }
+
+    // Setters often save values that did not change; those cost nothing.
+    if (memcmp(_image.data() + offset, data, length) == 0) {
+        _unchangedWrites++;
+        return;
+    }
+    memcpy(_image.data() + offset, data, length);
+
+    unsigned long now = millis();
+    if (_dirty.empty()) {
+        _firstWrite = now;
+    }
+    _lastWrite = now;
+    for (ConfigRecord& record : _dirty) {
+        if (record.offset == offset) {
+            record.length = max(record.length, (uint16_t)length);
+            return;
+        }
+    }
+    ConfigRecord record = { (uint16_t)offset, (uint16_t)length };
+    _dirty.push_back(record);
+}
+
+void ConfigStore::read(int offset, void* data, size_t length) {
+    if (offset < 0 || offset + length > _image.size()) {
+        Log.error(("ConfigStore: Read outside the config image at offset " + String(offset)).c_str());
+        return;
+    }
+    memcpy(data, _image.data() + offset, length);
+}
+
+void ConfigStore::_rollHour(unsigned long now) {
+    if (now - _hourStart < HOUR) {
+        return;
+    }
+    // An hour without any rollover (e.g. no commits for two hours) had no commits.
+    _lastHourCommits = now - _hourStart < 2 * HOUR ? _hourCommits : 0;
+    _hourStart = now - (now - _hourStart) % HOUR;
+    _hourCommits = 0;
+    _hourComplete = true;
+    _wearWarned = false;
+}
+
+void ConfigStore::_commit(const char* reason) {
+    unsigned long now = millis();
+    uint32_t start = micros();
+    if (!_backend->commit(_image, _dirty)) {
+        Log.error("ConfigStore: Config commit failed");
+    }
+    _lastCommitUs = micros() - start;
+    if (_lastCommitUs > _maxCommitUs) {
+        _maxCommitUs = _lastCommitUs;
+    }
+    Log.info(("ConfigStore: Committed records: " + String((unsigned long)_dirty.size()) + " in us: " + String(_lastCommitUs) + " (" + reason + ")").c_str());
+    _dirty.clear();
+    _commits++;
+
+    _rollHour(now);
+    _hourCommits++;
+    if (_hourCommits > WEAR_WARNING_COMMITS && !_wearWarned) {
+        Log.warn(("ConfigStore: High config commit rate this hour: " + String(_hourCommits)).c_str());
+        _wearWarned = true;
+    }
+}
+
+void ConfigStore::update() {
+    if (_dirty.empty()) {
+        // Housekeeping such as compaction runs between commits, when nothing is pending.
+        if (_backend) {
+            _backend->update(_image);
+        }
+        return;
+    }
+    unsigned long now = millis();
+    if (now - _lastWrite >= QUIET_PERIOD) {
+        _commit("quiet");
+    } else if (now - _firstWrite >= MAX_DEFER) {
+        _commit("deferred too long");
+    }
+}
+
+void ConfigStore::flush() {
+    if (!_dirty.empty()) {
+        _commit("flush");
+    }
+}
+
+bool ConfigStore::isDirty() {
+    return !_dirty.empty();
+}
+
+unsigned long ConfigStore::getCommitDelay() {
+    if (_dirty.empty()) {
+        return ULONG_MAX;
+    }
+    unsigned long now = millis();
+    unsigned long quiet = now - _lastWrite >= QUIET_PERIOD ? 0 : QUIET_PERIOD - (now - _lastWrite);
+    unsigned long defer = now - _firstWrite >= MAX_DEFER ? 0 : MAX_DEFER - (now - _firstWrite);
+    return min(quiet, defer);
+}
+
+uint32_t ConfigStore::getCommits() {
+    return _commits;
+}
+
+uint32_t ConfigStore::getCommitsPerHour() {
+    _rollHour(millis());
+    return _hourComplete ? _lastHourCommits : _hourCommits;
+}
+
+void ConfigStore::addToJson(JsonObject& nested) {
+    nested["configSize"] = _image.size();
+    nested["configCommits"] = _commits;
+    nested["configCommitsPerHour"] = getCommitsPerHour();
+    nested["configUnchangedWrites"] = _unchangedWrites;
+    nested["configPending"] = !_dirty.empty();
+    nested["configCommitUs"] = _lastCommitUs;
+    nested["configCommitMaxUs"] = _maxCommitUs;
+    if (_backend) {
+        nested["configBackend"] = _backend->getName();
+        _backend->addToJson(nested);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include "ConfigBackend.h"
+
+// Device configuration, addressed like the EEPROM it replaces: each device reads and writes its
+// config record at the offset the room's EepromLayout gave it. The records live in a RAM image;
+// Settings.get() reads from it and Settings.put() changes it and schedules a commit once the
+// writes have been quiet for a moment, so a slider dragged through twenty values is saved once.
+//
+// A commit hands only the changed records to the backend: NVS with a key per record on the
+// ESP32, a journal on LittleFS on the ESP8266 (see the backends), and the EEPROM if neither is
+// available. The first boot with a backend migrates the config from the older ones.
+//
+// flush() commits pending writes immediately; call it before anything that ends the program
+// (restart, deep sleep). update() runs from the main loop.
+class ConfigStore {
+    private:
+        std::vector<uint8_t> _image;
+        ConfigBackend* _backend;
+
+        std::vector<ConfigRecord> _dirty;
+        unsigned long _firstWrite;
+        unsigned long _lastWrite;
+
+        uint32_t _commits;
+        uint32_t _unchangedWrites;
+        uint32_t _lastCommitUs;
+        uint32_t _maxCommitUs;
+        unsigned long _hourStart;
+        uint32_t _hourCommits;
+        uint32_t _lastHourCommits;
+        bool _hourComplete;
+        bool _wearWarned;
+
+        void _migrate(size_t size);
+        void _rollHour(unsigned long now);
+        void _commit(const char* reason);
+
+    public:
+        ConfigStore();
+        // Loads the image; call once at startup, before any device reads its config.
+        void begin(size_t size);
+
+        // Copies the bytes into the image and schedules a commit if any of them changed.
+        void write(int offset, const void* data, size_t length);
+        void read(int offset, void* data, size_t length);
+
+        template <typename T>
+        void put(int offset, const T& value) {
+            write(offset, &value, sizeof(T));
+        }
+
+        template <typename T>
+        T& get(int offset, T& value) {
+            read(offset, &value, sizeof(T));
+            return value;
+        }
+
+        void update();
+        void flush();
+        bool isDirty();
+        // Milliseconds until update() wants to commit; ULONG_MAX when nothing is pending.
+        unsigned long getCommitDelay();
+
+        uint32_t getCommits();
+        // Commits in the last full hour, or so far if the first hour is not over yet.
+        uint32_t getCommitsPerHour();
+        void addToJson(JsonObject& nested);
+};
+
+extern ConfigStore Settings;
+
+#endif
\ No newline at end of file
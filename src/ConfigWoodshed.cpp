@@ -8,34 +8,66 @@
 
 #ifdef CONFIG_WOODSHED
 
+// --- EEPROM ---
+enum EepromRecord {
+    EE_EXCHANGER, EE_TEMP_OUTSIDE, EE_TEMP_CONTROL_BOX, EE_BATTERY, EE_RGB_STRIP, EE_LIGHT_INSIDE, EE_LIGHT_OUTSIDE,
+    EE_LOAD_METER, EE_CHARGE_METER, EE_BME, EE_DUTY_CYCLE, EE_WIFI
+};
+// Records from before the layout stay where deployed nodes have them.
+using Layout = EepromLayout<
+    EepromAt<32, DataExchanger::Config>, EepromAt<530, DS18B20::Config>, EepromAt<540, DS18B20::Config>, EepromAt<420, BatteryMonitor::Config>,
+    EepromAt<500, RGBControl::Config>, EepromAt<300, RelayControl::Config>, EepromAt<320, RelayControl::Config>, EepromAt<360, INA219CurrentReader::Config>,
+    EepromAt<390, INA219CurrentReader::Config>, EepromAt<480, BME280Reader::Config>, DutyCycle::Config, WifiLinkCache>;
+const size_t EEPROM_SIZE = Layout::size();
+
 // --- Identity ---
 const char* DEVICE_ID = "woodshed_01";
-DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, 32);
+DataExchanger dataExchanger("dataExchanger", DEVICE_ID, 60000, "http://server.wnet.wn:8101/automation_api", "mqtt://server.wnet.wn:1883", wifi, Layout::offset<EE_EXCHANGER, DataExchanger::Config>());
 
 // --- Devices ---
 static SystemMonitor sysMon("systemMonitor", DEVICE_ID);
-static DS18B20 tempOutside(D5, "tempOutside", 0, 530);
-static DS18B20 tempControlBox(D5, "battery", 1, 540);
-static BatteryMonitor batMon("batteryMonitor", A0, 11.7246, 11.9, 11.5, 420, 60, &tempOutside);
+static DS18B20 tempOutside(D5, "tempOutside", 0, Layout::offset<EE_TEMP_OUTSIDE, DS18B20::Config>());
+static DS18B20 tempControlBox(D5, "battery", 1, Layout::offset<EE_TEMP_CONTROL_BOX, DS18B20::Config>());
+static BatteryMonitor batMon("batteryMonitor", A0, 11.7246, 11.9, 11.5, Layout::offset<EE_BATTERY, BatteryMonitor::Config>(), 60, &tempOutside);
 
-static RGBControl rgbStrip("rgbStrip", D2, D6, D1, false, 1000, 500);
-static RelayControl lightInside("lightInside", 32, false, true, 200, 300);
-static RelayControl lightOutside("lightOutside", 33, false, true, 200, 320);
+static RGBControl rgbStrip("rgbStrip", D2, D6, D1, false, 1000, Layout::offset<EE_RGB_STRIP, RGBControl::Config>());
+static RelayControl lightInside("lightInside", 32, false, true, 200, Layout::offset<EE_LIGHT_INSIDE, RelayControl::Config>());
+static RelayControl lightOutside("lightOutside", 33, false, true, 200, Layout::offset<EE_LIGHT_OUTSIDE, RelayControl::Config>());
 static RelayControl statusLed("statusLed", LED_BUILTIN, false);
 
 static PushButtonMonitor lightSwitchForOutside("lightSwitchOutside", D3, true);
 static PushButtonMonitor lightSwitchForInside("lightSwitchInside", D7, true);
-static INA219CurrentReader loadMeter("loadMeter", 0x40, 1000, 360, 128);
-static INA219CurrentReader chargeMeter("chargeMeter", 0x41, 1000, 390, 128);
-static BME280Reader bmeSensor("controlBox", 0x76, 60000, 480);
+static INA219CurrentReader loadMeter("loadMeter", 0x40, 1000, Layout::offset<EE_LOAD_METER, INA219CurrentReader::Config>(), 128);
+static INA219CurrentReader chargeMeter("chargeMeter", 0x41, 1000, Layout::offset<EE_CHARGE_METER, INA219CurrentReader::Config>(), 128);
+static BME280Reader bmeSensor("controlBox", 0x76, 60000, Layout::offset<EE_BME, BME280Reader::Config>());
+// Off until enabled with {"dutyCycle":{"setEnabled":true}}.
+static DutyCycle sleepCycle("dutyCycle", allDevices, Layout::offset<EE_DUTY_CYCLE, DutyCycle::Config>());
+
+// --- Device table ---
+using Devices = DeviceTable<
+    DeviceEntry<batMon, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<tempOutside, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<tempControlBox, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<sysMon, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<rgbStrip, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<lightInside, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<lightOutside, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>,
+    DeviceEntry<statusLed, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<lightSwitchForOutside, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<lightSwitchForInside, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<loadMeter, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<chargeMeter, ROLE_DEVICE | ROLE_PROVIDER>,
+    DeviceEntry<bmeSensor, ROLE_DEVICE | ROLE_PROVIDER>>;
 
 void setupConfiguration() {
     // 1. Assign specific pointers for main loop logic
     systemMonitor = &sysMon;
     systemBattery = &batMon;
     statusIndicator = &statusLed;
+    dutyCycle = &sleepCycle;
 
     // 2. Configure devices
+    wifi.setEepromOffset(Layout::offset<EE_WIFI, WifiLinkCache>());
     lightSwitchForOutside.setTarget(&lightOutside);
     lightSwitchForInside.setTarget(&lightInside);
 
@@ -43,39 +75,8 @@ void setupConfiguration() {
     // Resistance = 0.075V / 10A = 0.0075 Ohms.
     chargeMeter.setExternalShunt(0.0075, 10.0);
 
-    // 3. Populate generic device list for the main update loop
-    allDevices.push_back(&batMon);
-    allDevices.push_back(&tempOutside);
-    allDevices.push_back(&tempControlBox);
-    allDevices.push_back(&sysMon);
-    allDevices.push_back(&rgbStrip);
-    allDevices.push_back(&lightInside);
-    allDevices.push_back(&lightOutside);
-    allDevices.push_back(&statusLed);
-    allDevices.push_back(&lightSwitchForOutside);
-    allDevices.push_back(&lightSwitchForInside);
-    allDevices.push_back(&loadMeter);
-    allDevices.push_back(&chargeMeter);
-    allDevices.push_back(&bmeSensor);
-
-    // 4. Populate switchable list (for group operations like turnOffLights)
-    switchableDevices.push_back(&lightInside);
-    switchableDevices.push_back(&lightOutside);
-    switchableDevices.push_back(&rgbStrip);
-
-    // 5. Register providers to DataExchanger
-    dataExchanger.addProvider(&batMon);
-    dataExchanger.addProvider(&tempOutside);
-    dataExchanger.addProvider(&tempControlBox);
-    dataExchanger.addProvider(&sysMon);
-    dataExchanger.addProvider(&rgbStrip);
-    dataExchanger.addProvider(&lightInside);
-    dataExchanger.addProvider(&lightOutside);    
-    dataExchanger.addProvider(&lightSwitchForOutside);
-    dataExchanger.addProvider(&lightSwitchForInside);
-    dataExchanger.addProvider(&loadMeter);
-    dataExchanger.addProvider(&chargeMeter);
-    dataExchanger.addProvider(&bmeSensor);
+    // 3. Install the device lists and register the providers
+    Devices::install(allDevices, switchableDevices, dataExchanger);
 }
 
 #endif
\ No newline at end of file
@@ -8,8 +8,9 @@ WifiConnection wifi("jjnet_automation", "2023-02-18!a", WIFI_LIGHT_SLEEP);
 BatteryMonitor* systemBattery = nullptr;
 SystemMonitor* systemMonitor = nullptr;
 DeviceControl* statusIndicator = nullptr;
+DutyCycle* dutyCycle = nullptr;
 
 // Lists for generic iteration
-// These will be populated by the specific config file's setupConfiguration()
-std::vector<Device*> allDevices;
-std::vector<DeviceControl*> switchableDevices;
\ No newline at end of file
+// These will be installed by the specific config file's setupConfiguration()
+DeviceList<Device> allDevices;
+DeviceList<DeviceControl> switchableDevices;
\ No newline at end of file
@@ -9,6 +9,9 @@
 #include "DeviceControl.h"
 #include "BatteryMonitor.h"
 #include "SystemMonitor.h"
+#include "DutyCycle.h"
+#include "EepromLayout.h"
+#include "DeviceTable.h"
 
 #ifdef ESP32
 // Define pin mappings for ESP32 so they are available in all config files
@@ -32,15 +35,18 @@
 extern WifiConnection wifi;
 extern DataExchanger dataExchanger;
 extern const char* DEVICE_ID;
+// Bytes of config used by the room's EepromLayout.
+extern const size_t EEPROM_SIZE;
 
 // Specific pointers for critical system logic (can be null)
 extern BatteryMonitor* systemBattery;
 extern SystemMonitor* systemMonitor;
 extern DeviceControl* statusIndicator;
+extern DutyCycle* dutyCycle;
 
-// Lists for generic iteration
-extern std::vector<Device*> allDevices;
-extern std::vector<DeviceControl*> switchableDevices;
+// Lists for generic iteration, installed from the room's DeviceTable
+extern DeviceList<Device> allDevices;
+extern DeviceList<DeviceControl> switchableDevices;
 
 // Setup function to initialize the configuration (instantiate objects)
 void setupConfiguration();
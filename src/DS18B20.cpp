@@ -1,49 +1,88 @@
 #include "DS18B20.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 #include <ArduinoJson.h>
 #include "Logger.h"
 
 DS18B20::DS18B20(int pin, String name, int sensorIndex, int eepromOffset) 
-    : _oneWire(pin), _sensors(&_oneWire), _name(name), _sensorIndex(sensorIndex), _available(true), _lastGoodTemp(NAN), _badReadingCount(0), _maxBadReadings(0), _lastUpdateTime(0), _offset(0.0), _eepromOffset(eepromOffset) {
+    : _bus(OneWireBus::forPin(pin)), _name(name), _sensorIndex(sensorIndex), _addressResolved(false), _available(true), _lastGoodTemp(NAN), _badReadingCount(0), _maxBadReadings(0), _lastUpdateTime(0), _measurementPending(false), _offset(0.0), _eepromOffset(eepromOffset) {
 }
 
 void DS18B20::begin() {
     if (_eepromOffset >= 0) {
         loadConfig();
     }
-    _sensors.begin();
+    _bus->begin();
+    _resolveAddress();
     // Ensure the first update happens immediately
     _lastUpdateTime = millis() - 60000;
 }
 
+bool DS18B20::_resolveAddress() {
+    // The index refers to the bus enumeration order; after that the sensor is read by ROM address.
+    if (!_addressResolved) {
+        _addressResolved = _bus->claim(_sensorIndex, _address);
+    }
+    return _addressResolved;
+}
+
 void DS18B20::update() {
+    if (_measurementPending) {
+        if (_bus->getConversionDelay() == 0) {
+            collectMeasurement();
+        }
+        return;
+    }
+
     if (millis() - _lastUpdateTime >= 60000) {
-        _lastUpdateTime = millis();
-        _sensors.requestTemperatures();
-        float tempC = _sensors.getTempCByIndex(_sensorIndex);
-        
-        if (tempC >= -70 && tempC <= 84) {
-            _lastGoodTemp = tempC + _offset;
-            _badReadingCount = 0;
-            if (!_available) {
-                Log.info(("DS18B20 " + _name + " is available again.").c_str());
-                _available = true;
-            }
-        } else {
-            _badReadingCount++;
-            if (_badReadingCount > _maxBadReadings) {
-                _maxBadReadings = _badReadingCount;
-            }
-            if (_available && _badReadingCount >= MAX_CONSECUTIVE_BAD_READINGS) {
-                _available = false;
-                _lastGoodTemp = NAN;
-                Log.error(("DS18B20 " + _name + " is not available after " + String(MAX_CONSECUTIVE_BAD_READINGS) + " bad readings.").c_str());
-            }
+        startMeasurement();
+    }
+}
+
+bool DS18B20::startMeasurement() {
+    _lastUpdateTime = millis();
+    // Shares the conversion with the other sensors on the bus if one is running or fresh.
+    _bus->requestConversion();
+    _measurementPending = true;
+    return true;
+}
+
+void DS18B20::collectMeasurement() {
+    _measurementPending = false;
+    float tempC = _resolveAddress() ? _bus->getTempC(_address) : DEVICE_DISCONNECTED_C;
+
+    if (tempC >= -70 && tempC <= 84) {
+        _lastGoodTemp = tempC + _offset;
+        _badReadingCount = 0;
+        if (!_available) {
+            Log.info(("DS18B20 " + _name + " is available again.").c_str());
+            _available = true;
+        }
+    } else {
+        _badReadingCount++;
+        if (_badReadingCount > _maxBadReadings) {
+            _maxBadReadings = _badReadingCount;
+        }
+        if (_available && _badReadingCount >= MAX_CONSECUTIVE_BAD_READINGS) {
+            _available = false;
+            _lastGoodTemp = NAN;
+            Log.error(("DS18B20 " + _name + " is not available after " + String(MAX_CONSECUTIVE_BAD_READINGS) + " bad readings.").c_str());
         }
     }
 }
 
+bool DS18B20::measurementPending() {
+    return _measurementPending;
+}
+
+unsigned long DS18B20::getUpdateDelay() {
+    if (_measurementPending) {
+        return _bus->getConversionDelay();
+    }
+    return timeUntil(_lastUpdateTime, 60000);
+}
+
 float DS18B20::getTemperature() {
-    update();
     if (_available && !isnan(_lastGoodTemp)) {
         return _lastGoodTemp;
     }
@@ -56,8 +95,6 @@ void DS18B20::addToJson(JsonArray& doc) {
     nested["subtype"] = "DS18B20";
     nested["name"] = _name;
     nested["available"] = _available;
-    nested["maxBadReadings"] = _maxBadReadings;
-    nested["tempCOffset"] = serialized(String(_offset, 2));
 
     if (_available) {
         float tempC = getTemperature();
@@ -69,24 +106,42 @@ void DS18B20::addToJson(JsonArray& doc) {
     }
 }
 
-void DS18B20::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
-        if (config.containsKey("setTempCOffset")) {
-            float newOffset = config["setTempCOffset"].as<float>();
-            if (newOffset != _offset) {
-                _offset = newOffset;
-                saveConfig();
-                // Invalidate last reading so next update reflects the offset immediately
-                _lastUpdateTime = millis() - 60000; 
-            }
+uint32_t DS18B20::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(_available);
+    fp.add(getConfigFingerprint());
+    fp.add(getTemperature(), 0.1f);
+    fp.add(_badReadingCount > 0);
+    return fp.value();
+}
+
+void DS18B20::addConfigToJson(JsonObject& nested) {
+    nested["maxBadReadings"] = _maxBadReadings;
+    setFixed(nested, "tempCOffset", _offset, 2);
+}
+
+uint32_t DS18B20::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_maxBadReadings);
+    fp.add(_offset, 0.01f);
+    return fp.value();
+}
+
+void DS18B20::processCommand(JsonObject& config) {
+    if (config.containsKey("setTempCOffset")) {
+        float newOffset = config["setTempCOffset"].as<float>();
+        if (newOffset != _offset) {
+            _offset = newOffset;
+            saveConfig();
+            // Invalidate last reading so next update reflects the offset immediately
+            if (!_measurementPending) _lastUpdateTime = millis() - 60000;
         }
     }
 }
 
 void DS18B20::loadConfig() {
     Config config;
-    EEPROM.get(_eepromOffset, config);
+    Settings.get(_eepromOffset, config);
     if (config.magic == 0x18B2018) {
         _offset = config.offset;
     }
@@ -95,8 +150,36 @@ void DS18B20::loadConfig() {
 void DS18B20::saveConfig() {
     if (_eepromOffset < 0) return;
     Config config = { _offset, 0x18B2018 };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Settings.put(_eepromOffset, config);
+}
+
+// Keeps the last good reading (and the count of bad ones) if a wake ends before the conversion.
+struct DS18B20SleepState {
+    float lastGoodTemp;
+    int badReadingCount;
+};
+
+size_t DS18B20::saveSleepState(uint8_t* buffer, size_t capacity) {
+    DS18B20SleepState state = { _lastGoodTemp, _badReadingCount };
+    if (capacity < sizeof(state)) return 0;
+    memcpy(buffer, &state, sizeof(state));
+    return sizeof(state);
+}
+
+void DS18B20::restoreSleepState(const uint8_t* buffer, size_t length) {
+    DS18B20SleepState state;
+    if (length != sizeof(state)) return;
+    memcpy(&state, buffer, sizeof(state));
+    _lastGoodTemp = state.lastGoodTemp;
+    _badReadingCount = state.badReadingCount;
+}
+
+int DS18B20::getSampleCount() {
+    return 1;
+}
+
+void DS18B20::getSamples(float* values) {
+    values[0] = getTemperature();
 }
 
 const String& DS18B20::getName() {
@@ -2,40 +2,54 @@
 #define DS18B20_H
 
 #include <Arduino.h>
-#include <OneWire.h>
 #include <DallasTemperature.h>
 #include "Device.h"
-#include <EEPROM.h>
+#include "OneWireBus.h"
 
 class DS18B20 : public Device {
     private:
         static const int MAX_CONSECUTIVE_BAD_READINGS = 5;
-        OneWire _oneWire;
-        DallasTemperature _sensors;
+        OneWireBus* _bus;
         String _name;
         int _sensorIndex;
+        DeviceAddress _address;
+        bool _addressResolved;
         bool _available;
         float _lastGoodTemp;
         int _badReadingCount;
         int _maxBadReadings;
         unsigned long _lastUpdateTime;
+        bool _measurementPending;
         float _offset;
         int _eepromOffset;
 
+        void loadConfig();
+        void saveConfig();
+        bool _resolveAddress();
+
+    public:
         struct Config {
             float offset;
             uint32_t magic;
         };
-        void loadConfig();
-        void saveConfig();
 
-    public:
         DS18B20(int pin, String name, int sensorIndex = 0, int eepromOffset = -1);
         void begin();
         void update() override;
+        unsigned long getUpdateDelay() override;
+        bool startMeasurement() override;
+        void collectMeasurement() override;
+        bool measurementPending() override;
         float getTemperature();
         void addToJson(JsonArray& doc) override;
-        void processJson(JsonObject& doc) override;
+        uint32_t getStateFingerprint() override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
+        void processCommand(JsonObject& command) override;
+        size_t saveSleepState(uint8_t* buffer, size_t capacity) override;
+        void restoreSleepState(const uint8_t* buffer, size_t length) override;
+        int getSampleCount() override;
+        void getSamples(float* values) override;
         const String& getName();
 };
 
@@ -1,9 +1,76 @@
 #include "DataExchanger.h"
 #include "Logger.h"
-#include <EEPROM.h>
+#include "Profiler.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 #include <PubSubClient.h>
 #include <WiFiClient.h>
 
+// Serializer output is gathered into chunks of this size before it is handed to the
+// network client, so the TCP stack sees a few full writes instead of one per token.
+static const size_t PUBLISH_CHUNK_SIZE = 256;
+
+// Print adapter that forwards to another Print in PUBLISH_CHUNK_SIZE blocks.
+class ChunkedPrint : public Print {
+public:
+    explicit ChunkedPrint(Print& target) : _target(target), _length(0), _written(0) {}
+
+    size_t write(uint8_t c) override {
+        if (_length == PUBLISH_CHUNK_SIZE) flush();
+        _buffer[_length++] = c;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        for (size_t i = 0; i < size; i++) {
+            write(buffer[i]);
+        }
+        return size;
+    }
+
+    void flush() override {
+        if (_length > 0) {
+            _written += _target.write(_buffer, _length);
+            _length = 0;
+        }
+    }
+
+    size_t written() const {
+        return _written;
+    }
+
+private:
+    Print& _target;
+    uint8_t _buffer[PUBLISH_CHUNK_SIZE];
+    size_t _length;
+    size_t _written;
+};
+
+// A full keyframe goes out every this many exchanges unless changed with "setKeyframeInterval".
+static const unsigned int DEFAULT_KEYFRAME_INTERVAL = 10;
+static const unsigned int MAX_KEYFRAME_INTERVAL = 1000;
+
+// Undelivered payloads: RAM staging buffer and flash budget. The flash log is rotated at half
+// the budget, so this is the most history kept on flash.
+#ifdef ESP32
+static const size_t HISTORY_RAM_BYTES = 4096;
+static const size_t HISTORY_FILE_BYTES = 128 * 1024;
+#else
+static const size_t HISTORY_RAM_BYTES = 1024;
+static const size_t HISTORY_FILE_BYTES = 64 * 1024;
+#endif
+// Upper bound on one replay message, and the default pause between two of them.
+static const size_t HISTORY_BATCH_BYTES = 4096;
+static const unsigned long DEFAULT_REPLAY_INTERVAL = 5000;
+
+// MQTT reconnects back off exponentially from the first to the longest delay, +/- 25% jitter so
+// nodes that lost the broker together do not come back in lockstep.
+static const uint16_t DEFAULT_MQTT_PORT = 1883;
+static const unsigned long MQTT_FIRST_RETRY_DELAY = 2000;
+static const unsigned long MQTT_MAX_RETRY_DELAY = 300000;
+static const unsigned long MQTT_TCP_TIMEOUT = 1000;
+static const uint16_t MQTT_HANDSHAKE_TIMEOUT_S = 2;
+
 // Global pointer to the instance for the static MQTT callback
 static DataExchanger* _exchangerInstance = nullptr;
 
@@ -13,29 +80,33 @@ void _mqttCallback(char* topic, byte* payload, unsigned int length) {
     }
 }
 
-struct DataExchangerConfig {
-    unsigned long interval;
-    char httpUrl[128];
-    char mqttUrl[128];
-    uint32_t magic;
-};
-
 DataExchanger::DataExchanger(const char* name, const char* deviceId, unsigned long interval, const char* httpUrl, const char* mqttUrl, WifiConnection& wifi, int eepromOffset)
-    : _name(name), _deviceId(deviceId), _eepromOffset(eepromOffset), _interval(interval), _httpUrl(httpUrl), _mqttUrl(mqttUrl), _wifi(wifi), _lastExchangeTime(0), _lastMqttConnectionAttempt(0), _doc(4096), _triggerExchange(false) {
+    : _name(name), _deviceId(deviceId), _eepromOffset(eepromOffset), _interval(interval), _httpUrl(httpUrl), _mqttUrl(mqttUrl), _mqttPort(DEFAULT_MQTT_PORT), _wifi(wifi), _lastExchangeTime(0),
+      _mqttPhase(MQTT_WAITING), _mqttNextAttempt(0), _mqttRetryDelay(0), _mqttAttemptStart(0), _mqttAttempts(0), _mqttFailures(0), _mqttLastConnectMs(0), _mqttMaxConnectMs(0),
+      _doc(4096), _triggerExchange(false), _format(FORMAT_JSON),
+      _keyframeInterval(DEFAULT_KEYFRAME_INTERVAL), _exchangesSinceKeyframe(0), _keyframeRequested(true), _sendingKeyframe(true), _unchangedProviders(0),
+      _publishedConfigHash(0), _configPublishRequested(true), _history(HISTORY_RAM_BYTES, HISTORY_FILE_BYTES),
+      _replayInterval(DEFAULT_REPLAY_INTERVAL), _lastReplay(0) {
     
     _exchangerInstance = this;
     _mqttClient.setClient(_wifiClient);
     _mqttClient.setCallback(_mqttCallback);
-    _mqttClient.setBufferSize(4096); // Increase buffer for JSON payloads
+    // Outgoing payloads are streamed, so the buffer only has to hold incoming commands.
+    _mqttClient.setBufferSize(1024);
+    // connect() waits this long for the broker's CONNACK, the one step that cannot be split up.
+    _mqttClient.setSocketTimeout(MQTT_HANDSHAKE_TIMEOUT_S);
 }
 
 void DataExchanger::begin() {
+    _routes.insert(std::make_pair(_nameHash(_name.c_str()), (JsonProvider*)this));
     loadConfig();
+    _parseMqttUrl();
+    _history.begin();
 }
 
 void DataExchanger::loadConfig() {
-    DataExchangerConfig config;
-    EEPROM.get(_eepromOffset, config);
+    Config config;
+    Settings.get(_eepromOffset, config);
     
     if (config.magic == 0xCAFEBABE) {
         _interval = config.interval;
@@ -52,60 +123,38 @@ void DataExchanger::loadConfig() {
 }
 
 void DataExchanger::saveConfig() {
-    DataExchangerConfig config;
+    Config config;
     config.interval = _interval;
     strncpy(config.httpUrl, _httpUrl.c_str(), sizeof(config.httpUrl));
     config.httpUrl[sizeof(config.httpUrl) - 1] = 0;
     strncpy(config.mqttUrl, _mqttUrl.c_str(), sizeof(config.mqttUrl));
     config.mqttUrl[sizeof(config.mqttUrl) - 1] = 0;
     config.magic = 0xCAFEBABE;
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Settings.put(_eepromOffset, config);
 }
 
 void DataExchanger::addProvider(JsonProvider* provider) {
     _providers.push_back(provider);
+    _routes.insert(std::make_pair(_nameHash(provider->getName().c_str()), provider));
+    _sentFingerprints.push_back(0);
+    _pendingFingerprints.push_back(0);
 }
 
 bool DataExchanger::exchange(bool force, const char* reason) {
     unsigned long currentMillis = millis();
 
-    if (_mqttUrl.length() > 0) {
-        // Ensure MQTT connection
-        if (!_mqttClient.connected()) {
-            // Attempt connection if WiFi is connected and we haven't tried too recently (5s retry)
-            if (_wifi.isConnected() && (force || (currentMillis - _lastMqttConnectionAttempt >= 5000))) {
-                _lastMqttConnectionAttempt = currentMillis;
-                
-                // Parse URL for server (and optional port)
-                String server = _mqttUrl;
-                int port = 1883;
-
-                // Strip scheme if present (e.g. mqtt://)
-                int schemeEnd = server.indexOf("://");
-                if (schemeEnd != -1) {
-                    server = server.substring(schemeEnd + 3);
-                }
-
-                int colonIndex = server.indexOf(':');
-                if (colonIndex != -1) {
-                    String portStr = server.substring(colonIndex + 1);
-                    server = server.substring(0, colonIndex);
-                    port = portStr.toInt();
-                }
-
-                _mqttClient.setServer(server.c_str(), port);
-                String clientId = _deviceId;
-                if (_mqttClient.connect(clientId.c_str())) {
-                    Log.info("MQTT Connected");
-                    String topic = String("device/") + _deviceId + "/command";
-                    _mqttClient.subscribe(topic.c_str());
-                } else {
-                    Log.error("MQTT Connect failed");
+    if (_mqttHost.length() > 0) {
+        if (_mqttClient.connected()) {
+            _mqttClient.loop();
+            if (!_history.isEmpty() && currentMillis - _lastReplay >= _replayInterval) {
+                _lastReplay = currentMillis;
+                if (!_replayHistory()) {
+                    Log.error("DataExchanger: History replay failed");
                 }
             }
         } else {
-            _mqttClient.loop();
+            // One step per call; a forced exchange does not skip the backoff.
+            _advanceMqttConnection(currentMillis);
         }
     }
 
@@ -122,37 +171,49 @@ bool DataExchanger::exchange(bool force, const char* reason) {
 
     _lastExchangeTime = currentMillis;
 
-    // Create JSON payload
-    _doc.clear();
-    JsonArray root = _doc.to<JsonArray>();
-
-    addToJson(root);
-
-    // Add the reason/trigger for the transmission to the exchanger data.
-    if (root.size() > 0) {
-        JsonObject nested = root[root.size() - 1];
-        if (nested["name"] == _name) {
-            const char* actualReason = (reason && *reason) ? reason : (force ? "forced" : "scheduled");
-            nested["trigger"] = actualReason;
+    // A keyframe carries every provider; in between, only providers whose state changed are sent.
+    _sendingKeyframe = _keyframeRequested || _exchangesSinceKeyframe + 1 >= _keyframeInterval;
+    _unchangedProviders = 0;
+    for (size_t i = 0; i < _providers.size(); i++) {
+        _pendingFingerprints[i] = _providers[i]->getStateFingerprint();
+        if (!_shouldSend(i)) {
+            _unchangedProviders++;
         }
     }
 
-    // Add providers to JSON
-    for (JsonProvider* provider : _providers) {
-        provider->addToJson(root);
+    JsonProvider::setBinaryFormat(_format == FORMAT_MSGPACK);
+
+    // Settings go to the retained config topic when they change, not into every payload. An
+    // exchange that goes over HTTP (no MQTT configured, or the broker is unreachable) has no such
+    // topic and carries them inline with every keyframe instead.
+    bool viaMqtt = _mqttUrl.length() > 0 && _mqttClient.connected();
+    if (viaMqtt) {
+        uint32_t configHash = _configHash();
+        if (_configPublishRequested || configHash != _publishedConfigHash) {
+            if (_publishConfig(configHash)) {
+                Log.info("DataExchanger: Config published");
+                _publishedConfigHash = configHash;
+                _configPublishRequested = false;
+            } else {
+                Log.error("DataExchanger: Config publish failed");
+            }
+        }
     }
 
-    _requestBody = "";
-    serializeJson(_doc, _requestBody);
+    const char* trigger = (reason && *reason) ? reason : (force ? "forced" : "scheduled");
+    _buildPayload(!viaMqtt && _sendingKeyframe, trigger);
+
+    size_t payloadSize = _format == FORMAT_MSGPACK ? measureMsgPack(_doc) : measureJson(_doc);
 
     Log.info("Payload size:");
-    Log.info(String(_requestBody.length()).c_str());
+    Log.info(String(payloadSize).c_str());
 
     if (_mqttUrl.length() > 0) {
-        String topic = String("device/") + _deviceId + "/data";
-        if (_mqttClient.publish(topic.c_str(), _requestBody.c_str())) {
+        String topic = _topic(_format, "data");
+        if (_publishStreamed(topic.c_str(), payloadSize)) {
             Log.info(("MQTT Publish successful: " + topic).c_str());
             _pendingAck = "";
+            _commitFingerprints();
             return true;
         } else {
             Log.error("MQTT Publish failed");
@@ -161,35 +222,83 @@ bool DataExchanger::exchange(bool force, const char* reason) {
 
     // HTTP Fallback
     if (_httpUrl.length() == 0) {
-        return false;
+        return _keepForReplay();
+    }
+    // A keyframe built for the broker lacks the settings the HTTP server only gets inline.
+    bool rebuilt = viaMqtt && _sendingKeyframe;
+    if (rebuilt) {
+        _buildPayload(true, trigger);
     }
 
-    String response = _wifi.postJson(_httpUrl.c_str(), _requestBody);
+    // The HTTP API only speaks JSON. Serialize into a single exact-size buffer; growing a String
+    // would reallocate on the way.
+    if (_format != FORMAT_JSON || rebuilt) {
+        payloadSize = measureJson(_doc);
+    }
+    char* body = (char*)malloc(payloadSize + 1);
+    if (!body) {
+        Log.error("DataExchanger: Not enough memory for HTTP payload.");
+        return _keepForReplay();
+    }
+    serializeJson(_doc, body, payloadSize + 1);
+    String response = _wifi.postJson(_httpUrl.c_str(), (const uint8_t*)body, payloadSize);
+    free(body);
 
     if (response.length() > 0) {
         Log.info("DataExchanger: Response:");
         Log.info(response.c_str());
         _pendingAck = "";
+        _commitFingerprints();
 
         // Parse the response
         StaticJsonDocument<1024> responseDoc;
         DeserializationError error = deserializeJson(responseDoc, response);
 
         if (!error) {
-            // Call each of the provider's processJson methods so they can act on commands that may have come back.
+            // Route each command in the response to the provider it names.
             JsonObject root = responseDoc.as<JsonObject>();
-            
-            processJson(root);
-
-            for (JsonProvider* provider : _providers) {
-                provider->processJson(root);
-            }
+            _processAll(root);
         } else {
             Log.error("DataExchanger: Failed to parse response JSON.");
         }
         return true;
     }
-    return false;
+    return _keepForReplay();
+}
+
+unsigned long DataExchanger::getExchangeDelay() {
+    if (_triggerExchange) {
+        return 0;
+    }
+    unsigned long now = millis();
+    unsigned long elapsed = now - _lastExchangeTime;
+    unsigned long delay = elapsed >= _interval ? 0 : _interval - elapsed;
+    if (_mqttHost.length() > 0 && !_mqttClient.connected() && _wifi.isConnected()) {
+        // An attempt in progress continues on the next pass; otherwise wake up when the next is due.
+        long untilAttempt = _mqttPhase == MQTT_WAITING ? (long)(_mqttNextAttempt - now) : 0;
+        if (untilAttempt < 0) {
+            untilAttempt = 0;
+        }
+        if ((unsigned long)untilAttempt < delay) {
+            delay = untilAttempt;
+        }
+    }
+    if (_mqttClient.connected() && !_history.isEmpty()) {
+        unsigned long sinceReplay = now - _lastReplay;
+        unsigned long replayDelay = sinceReplay >= _replayInterval ? 0 : _replayInterval - sinceReplay;
+        if (replayDelay < delay) {
+            delay = replayDelay;
+        }
+    }
+    return delay;
+}
+
+void DataExchanger::flushHistory() {
+    _history.flush();
+}
+
+bool DataExchanger::isOnline() {
+    return _mqttClient.connected();
 }
 
 void DataExchanger::addToJson(JsonArray& doc) {
@@ -197,53 +306,420 @@ void DataExchanger::addToJson(JsonArray& doc) {
     nested["type"] = "System";
     nested["subtype"] = "DataExchanger";
     nested["name"] = _name;
-    nested["interval"] = _interval;
-    nested["httpUrl"] = _httpUrl;
-    nested["mqttUrl"] = _mqttUrl;
+    nested["keyframe"] = _sendingKeyframe;
+    nested["unchanged"] = _unchangedProviders;
+    nested["historyBytes"] = _history.pendingBytes();
+    nested["historyDropped"] = _history.getDroppedBytes();
+    if (_mqttHost.length() > 0) {
+        nested["mqttAttempts"] = _mqttAttempts;
+        nested["mqttFailures"] = _mqttFailures;
+        nested["mqttConnectMs"] = _mqttLastConnectMs;
+        nested["mqttConnectMaxMs"] = _mqttMaxConnectMs;
+    }
     if (_pendingAck.length() > 0) {
         nested["_ack"] = _pendingAck;
     }
 }
 
-void DataExchanger::processJson(JsonObject& doc) {
-    if (doc.containsKey("_ack")) {
-        _pendingAck = doc["_ack"].as<String>();
+void DataExchanger::addConfigToJson(JsonObject& nested) {
+    nested["interval"] = _interval;
+    nested["httpUrl"] = _httpUrl;
+    nested["mqttUrl"] = _mqttUrl;
+    nested["format"] = formatName(_format);
+    nested["keyframeInterval"] = _keyframeInterval;
+    nested["replayInterval"] = _replayInterval;
+}
+
+uint32_t DataExchanger::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_interval);
+    fp.add(_httpUrl);
+    fp.add(_mqttUrl);
+    fp.add((int)_format);
+    fp.add(_keyframeInterval);
+    fp.add(_replayInterval);
+    return fp.value();
+}
+
+void DataExchanger::processCommand(JsonObject& config) {
+    if (config.containsKey("setInterval")) {
+        // Explicitly extract as JsonVariant to handle both number and string input types safely
+        JsonVariant intervalVar = config["setInterval"];
+        unsigned long newInterval = intervalVar.as<unsigned long>();
+        if (newInterval >= 10000 && newInterval <= 600000 && newInterval != _interval) {
+            _interval = newInterval;
+            saveConfig();
+            Log.info("DataExchanger: Interval updated");
+        }
     }
 
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
+    if (config.containsKey("setHttpUrl")) {
+        String newUrl = config["setHttpUrl"].as<String>();
+        if (newUrl.length() < 128 && newUrl != _httpUrl) {
+            _httpUrl = newUrl;
+            saveConfig();
+            Log.info("DataExchanger: HTTP URL updated");
+        }
+    }
 
-        if (config.containsKey("setInterval")) {
-            // Explicitly extract as JsonVariant to handle both number and string input types safely
-            JsonVariant intervalVar = config["setInterval"];
-            unsigned long newInterval = intervalVar.as<unsigned long>();
-            if (newInterval >= 10000 && newInterval <= 600000 && newInterval != _interval) {
-                _interval = newInterval;
-                saveConfig();
-                Log.info("DataExchanger: Interval updated");
-            }
+    if (config.containsKey("setMqttUrl")) {
+        String newUrl = config["setMqttUrl"].as<String>();
+        if (newUrl.length() < 128 && newUrl != _mqttUrl) {
+            _mqttUrl = newUrl;
+            saveConfig();
+            Log.info("DataExchanger: MQTT URL updated");
+            // Reconnect to the new broker right away.
+            _mqttClient.disconnect();
+            _parseMqttUrl();
+        }
+    }
+
+    if (config.containsKey("setFormat")) {
+        String name = config["setFormat"].as<String>();
+        PayloadFormat newFormat = name == formatName(FORMAT_MSGPACK) ? FORMAT_MSGPACK : FORMAT_JSON;
+        if (name != formatName(newFormat)) {
+            Log.warn(("DataExchanger: Unknown format " + name).c_str());
+        } else if (newFormat != _format) {
+            _format = newFormat;
+            // Listeners on the new topics have no baseline to apply deltas to, nor a config.
+            _keyframeRequested = true;
+            _configPublishRequested = true;
+            _triggerExchange = true;
+            Log.info(("DataExchanger: Format set to " + name).c_str());
+        }
+    }
+
+    if (config.containsKey("requestKeyframe")) {
+        _keyframeRequested = true;
+        _triggerExchange = true;
+        Log.info("DataExchanger: Keyframe requested");
+    }
+
+    if (config.containsKey("setKeyframeInterval")) {
+        unsigned int newInterval = config["setKeyframeInterval"].as<unsigned int>();
+        // 1 sends a keyframe on every exchange, i.e. turns delta telemetry off.
+        if (newInterval >= 1 && newInterval <= MAX_KEYFRAME_INTERVAL) {
+            _keyframeInterval = newInterval;
+            Log.info("DataExchanger: Keyframe interval updated");
         }
+    }
 
-        if (config.containsKey("setHttpUrl")) {
-            String newUrl = config["setHttpUrl"].as<String>();
-            if (newUrl.length() < 128 && newUrl != _httpUrl) {
-                _httpUrl = newUrl;
-                saveConfig();
-                Log.info("DataExchanger: HTTP URL updated");
+    if (config.containsKey("setReplayInterval")) {
+        unsigned long newInterval = config["setReplayInterval"].as<unsigned long>();
+        if (newInterval >= 1000 && newInterval <= 600000) {
+            _replayInterval = newInterval;
+            Log.info("DataExchanger: Replay interval updated");
+        }
+    }
+}
+
+void DataExchanger::_parseMqttUrl() {
+    // mqtt://host[:port], the scheme being optional.
+    String server = _mqttUrl;
+    _mqttPort = DEFAULT_MQTT_PORT;
+    int schemeEnd = server.indexOf("://");
+    if (schemeEnd != -1) {
+        server = server.substring(schemeEnd + 3);
+    }
+    int colonIndex = server.indexOf(':');
+    if (colonIndex != -1) {
+        _mqttPort = server.substring(colonIndex + 1).toInt();
+        server = server.substring(0, colonIndex);
+    }
+    _mqttHost = server;
+    _mqttPhase = MQTT_WAITING;
+    _mqttNextAttempt = millis();
+    _mqttRetryDelay = 0;
+}
+
+void DataExchanger::_advanceMqttConnection(unsigned long now) {
+    switch (_mqttPhase) {
+        case MQTT_ONLINE:
+            Log.warn("MQTT connection lost");
+            _mqttPhase = MQTT_WAITING;
+            _mqttNextAttempt = now;
+            _mqttRetryDelay = 0;
+            break;
+
+        case MQTT_WAITING:
+            if (!_wifi.isConnected() || (long)(now - _mqttNextAttempt) < 0) {
+                break;
+            }
+            _mqttAttempts++;
+            _mqttAttemptStart = now;
+            _mqttPhase = MQTT_RESOLVING;
+            break;
+
+        case MQTT_RESOLVING:
+            // Usually answered from the DNS cache.
+            if (_wifi.resolve(_mqttHost.c_str(), _mqttAddress)) {
+                _mqttPhase = MQTT_TCP_CONNECTING;
+            } else {
+                _mqttAttemptFailed(now, "broker not resolved");
+            }
+            break;
+
+        case MQTT_TCP_CONNECTING: {
+#ifdef ESP32
+            bool connected = _wifiClient.connect(_mqttAddress, _mqttPort, MQTT_TCP_TIMEOUT);
+#else
+            _wifiClient.setTimeout(MQTT_TCP_TIMEOUT);
+            bool connected = _wifiClient.connect(_mqttAddress, _mqttPort);
+#endif
+            if (connected) {
+                _mqttPhase = MQTT_HANDSHAKE;
+            } else {
+                // Nothing answered at the cached address; the broker may have moved.
+                _wifi.forgetHost(_mqttHost.c_str());
+                _mqttAttemptFailed(now, "no TCP connection");
             }
+            break;
         }
 
-        if (config.containsKey("setMqttUrl")) {
-            String newUrl = config["setMqttUrl"].as<String>();
-            if (newUrl.length() < 128 && newUrl != _mqttUrl) {
-                _mqttUrl = newUrl;
-                saveConfig();
-                Log.info("DataExchanger: MQTT URL updated");
+        case MQTT_HANDSHAKE:
+            // PubSubClient reuses the socket connected above and only sends CONNECT.
+            if (_mqttClient.setServer(_mqttAddress, _mqttPort).connect(_deviceId.c_str())) {
+                _onMqttConnected(millis());
+            } else {
+                _wifiClient.stop();
+                _mqttAttemptFailed(millis(), "no CONNACK");
             }
+            break;
+    }
+}
+
+void DataExchanger::_mqttAttemptFailed(unsigned long now, const char* step) {
+    _mqttFailures++;
+    _mqttRetryDelay = _mqttRetryDelay == 0 ? MQTT_FIRST_RETRY_DELAY : _mqttRetryDelay * 2;
+    if (_mqttRetryDelay > MQTT_MAX_RETRY_DELAY) {
+        _mqttRetryDelay = MQTT_MAX_RETRY_DELAY;
+    }
+    unsigned long jitter = _mqttRetryDelay / 4;
+    unsigned long delay = _mqttRetryDelay - jitter + random(2 * jitter + 1);
+    _mqttNextAttempt = now + delay;
+    _mqttPhase = MQTT_WAITING;
+    Log.error(("MQTT Connect failed (" + String(step) + "), retry in ms: " + String(delay)).c_str());
+}
+
+void DataExchanger::_onMqttConnected(unsigned long now) {
+    _mqttPhase = MQTT_ONLINE;
+    _mqttRetryDelay = 0;
+    _mqttLastConnectMs = now - _mqttAttemptStart;
+    if (_mqttLastConnectMs > _mqttMaxConnectMs) {
+        _mqttMaxConnectMs = _mqttLastConnectMs;
+    }
+    Log.info(("MQTT Connected, ms: " + String(_mqttLastConnectMs)).c_str());
+
+    // Whoever listens may have missed deltas while we were away.
+    _keyframeRequested = true;
+    _configPublishRequested = true;
+    // Live data first; history starts one replay interval later.
+    _lastReplay = now;
+    // Commands are accepted in either encoding; the topic tells which one. .../command/<name>
+    // carries the command object of a single provider.
+    _mqttClient.subscribe(_topic(FORMAT_JSON, "command").c_str());
+    _mqttClient.subscribe(_topic(FORMAT_JSON, "command/+").c_str());
+    _mqttClient.subscribe(_topic(FORMAT_MSGPACK, "command").c_str());
+    _mqttClient.subscribe(_topic(FORMAT_MSGPACK, "command/+").c_str());
+}
+
+const char* DataExchanger::formatName(PayloadFormat format) {
+    return format == FORMAT_MSGPACK ? "msgpack" : "json";
+}
+
+String DataExchanger::_topic(PayloadFormat format, const char* leaf) {
+    String topic = String("device/") + _deviceId + "/";
+    if (format == FORMAT_MSGPACK) {
+        topic += "msgpack/";
+    }
+    return topic + leaf;
+}
+
+bool DataExchanger::_publishStreamed(const char* topic, size_t payloadSize, bool retained) {
+    if (!_mqttClient.beginPublish(topic, payloadSize, retained)) {
+        return false;
+    }
+
+    ChunkedPrint out(_mqttClient);
+    if (_format == FORMAT_MSGPACK) {
+        serializeMsgPack(_doc, out);
+    } else {
+        serializeJson(_doc, out);
+    }
+    out.flush();
+
+    if (out.written() != payloadSize) {
+        // endPublish() reports success whatever reached the socket, and the broker still waits
+        // for the rest of the packet; only a new connection gets the stream back in step.
+        Log.error("DataExchanger: Streamed payload size mismatch, dropping the connection.");
+        _mqttClient.disconnect();
+        return false;
+    }
+    return _mqttClient.endPublish() == 1;
+}
+
+// Fills _doc with this exchanger's entry and those of the providers due on this exchange.
+void DataExchanger::_buildPayload(bool inlineConfig, const char* trigger) {
+    _doc.clear();
+    JsonArray root = _doc.to<JsonArray>();
+
+    _addEntry(this, root, inlineConfig);
+
+    // Add the reason/trigger for the transmission to the exchanger data.
+    if (root.size() > 0) {
+        JsonObject nested = root[root.size() - 1];
+        if (nested["name"] == _name) {
+            nested["trigger"] = trigger;
+        }
+    }
+
+    // Add providers to JSON
+    for (size_t i = 0; i < _providers.size(); i++) {
+        if (_shouldSend(i)) {
+            _addEntry(_providers[i], root, inlineConfig);
         }
     }
 }
 
+void DataExchanger::_addEntry(JsonProvider* provider, JsonArray& root, bool inlineConfig) {
+    size_t entries = root.size();
+    uint32_t start = Prof.start();
+    provider->addToJson(root);
+    Prof.record(provider, PROFILE_ADD_TO_JSON, start);
+
+    uint32_t configHash = provider->getConfigFingerprint();
+    if (configHash == 0 || root.size() == entries) {
+        return;
+    }
+    JsonObject entry = root[root.size() - 1];
+    entry["configHash"] = configHash;
+    if (inlineConfig) {
+        provider->addConfigToJson(entry);
+    }
+}
+
+uint32_t DataExchanger::_configHash() {
+    StateFingerprint fp;
+    fp.add(getConfigFingerprint());
+    for (JsonProvider* provider : _providers) {
+        fp.add(provider->getConfigFingerprint());
+    }
+    return fp.value();
+}
+
+// The full settings of every provider, keyed by name like commands are. The message is retained,
+// so the server gets it on subscribe and only has to re-read it when configHash changes.
+bool DataExchanger::_publishConfig(uint32_t configHash) {
+    _doc.clear();
+    JsonObject root = _doc.to<JsonObject>();
+    root["configHash"] = configHash;
+
+    JsonObject own = root.createNestedObject(_name);
+    addConfigToJson(own);
+    for (JsonProvider* provider : _providers) {
+        if (provider->getConfigFingerprint() == 0) continue;
+        JsonObject nested = root.createNestedObject(provider->getName());
+        provider->addConfigToJson(nested);
+    }
+
+    size_t payloadSize = _format == FORMAT_MSGPACK ? measureMsgPack(_doc) : measureJson(_doc);
+    return _publishStreamed(_topic(_format, "config").c_str(), payloadSize, true);
+}
+
+bool DataExchanger::_shouldSend(size_t index) {
+    uint32_t fingerprint = _pendingFingerprints[index];
+    return _sendingKeyframe || fingerprint == 0 || fingerprint != _sentFingerprints[index];
+}
+
+// Only a delivered payload moves the baseline; after a failure the changes are sent again.
+void DataExchanger::_commitFingerprints() {
+    _sentFingerprints = _pendingFingerprints;
+    if (_sendingKeyframe) {
+        _keyframeRequested = false;
+        _exchangesSinceKeyframe = 0;
+    } else {
+        _exchangesSinceKeyframe++;
+    }
+}
+
+// Keeps the payload of a failed exchange for replay. Only MQTT has a history topic to replay to;
+// HTTP-only nodes drop it as before. Returns false so the caller still sees the failure.
+bool DataExchanger::_keepForReplay() {
+    if (_mqttUrl.length() > 0) {
+        _history.store(_doc, _format == FORMAT_MSGPACK);
+    }
+    return false;
+}
+
+// Sends the oldest buffered payloads as one message to .../history. A batch keeps the encoding
+// its payloads were captured in, whatever the current format is.
+bool DataExchanger::_replayHistory() {
+    bool binary = false;
+    size_t payloadSize = _history.beginBatch(HISTORY_BATCH_BYTES, binary);
+    if (payloadSize == 0) {
+        return true;
+    }
+
+    String topic = _topic(binary ? FORMAT_MSGPACK : FORMAT_JSON, "history");
+    if (!_mqttClient.beginPublish(topic.c_str(), payloadSize, false)) {
+        return false;
+    }
+    ChunkedPrint out(_mqttClient);
+    _history.writeBatch(out);
+    out.flush();
+    if (out.written() != payloadSize) {
+        // Like a short live publish: the batch stays buffered for the next connection.
+        Log.error("DataExchanger: History batch size mismatch, dropping the connection.");
+        _mqttClient.disconnect();
+        return false;
+    }
+    if (_mqttClient.endPublish() != 1) {
+        return false;
+    }
+
+    _history.commitBatch();
+    Log.info(("DataExchanger: History replayed, bytes left: " + String(_history.pendingBytes())).c_str());
+    return true;
+}
+
+void DataExchanger::_processAll(JsonObject& root) {
+    if (root.containsKey("_ack")) {
+        _pendingAck = root["_ack"].as<String>();
+    }
+
+    // One lookup per key in the document instead of every provider scanning it for its name.
+    for (JsonPair pair : root) {
+        if (pair.value().is<JsonObject>()) {
+            JsonObject command = pair.value().as<JsonObject>();
+            _dispatch(pair.key().c_str(), command);
+        }
+    }
+}
+
+int DataExchanger::_dispatch(const char* name, JsonObject& command) {
+    int handled = 0;
+    auto range = _routes.equal_range(_nameHash(name));
+    for (auto it = range.first; it != range.second; ++it) {
+        JsonProvider* provider = it->second;
+        // Different names can share a hash; equal names all get the command.
+        if (provider->getName() != name) continue;
+        uint32_t start = Prof.start();
+        provider->processCommand(command);
+        Prof.record(provider, PROFILE_PROCESS_COMMAND, start);
+        handled++;
+    }
+    return handled;
+}
+
+uint32_t DataExchanger::_nameHash(const char* name) {
+    uint32_t hash = 2166136261UL;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
 const String& DataExchanger::getName() {
     return _name;
 }
@@ -251,24 +727,44 @@ const String& DataExchanger::getName() {
 void DataExchanger::handleMqttMessage(char* topic, byte* payload, unsigned int length) {
     Log.info(("MQTT Message received: " + String(topic)).c_str());
 
-    // Create a null-terminated string from the payload for logging
-    char* payloadStr = (char*)malloc(length + 1);
-    memcpy(payloadStr, payload, length);
-    payloadStr[length] = '\0';
-    Log.info(payloadStr);
-    free(payloadStr);
+    String topicStr(topic);
+    String prefix = _topic(FORMAT_MSGPACK, "command");
+    bool binary = topicStr.startsWith(prefix);
+    if (!binary) {
+        prefix = _topic(FORMAT_JSON, "command");
+    }
+    // device/<id>/command/<name>: the payload is the command object of that provider alone.
+    String target = topicStr.length() > prefix.length() + 1 ? topicStr.substring(prefix.length() + 1) : String();
+
+    if (binary) {
+        Log.info(("MessagePack payload, bytes: " + String(length)).c_str());
+    } else {
+        // Create a null-terminated string from the payload for logging
+        char* payloadStr = (char*)malloc(length + 1);
+        memcpy(payloadStr, payload, length);
+        payloadStr[length] = '\0';
+        Log.info(payloadStr);
+        free(payloadStr);
+    }
 
     DynamicJsonDocument responseDoc(1024);
     // Cast payload to (const byte*) to force ArduinoJson to copy the data.
     // Otherwise, it uses pointers to the MQTT buffer, which gets overwritten when we publish the Ack.
-    DeserializationError error = deserializeJson(responseDoc, (const byte*)payload, length);
+    DeserializationError error = binary
+        ? deserializeMsgPack(responseDoc, (const byte*)payload, length)
+        : deserializeJson(responseDoc, (const byte*)payload, length);
 
     if (!error) {
         JsonObject root = responseDoc.as<JsonObject>();
-        processJson(root);
-
-        for (JsonProvider* provider : _providers) {
-            provider->processJson(root);
+        if (target.length() > 0) {
+            if (root.containsKey("_ack")) {
+                _pendingAck = root["_ack"].as<String>();
+            }
+            if (_dispatch(target.c_str(), root) == 0) {
+                Log.warn(("DataExchanger: No provider named " + target).c_str());
+            }
+        } else {
+            _processAll(root);
         }
 
         if (_pendingAck.length() > 0) {
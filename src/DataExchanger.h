@@ -4,21 +4,54 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <vector>
+#include <unordered_map>
 #include <PubSubClient.h>
 #include <WiFiClient.h>
 
 #include "JsonProvider.h"
 #include "WifiConnection.h"
+#include "TelemetryBuffer.h"
+
+// Encoding of MQTT payloads. JSON uses device/<id>/<leaf>, MessagePack device/<id>/msgpack/<leaf>.
+enum PayloadFormat {
+    FORMAT_JSON = 0,
+    FORMAT_MSGPACK
+};
+
+// Steps of an MQTT connection attempt. Each step runs on its own loop pass, so the loop keeps
+// servicing devices in between.
+enum MqttPhase {
+    MQTT_WAITING = 0,   // Until the next attempt is due
+    MQTT_RESOLVING,
+    MQTT_TCP_CONNECTING,
+    MQTT_HANDSHAKE,
+    MQTT_ONLINE
+};
 
 class DataExchanger : public JsonProvider {
 public:
+    struct Config {
+        uint32_t interval;
+        char httpUrl[128];
+        char mqttUrl[128];
+        uint32_t magic;
+    };
+
     DataExchanger(const char* name, const char* deviceId, unsigned long interval, const char* httpUrl, const char* mqttUrl, WifiConnection& wifi, int eepromOffset);
     void begin();
     void addProvider(JsonProvider* provider);
     bool exchange(bool force = false, const char* reason = "");
+    unsigned long getExchangeDelay();
+    // Moves buffered history to flash; call before a restart or deep sleep.
+    void flushHistory();
+    bool isOnline();
     void addToJson(JsonArray& doc) override;
-    void processJson(JsonObject& doc) override;
+    void addConfigToJson(JsonObject& nested) override;
+    uint32_t getConfigFingerprint() override;
+    void processCommand(JsonObject& command) override;
     void handleMqttMessage(char* topic, byte* payload, unsigned int length);
+    const String& getName() override;
+    static const char* formatName(PayloadFormat format);
 
 private:
     String _name;
@@ -27,21 +60,66 @@ private:
     unsigned long _interval;
     String _httpUrl;
     String _mqttUrl;
+    // _mqttUrl split into host and port when it is set, not on every attempt.
+    String _mqttHost;
+    uint16_t _mqttPort;
     WifiConnection& _wifi;
     std::vector<JsonProvider*> _providers;
+    // Command routing: providers (and this exchanger) by a hash of their name.
+    std::unordered_multimap<uint32_t, JsonProvider*> _routes;
     unsigned long _lastExchangeTime;
-    unsigned long _lastMqttConnectionAttempt;
+    MqttPhase _mqttPhase;
+    IPAddress _mqttAddress;
+    unsigned long _mqttNextAttempt;
+    unsigned long _mqttRetryDelay;
+    unsigned long _mqttAttemptStart;
+    // Connection metrics, published with the exchanger's state.
+    unsigned long _mqttAttempts;
+    unsigned long _mqttFailures;
+    unsigned long _mqttLastConnectMs;
+    unsigned long _mqttMaxConnectMs;
     DynamicJsonDocument _doc;
-    String _requestBody;
     String _pendingReason;
     String _pendingAck;
     bool _triggerExchange;
     bool _startupSent;
+    PayloadFormat _format;
+    // Delta telemetry: fingerprints of what each provider last published successfully, and
+    // of what the exchange in progress is sending. Parallel to _providers.
+    std::vector<uint32_t> _sentFingerprints;
+    std::vector<uint32_t> _pendingFingerprints;
+    unsigned int _keyframeInterval;
+    unsigned int _exchangesSinceKeyframe;
+    bool _keyframeRequested;
+    bool _sendingKeyframe;
+    int _unchangedProviders;
+    uint32_t _publishedConfigHash;
+    bool _configPublishRequested;
+    // Payloads that could not be delivered, replayed in batches once MQTT is back.
+    TelemetryBuffer _history;
+    unsigned long _replayInterval;
+    unsigned long _lastReplay;
     WiFiClient _wifiClient;
     PubSubClient _mqttClient;
     void loadConfig();
     void saveConfig();
-    const String& getName();
+    void _parseMqttUrl();
+    void _advanceMqttConnection(unsigned long now);
+    void _mqttAttemptFailed(unsigned long now, const char* step);
+    void _onMqttConnected(unsigned long now);
+    String _topic(PayloadFormat format, const char* leaf);
+    bool _publishStreamed(const char* topic, size_t payloadSize, bool retained = false);
+    void _buildPayload(bool inlineConfig, const char* trigger);
+    void _addEntry(JsonProvider* provider, JsonArray& root, bool inlineConfig);
+    uint32_t _configHash();
+    bool _publishConfig(uint32_t configHash);
+    bool _shouldSend(size_t index);
+    void _commitFingerprints();
+    bool _keepForReplay();
+    bool _replayHistory();
+    void _processAll(JsonObject& root);
+    int _dispatch(const char* name, JsonObject& command);
+    static uint32_t _nameHash(const char* name);
 };
 
 #endif
\ No newline at end of file
@@ -2,17 +2,45 @@
 #define DEVICE_H
 
 #include <Arduino.h>
+#include <limits.h>
 #include "JsonProvider.h"
 
 class Device : public JsonProvider {
 public:
+    // Returned by getUpdateDelay() when update() has nothing scheduled.
+    static const unsigned long UPDATE_IDLE = ULONG_MAX;
+
     virtual void begin() {}
     virtual void update() {}
     virtual void refreshState() {}
     virtual bool shouldTriggerExchange() { return false; }
     virtual void resetTriggerExchange() {}
-    virtual const String& getName() = 0;
+    // Milliseconds until update() next has work to do. 0 means the device is due now;
+    // devices that poll (the default) stay at 0 and run at the loop's base cadence.
+    virtual unsigned long getUpdateDelay() { return 0; }
+    // Optional two-phase acquisition for sensors with a conversion time. startMeasurement()
+    // triggers a conversion without waiting for it and returns false if the device has no
+    // such split. collectMeasurement() reads the result once getUpdateDelay() has run down.
+    virtual bool startMeasurement() { return false; }
+    virtual void collectMeasurement() {}
+    virtual bool measurementPending() { return false; }
+    // Deep-sleep duty cycle (see DutyCycle). saveSleepState() writes what has to outlive a deep
+    // sleep, such as filters and accumulators, to buffer and returns the byte count (at most
+    // capacity); restoreSleepState() is handed the same bytes after the wake, following begin().
+    virtual size_t saveSleepState(uint8_t* buffer, size_t capacity) { return 0; }
+    virtual void restoreSleepState(const uint8_t* buffer, size_t length) {}
+    // The values this device adds to each duty-cycle sample. The count must not change at
+    // runtime; a value that is not available is NAN.
+    virtual int getSampleCount() { return 0; }
+    virtual void getSamples(float* values) {}
     virtual ~Device() {}
+
+protected:
+    // Time left until an interval that started at 'since' has elapsed (0 if it has).
+    static unsigned long timeUntil(unsigned long since, unsigned long interval) {
+        unsigned long elapsed = millis() - since;
+        return elapsed >= interval ? 0 : interval - elapsed;
+    }
 };
 
 #endif
\ No newline at end of file
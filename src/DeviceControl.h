@@ -18,6 +18,15 @@ public:
     virtual void toggle() = 0;
     virtual bool isOn() = 0;
 
+    // Brightness for dimmable controls. Pass persist = false for intermediate levels (e.g. while
+    // ramping) to keep them out of flash; a later call with persist = true saves the final level.
+    virtual bool isDimmable() { return false; }
+    virtual int getPercentage() { return isOn() ? 100 : 0; }
+    virtual void setPercentage(int percentage, bool persist = true) {}
+    // One step of a ramp such as hold-to-dim: reaches percentage within duration ms, however long
+    // the configured fade is, and does not persist it.
+    virtual void stepPercentage(int percentage, unsigned long duration) { setPercentage(percentage, false); }
+
     void addToJson(JsonArray& doc) override {
         JsonObject nested = doc.createNestedObject();
         nested["type"] = "DeviceControl";
@@ -0,0 +1,44 @@
+#ifndef DEVICE_LIST_H
+#define DEVICE_LIST_H
+
+#include <stddef.h>
+
+// The devices of one role (see DeviceTable), as a view of a fixed array that the room's table
+// owns, so iterating it needs no heap. Spare slots at the end of the array take devices that
+// only exist at runtime, such as the OneWire buses; add() fails once they are used up.
+template <typename T>
+class DeviceList {
+    private:
+        T** _items;
+        size_t _count;
+        size_t _capacity;
+
+    public:
+        constexpr DeviceList() : _items(nullptr), _count(0), _capacity(0) {
+        }
+
+        constexpr DeviceList(T** items, size_t count, size_t capacity) : _items(items), _count(count), _capacity(capacity) {
+        }
+
+        bool add(T* item) {
+            if (_count >= _capacity) {
+                return false;
+            }
+            _items[_count++] = item;
+            return true;
+        }
+
+        T* const* begin() const {
+            return _items;
+        }
+
+        T* const* end() const {
+            return _items + _count;
+        }
+
+        size_t size() const {
+            return _count;
+        }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,142 @@
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <array>
+#include <type_traits>
+#include "Device.h"
+#include "DeviceControl.h"
+#include "DeviceList.h"
+#include "DataExchanger.h"
+#include "PwmAllocator.h"
+
+// What main.cpp does with a device of the room's table.
+enum DeviceRole : uint8_t {
+    // Started, updated and scheduled by the main loop, sampled by the duty cycle.
+    ROLE_DEVICE = 1,
+    // Turned off with the lights (at startup, on low battery); must be a DeviceControl.
+    ROLE_SWITCHABLE = 2,
+    // Published and commanded through the DataExchanger.
+    ROLE_PROVIDER = 4
+};
+
+// Spare slots in the device list for devices created at runtime: one OneWire bus per DS18B20 pin.
+static constexpr size_t RUNTIME_DEVICE_SLOTS = 4;
+
+// One device of a room's table: the object and its roles.
+template <auto& Object, uint8_t Roles>
+struct DeviceEntry {
+    using Type = std::remove_reference_t<decltype(Object)>;
+    static constexpr uint8_t ROLES = Roles;
+
+    static_assert(Roles != 0, "DeviceEntry: a device without a role does nothing");
+    static_assert(!(Roles & ROLE_DEVICE) || std::is_base_of<Device, Type>::value, "DeviceEntry: ROLE_DEVICE needs a Device");
+    static_assert(!(Roles & ROLE_SWITCHABLE) || std::is_base_of<DeviceControl, Type>::value, "DeviceEntry: ROLE_SWITCHABLE needs a DeviceControl");
+    static_assert(!(Roles & ROLE_PROVIDER) || std::is_base_of<JsonProvider, Type>::value, "DeviceEntry: ROLE_PROVIDER needs a JsonProvider");
+
+    static constexpr Type* get() {
+        return &Object;
+    }
+};
+
+// PWM channels a device may take, from the PWM_CHANNELS constant of its class; 0 if it has none.
+template <typename Type, typename = void>
+struct PwmUse {
+    static constexpr int CHANNELS = 0;
+};
+
+template <typename Type>
+struct PwmUse<Type, std::void_t<decltype(Type::PWM_CHANNELS)>> {
+    static constexpr int CHANNELS = Type::PWM_CHANNELS;
+};
+
+// The devices of a room, each listed once with the roles it has, instead of separate lists for
+// the main loop, the switchable devices and the providers that had to be kept in step by hand:
+//
+//     using Devices = DeviceTable<
+//         DeviceEntry<sysMon, ROLE_DEVICE | ROLE_PROVIDER>,
+//         DeviceEntry<light, ROLE_DEVICE | ROLE_SWITCHABLE | ROLE_PROVIDER>>;
+//     Devices::install(allDevices, switchableDevices, dataExchanger);
+//
+// The per-role lists are built at compile time into static arrays. A device listed twice, a role
+// its class cannot fill or more PWM devices than the chip has channels (counted as if every one of
+// them used PWM) do not compile. Whether their frequencies fit the timers is up to the
+// PwmAllocator at runtime.
+template <typename... Entries>
+class DeviceTable {
+    private:
+        static constexpr size_t _count(uint8_t role) {
+            return ((Entries::ROLES & role ? 1 : 0) + ... + 0);
+        }
+
+        static constexpr bool _unique() {
+            const void* objects[] = { static_cast<const void*>(Entries::get())... };
+            for (size_t i = 0; i < sizeof...(Entries); i++) {
+                for (size_t j = i + 1; j < sizeof...(Entries); j++) {
+                    if (objects[i] == objects[j]) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        static constexpr int _pwmChannels() {
+            return (PwmUse<typename Entries::Type>::CHANNELS + ... + 0);
+        }
+
+        // Checks of the whole table, in a function body because the class is only complete there.
+        static constexpr bool _valid() {
+            static_assert(sizeof...(Entries) > 0, "DeviceTable: no devices");
+            static_assert(_unique(), "DeviceTable: a device is listed twice");
+            static_assert(_pwmChannels() <= PwmAllocator::CHANNEL_COUNT, "DeviceTable: more PWM devices than PWM channels");
+            return true;
+        }
+
+        template <uint8_t Role, typename Entry, typename F>
+        static void _visit(F& f) {
+            if constexpr ((Entry::ROLES & Role) != 0) {
+                f(*Entry::get());
+            }
+        }
+
+        template <typename T, uint8_t Role, typename Entry, size_t N>
+        static constexpr void _put(std::array<T*, N>& items, size_t& count) {
+            if constexpr ((Entry::ROLES & Role) != 0) {
+                items[count++] = Entry::get();
+            }
+        }
+
+        template <typename T, uint8_t Role, size_t N>
+        static constexpr std::array<T*, N> _collect() {
+            std::array<T*, N> items = {};
+            size_t count = 0;
+            (_put<T, Role, Entries>(items, count), ...);
+            return items;
+        }
+
+        template <typename T, uint8_t Role, size_t Spare>
+        static DeviceList<T> _list() {
+            static std::array<T*, _count(Role) + Spare> items = _collect<T, Role, _count(Role) + Spare>();
+            return DeviceList<T>(items.data(), _count(Role), items.size());
+        }
+
+    public:
+        // Calls f with every device of the role, as its own type, so calls the compiler can
+        // resolve need no virtual dispatch.
+        template <uint8_t Role, typename F>
+        static void forEach(F&& f) {
+            (_visit<Role, Entries>(f), ...);
+        }
+
+        // Hands the lists to main.cpp and registers the providers; call from setupConfiguration().
+        static void install(DeviceList<Device>& devices, DeviceList<DeviceControl>& switchable, DataExchanger& exchanger) {
+            static_assert(_valid(), "DeviceTable: invalid table");
+            devices = _list<Device, ROLE_DEVICE, RUNTIME_DEVICE_SLOTS>();
+            switchable = _list<DeviceControl, ROLE_SWITCHABLE, 0>();
+            forEach<ROLE_PROVIDER>([&](JsonProvider& provider) {
+                exchanger.addProvider(&provider);
+            });
+        }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "DutyCycle.h"
+#include "Logger.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
+#include "BistableRelayControl.h"
+#include "WifiConnection.h"
+
+// Awake time of a network wake before it gives up on the server and sleeps anyway.
+static const unsigned long NETWORK_WINDOW = 20000;
+static const unsigned long MIN_SLEEP = 1000;
+// The ESP8266 cannot deep-sleep much longer than three and a half hours.
+static const unsigned long MAX_WAKE_INTERVAL = 3UL * 60 * 60 * 1000;
+static const unsigned long DEFAULT_SAMPLE_WINDOW = 2000;
+static const unsigned int MAX_PUBLISH_EVERY = 100;
+static const uint32_t RTC_MAGIC = 0xD07C7C1E;
+
+// Start of the RTC block; device state and samples follow.
+struct DutyCycleRtcHeader {
+    uint32_t magic;
+    uint32_t layout;
+    uint32_t wakes;
+    uint32_t elapsedMs;
+    uint16_t stateLength;
+    uint16_t sampleCount;
+};
+
+#ifdef ESP32
+static const size_t RTC_BLOCK_WORDS = 512;
+RTC_DATA_ATTR static uint32_t rtcBlock[RTC_BLOCK_WORDS];
+#else
+// RTC user memory is 128 words; eboot and WifiConnection's link cache come first.
+static const uint32_t RTC_BLOCK_OFFSET = WIFI_RTC_END;
+static const size_t RTC_BLOCK_WORDS = 128 - RTC_BLOCK_OFFSET;
+#endif
+static const size_t RTC_BLOCK_BYTES = RTC_BLOCK_WORDS * 4;
+
+static size_t alignWord(size_t bytes) {
+    return (bytes + 3) & ~(size_t)3;
+}
+
+DutyCycle::DutyCycle(String name, DeviceList<Device>& devices, int eepromOffset, unsigned long wakeInterval, unsigned int publishEvery)
+    : _name(name), _devices(devices), _eepromOffset(eepromOffset), _enabled(false), _wakeInterval(wakeInterval), _publishEvery(publishEvery),
+      _sampleWindow(DEFAULT_SAMPLE_WINDOW), _wokeFromSleep(false), _wakes(0), _elapsedMs(0), _columns(0) {
+}
+
+void DutyCycle::begin() {
+    loadConfig();
+    _columns = 0;
+    for (Device* device : _devices) {
+        _columns += device->getSampleCount();
+    }
+    _loadRtc();
+    if (_wokeFromSleep) {
+        Log.info(("DutyCycle: Wake " + String(_wakes) + ", samples: " + String(_sampleTimes.size())).c_str());
+    }
+}
+
+void DutyCycle::loadConfig() {
+    Config config;
+    Settings.get(_eepromOffset, config);
+    if (config.magic == 0xCAFED07C) {
+        _enabled = config.enabled;
+        if (config.wakeInterval >= 10000 && config.wakeInterval <= MAX_WAKE_INTERVAL) {
+            _wakeInterval = config.wakeInterval;
+        }
+        if (config.sampleWindow >= 500 && config.sampleWindow <= 30000) {
+            _sampleWindow = config.sampleWindow;
+        }
+        if (config.publishEvery >= 1 && config.publishEvery <= MAX_PUBLISH_EVERY) {
+            _publishEvery = config.publishEvery;
+        }
+    }
+}
+
+void DutyCycle::saveConfig() {
+    Config config = { (uint32_t)_wakeInterval, (uint32_t)_sampleWindow, (uint16_t)_publishEvery, _enabled, 0xCAFED07C };
+    Settings.put(_eepromOffset, config);
+}
+
+// Identifies the firmware's device set, so state saved by another build is not misread.
+uint32_t DutyCycle::_layoutHash() {
+    StateFingerprint fp;
+    for (Device* device : _devices) {
+        fp.add(device->getName());
+        fp.add(device->getSampleCount());
+    }
+    return fp.value();
+}
+
+size_t DutyCycle::_sampleCapacity(size_t stateLength) {
+    size_t used = sizeof(DutyCycleRtcHeader) + alignWord(stateLength);
+    size_t sampleSize = 4 + 4 * _columns;
+    return used >= RTC_BLOCK_BYTES ? 0 : (RTC_BLOCK_BYTES - used) / sampleSize;
+}
+
+void DutyCycle::_loadRtc() {
+    std::vector<uint32_t> block(RTC_BLOCK_WORDS, 0);
+#ifdef ESP32
+    memcpy(block.data(), rtcBlock, RTC_BLOCK_BYTES);
+    // Whatever happens on this wake, a reset must not find this block again.
+    rtcBlock[0] = 0;
+#else
+    if (!ESP.rtcUserMemoryRead(RTC_BLOCK_OFFSET, block.data(), RTC_BLOCK_BYTES)) {
+        return;
+    }
+    uint32_t invalid = 0;
+    ESP.rtcUserMemoryWrite(RTC_BLOCK_OFFSET, &invalid, sizeof(invalid));
+#endif
+
+    const uint8_t* bytes = (const uint8_t*)block.data();
+    DutyCycleRtcHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.magic != RTC_MAGIC || header.layout != _layoutHash() || header.sampleCount > _sampleCapacity(header.stateLength)) {
+        return;
+    }
+
+    _wokeFromSleep = true;
+    _wakes = header.wakes;
+    _elapsedMs = header.elapsedMs;
+    const uint8_t* state = bytes + sizeof(header);
+    _sleepState.assign(state, state + header.stateLength);
+
+    const uint8_t* sample = state + alignWord(header.stateLength);
+    for (uint16_t i = 0; i < header.sampleCount; i++) {
+        uint32_t time;
+        memcpy(&time, sample, 4);
+        _sampleTimes.push_back(time);
+        for (int c = 0; c < _columns; c++) {
+            float value;
+            memcpy(&value, sample + 4 + 4 * c, 4);
+            _samples.push_back(value);
+        }
+        sample += 4 + 4 * _columns;
+    }
+}
+
+void DutyCycle::_storeRtc(uint32_t sleepMs) {
+    std::vector<uint32_t> block(RTC_BLOCK_WORDS, 0);
+    uint8_t* bytes = (uint8_t*)block.data();
+    size_t capacity = RTC_BLOCK_BYTES - sizeof(DutyCycleRtcHeader);
+
+    // [length][state] per device, in device order.
+    uint8_t* state = bytes + sizeof(DutyCycleRtcHeader);
+    size_t stateLength = 0;
+    for (Device* device : _devices) {
+        if (stateLength + 1 > capacity) break;
+        size_t room = capacity - stateLength - 1;
+        size_t length = device->saveSleepState(state + stateLength + 1, room < 255 ? room : 255);
+        state[stateLength] = (uint8_t)length;
+        stateLength += 1 + length;
+    }
+
+    // The oldest samples give way if the batch no longer fits.
+    size_t fit = _sampleCapacity(stateLength);
+    if (_sampleTimes.size() > fit) {
+        size_t drop = _sampleTimes.size() - fit;
+        Log.warn(("DutyCycle: Sample batch full, dropping " + String((unsigned long)drop)).c_str());
+        _sampleTimes.erase(_sampleTimes.begin(), _sampleTimes.begin() + drop);
+        _samples.erase(_samples.begin(), _samples.begin() + drop * _columns);
+    }
+    uint8_t* sample = state + alignWord(stateLength);
+    for (size_t i = 0; i < _sampleTimes.size(); i++) {
+        memcpy(sample, &_sampleTimes[i], 4);
+        memcpy(sample + 4, &_samples[i * _columns], 4 * _columns);
+        sample += 4 + 4 * _columns;
+    }
+
+    DutyCycleRtcHeader header = { RTC_MAGIC, _layoutHash(), _wakes + 1, (uint32_t)(_elapsedMs + millis() + sleepMs), (uint16_t)stateLength, (uint16_t)_sampleTimes.size() };
+    memcpy(bytes, &header, sizeof(header));
+
+#ifdef ESP32
+    memcpy(rtcBlock, block.data(), RTC_BLOCK_BYTES);
+#else
+    ESP.rtcUserMemoryWrite(RTC_BLOCK_OFFSET, block.data(), RTC_BLOCK_BYTES);
+#endif
+}
+
+void DutyCycle::restoreDevices() {
+    size_t offset = 0;
+    for (Device* device : _devices) {
+        if (offset >= _sleepState.size()) break;
+        size_t length = _sleepState[offset];
+        if (offset + 1 + length > _sleepState.size()) break;
+        if (length > 0) {
+            device->restoreSleepState(&_sleepState[offset + 1], length);
+        }
+        offset += 1 + length;
+    }
+    _sleepState.clear();
+}
+
+bool DutyCycle::isEnabled() {
+    return _enabled;
+}
+
+bool DutyCycle::isNetworkWake() {
+    return !_enabled || !_wokeFromSleep || _wakes % _publishEvery == 0;
+}
+
+bool DutyCycle::sampleWindowElapsed() {
+    return millis() >= _sampleWindow;
+}
+
+bool DutyCycle::networkWindowElapsed() {
+    return millis() >= NETWORK_WINDOW;
+}
+
+void DutyCycle::recordSample() {
+    if (_columns == 0) return;
+    _sampleTimes.push_back(_elapsedMs + millis());
+    size_t start = _samples.size();
+    _samples.resize(start + _columns);
+    float* values = &_samples[start];
+    for (Device* device : _devices) {
+        int count = device->getSampleCount();
+        if (count > 0) {
+            device->getSamples(values);
+            values += count;
+        }
+    }
+}
+
+void DutyCycle::markDelivered() {
+    _sampleTimes.clear();
+    _samples.clear();
+}
+
+void DutyCycle::sleep() {
+    unsigned long awake = millis();
+    unsigned long sleepMs = _wakeInterval > awake + MIN_SLEEP ? _wakeInterval - awake : MIN_SLEEP;
+    _storeRtc(sleepMs);
+    Settings.flush();
+    BistableRelayControl::finishPulses();
+    Log.info(("DutyCycle: Sleeping for ms: " + String(sleepMs)).c_str());
+
+    // 1000ULL keeps the conversion to microseconds in 64 bits.
+#ifdef ESP32
+    esp_deep_sleep(sleepMs * 1000ULL);
+#else
+    ESP.deepSleep(sleepMs * 1000ULL);
+#endif
+}
+
+void DutyCycle::addToJson(JsonArray& doc) {
+    JsonObject nested = doc.createNestedObject();
+    nested["type"] = "System";
+    nested["subtype"] = "DutyCycle";
+    nested["name"] = _name;
+    nested["enabled"] = _enabled;
+    nested["wakes"] = _wakes;
+
+    if (_sampleTimes.empty()) {
+        return;
+    }
+    // Values per device, in the order they appear in each sample after its age.
+    JsonObject columns = nested.createNestedObject("columns");
+    for (Device* device : _devices) {
+        int count = device->getSampleCount();
+        if (count > 0) {
+            columns[device->getName()] = count;
+        }
+    }
+    uint32_t now = _elapsedMs + millis();
+    JsonArray samples = nested.createNestedArray("samples");
+    for (size_t i = 0; i < _sampleTimes.size(); i++) {
+        JsonArray sample = samples.createNestedArray();
+        sample.add(now - _sampleTimes[i]);
+        for (int c = 0; c < _columns; c++) {
+            sample.add(_samples[i * _columns + c]);
+        }
+    }
+}
+
+void DutyCycle::addConfigToJson(JsonObject& nested) {
+    nested["enabled"] = _enabled;
+    nested["wakeInterval"] = _wakeInterval;
+    nested["publishEvery"] = _publishEvery;
+    nested["sampleWindow"] = _sampleWindow;
+}
+
+uint32_t DutyCycle::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_enabled);
+    fp.add(_wakeInterval);
+    fp.add(_publishEvery);
+    fp.add(_sampleWindow);
+    return fp.value();
+}
+
+void DutyCycle::processCommand(JsonObject& command) {
+    bool changed = false;
+
+    if (command.containsKey("setEnabled")) {
+        bool enabled = command["setEnabled"].as<bool>();
+        if (enabled != _enabled) {
+            _enabled = enabled;
+            markDelivered();
+            changed = true;
+            Log.info(enabled ? "DutyCycle: Enabled" : "DutyCycle: Disabled");
+        }
+    }
+    if (command.containsKey("setWakeInterval")) {
+        unsigned long interval = command["setWakeInterval"].as<unsigned long>();
+        if (interval >= 10000 && interval <= MAX_WAKE_INTERVAL) {
+            _wakeInterval = interval;
+            changed = true;
+        }
+    }
+    if (command.containsKey("setPublishEvery")) {
+        unsigned int every = command["setPublishEvery"].as<unsigned int>();
+        if (every >= 1 && every <= MAX_PUBLISH_EVERY) {
+            _publishEvery = every;
+            changed = true;
+        }
+    }
+    if (command.containsKey("setSampleWindow")) {
+        unsigned long window = command["setSampleWindow"].as<unsigned long>();
+        if (window >= 500 && window <= 30000) {
+            _sampleWindow = window;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        saveConfig();
+    }
+}
+
+const String& DutyCycle::getName() {
+    return _name;
+}
\ No newline at end of file
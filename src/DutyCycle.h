@@ -0,0 +1,80 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "Device.h"
+#include "DeviceList.h"
+#include "JsonProvider.h"
+
+// Opt-in deep-sleep mode for battery nodes while nothing needs the node awake. Each wake takes
+// one sample of every device that offers values (Device::getSampleCount()) and goes back to
+// sleep without WiFi; every publishEvery-th wake brings up the network and publishes the
+// samples collected since, as this provider's "samples". Device state that must outlive the
+// sleeps (filters, accumulators) and the sample batch are kept in RTC memory.
+//
+// main.cpp drives it: isNetworkWake() tells whether this wake may use WiFi, recordSample() and
+// sleep() end the wake. On the ESP8266, deep sleep needs GPIO16 wired to RST.
+class DutyCycle : public JsonProvider {
+    private:
+        String _name;
+        DeviceList<Device>& _devices;
+        int _eepromOffset;
+        bool _enabled;
+        unsigned long _wakeInterval;
+        unsigned int _publishEvery;
+        unsigned long _sampleWindow;
+
+        // Carried over from the previous wake.
+        bool _wokeFromSleep;
+        uint32_t _wakes;
+        uint32_t _elapsedMs;
+        std::vector<uint8_t> _sleepState;
+        // The batch: per sample, the elapsed time followed by _columns values.
+        int _columns;
+        std::vector<uint32_t> _sampleTimes;
+        std::vector<float> _samples;
+
+        uint32_t _layoutHash();
+        size_t _sampleCapacity(size_t stateLength);
+        void _loadRtc();
+        void _storeRtc(uint32_t sleepMs);
+        void loadConfig();
+        void saveConfig();
+
+    public:
+        struct Config {
+            uint32_t wakeInterval;
+            uint32_t sampleWindow;
+            uint16_t publishEvery;
+            bool enabled;
+            uint32_t magic;
+        };
+
+        DutyCycle(String name, DeviceList<Device>& devices, int eepromOffset, unsigned long wakeInterval = 60000, unsigned int publishEvery = 10);
+        // Call after setupConfiguration(), before the devices' begin().
+        void begin();
+        // Hands the devices their state from before the sleep; call after their begin().
+        void restoreDevices();
+
+        bool isEnabled();
+        // False on wakes that only sample; those must not touch WiFi.
+        bool isNetworkWake();
+        // A sample-only wake has given the devices enough time for a reading.
+        bool sampleWindowElapsed();
+        // A network wake has tried long enough to reach the server.
+        bool networkWindowElapsed();
+        void recordSample();
+        // The samples went out; called after a successful exchange.
+        void markDelivered();
+        // Saves device state and the batch to RTC memory and deep-sleeps until the next wake.
+        void sleep();
+
+        void addToJson(JsonArray& doc) override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
+        void processCommand(JsonObject& command) override;
+        const String& getName() override;
+};
+
+#endif
\ No newline at end of file
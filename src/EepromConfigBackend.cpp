@@ -0,0 +1,43 @@
+#include "EepromConfigBackend.h"
+#include "Logger.h"
+#include <EEPROM.h>
+
+const char* EepromConfigBackend::getName() {
+    return "eeprom";
+}
+
+bool EepromConfigBackend::begin(size_t size) {
+    EEPROM.begin(size);
+    return true;
+}
+
+bool EepromConfigBackend::load(std::vector<uint8_t>& image) {
+    for (size_t i = 0; i < image.size(); i++) {
+        image[i] = EEPROM.read(i);
+    }
+    // Whatever is in there is the config; an erased sector reads as 0xFF, which no device's
+    // magic number matches.
+    return true;
+}
+
+bool EepromConfigBackend::commit(const std::vector<uint8_t>& image, const std::vector<ConfigRecord>& records) {
+    for (const ConfigRecord& record : records) {
+        for (size_t i = 0; i < record.length; i++) {
+            EEPROM.write(record.offset + i, image[record.offset + i]);
+        }
+    }
+    if (!EEPROM.commit()) {
+        Log.error("EepromConfigBackend: EEPROM commit failed");
+        return false;
+    }
+    return true;
+}
+
+bool EepromConfigBackend::store(const std::vector<uint8_t>& image) {
+    ConfigRecord all = { 0, (uint16_t)image.size() };
+    return commit(image, std::vector<ConfigRecord>{ all });
+}
+
+void EepromConfigBackend::end() {
+    EEPROM.end();
+}
\ No newline at end of file
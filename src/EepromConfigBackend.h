@@ -0,0 +1,18 @@
+#ifndef EEPROM_CONFIG_BACKEND_H
+#define EEPROM_CONFIG_BACKEND_H
+
+#include "ConfigBackend.h"
+
+// The emulated EEPROM. Every commit rewrites the whole sector (on the ESP32, the whole NVS
+// blob); used when no other backend is available, and as the source of the first migration.
+class EepromConfigBackend : public ConfigBackend {
+    public:
+        const char* getName() override;
+        bool begin(size_t size) override;
+        bool load(std::vector<uint8_t>& image) override;
+        bool commit(const std::vector<uint8_t>& image, const std::vector<ConfigRecord>& records) override;
+        bool store(const std::vector<uint8_t>& image) override;
+        void end() override;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef EEPROM_LAYOUT_H
+#define EEPROM_LAYOUT_H
+
+#include <stddef.h>
+#include <tuple>
+#include <type_traits>
+
+// The EEPROM emulation of both cores keeps its image in a single flash sector.
+static constexpr size_t EEPROM_MAX_SIZE = 4096;
+
+// A layout record kept at a fixed offset: where a deployed node already has it.
+template <size_t Offset, typename Record>
+struct EepromAt {};
+
+// Compile-time EEPROM map of a room config. Lists the config record of every device that saves
+// settings. A record given as EepromAt<offset, Record> stays at that offset; any other record is
+// placed right after the records listed before it. Records that overlap, and a layout that
+// outgrows the sector, do not compile.
+//
+//     enum EepromRecord { EE_EXCHANGER, EE_LIGHT, EE_WIFI };
+//     using Layout = EepromLayout<EepromAt<2, DataExchanger::Config>, EepromAt<300, RelayControl::Config>, WifiLinkCache>;
+//     static RelayControl light("light", 32, false, true, 200, Layout::offset<EE_LIGHT, RelayControl::Config>());
+//
+// offset() also checks that the record at the index has the given type, which catches a list
+// that got out of step with the enum. Moving a record loses its settings on deployed nodes (its
+// magic number no longer matches), so records that nodes already have are pinned at their
+// offsets and new ones are appended.
+template <typename... Records>
+class EepromLayout {
+    private:
+        template <typename Record>
+        struct _Entry {
+            using Type = Record;
+            static constexpr size_t PIN = (size_t)-1;
+        };
+
+        template <size_t Offset, typename Record>
+        struct _Entry<EepromAt<Offset, Record>> {
+            using Type = Record;
+            static constexpr size_t PIN = Offset;
+        };
+
+        static constexpr size_t _sizes[sizeof...(Records) + 1] = { sizeof(typename _Entry<Records>::Type)..., 0 };
+        static constexpr size_t _pins[sizeof...(Records) + 1] = { _Entry<Records>::PIN..., 0 };
+
+        // Walks the records in order: returns the offset of the one at the index or, with end set,
+        // the end of the furthest one.
+        static constexpr size_t _place(size_t index, bool end) {
+            size_t furthest = 0;
+            for (size_t i = 0; i < sizeof...(Records); i++) {
+                size_t start = _pins[i] != (size_t)-1 ? _pins[i] : furthest;
+                if (i == index && !end) {
+                    return start;
+                }
+                if (start + _sizes[i] > furthest) {
+                    furthest = start + _sizes[i];
+                }
+            }
+            return furthest;
+        }
+
+        static constexpr size_t _start(size_t index) {
+            return _place(index, false);
+        }
+
+        static constexpr size_t _end() {
+            return _place(sizeof...(Records), true);
+        }
+
+        static constexpr bool _disjoint() {
+            for (size_t i = 0; i < sizeof...(Records); i++) {
+                for (size_t j = i + 1; j < sizeof...(Records); j++) {
+                    if (_start(i) < _start(j) + _sizes[j] && _start(j) < _start(i) + _sizes[i]) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Checks of the whole layout. They sit in a function body because the class is only
+        // complete there; every offset() and size() call instantiates them.
+        static constexpr bool _valid() {
+            static_assert(sizeof...(Records) > 0, "EepromLayout: no records");
+            static_assert(std::conjunction<std::is_trivially_copyable<typename _Entry<Records>::Type>...>::value,
+                          "EepromLayout: records are stored with memcpy and must be trivially copyable");
+            static_assert(_disjoint(), "EepromLayout: records overlap");
+            static_assert(_end() <= EEPROM_MAX_SIZE, "EepromLayout: records do not fit into one flash sector");
+            return true;
+        }
+
+    public:
+        static constexpr size_t COUNT = sizeof...(Records);
+
+        template <size_t Index, typename Record>
+        static constexpr int offset() {
+            static_assert(_valid(), "EepromLayout: invalid layout");
+            static_assert(Index < COUNT, "EepromLayout: no record at this index");
+            static_assert(std::is_same<Record, typename _Entry<typename std::tuple_element<Index, std::tuple<Records...>>::type>::Type>::value,
+                          "EepromLayout: the record at this index has a different type");
+            return (int)_start(Index);
+        }
+
+        // Bytes up to the end of the last record; the size of the config image (Settings.begin()).
+        static constexpr size_t size() {
+            static_assert(_valid(), "EepromLayout: invalid layout");
+            return _end();
+        }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "Fader.h"
+
+// Fixed point scale for fade progress (1.0 == FADE_SCALE).
+static const long FADE_SCALE = 1024;
+
+Fader::Fader() : _from(0), _to(0), _value(0), _startTime(0), _duration(0), _curve(FADE_LINEAR), _active(false) {
+}
+
+void Fader::start(int from, int to, unsigned long duration, FadeCurve curve) {
+    _from = from;
+    _to = to;
+    _value = from;
+    _startTime = millis();
+    _duration = duration;
+    _curve = curve;
+    _active = (from != to && duration > 0);
+    if (!_active) {
+        _value = to;
+    }
+}
+
+void Fader::stop() {
+    _active = false;
+}
+
+long Fader::_ease(long t) {
+    switch (_curve) {
+        case FADE_EASE_IN:
+            return t * t / FADE_SCALE;
+        case FADE_EASE_OUT:
+            return FADE_SCALE - (FADE_SCALE - t) * (FADE_SCALE - t) / FADE_SCALE;
+        case FADE_EASE_IN_OUT:
+            if (t < FADE_SCALE / 2) {
+                return 2 * t * t / FADE_SCALE;
+            }
+            return FADE_SCALE - 2 * (FADE_SCALE - t) * (FADE_SCALE - t) / FADE_SCALE;
+        default:
+            return t;
+    }
+}
+
+int Fader::update() {
+    if (!_active) {
+        return _value;
+    }
+
+    unsigned long elapsed = millis() - _startTime;
+    if (elapsed >= _duration) {
+        _value = _to;
+        _active = false;
+        return _value;
+    }
+
+    long t = (long)((unsigned long long)elapsed * FADE_SCALE / _duration);
+    _value = _from + (int)((long)(_to - _from) * _ease(t) / FADE_SCALE);
+    return _value;
+}
+
+bool Fader::isActive() {
+    return _active;
+}
+
+int Fader::getValue() {
+    return _value;
+}
+
+int Fader::getTarget() {
+    return _to;
+}
+
+const char* Fader::curveName(FadeCurve curve) {
+    switch (curve) {
+        case FADE_EASE_IN: return "easeIn";
+        case FADE_EASE_OUT: return "easeOut";
+        case FADE_EASE_IN_OUT: return "easeInOut";
+        default: return "linear";
+    }
+}
+
+bool Fader::parseCurve(JsonVariant value, FadeCurve& curve) {
+    // Accept either the curve name or its numeric index.
+    if (value.is<int>()) {
+        int index = value.as<int>();
+        if (index >= 0 && index < FADE_CURVE_COUNT) {
+            curve = (FadeCurve)index;
+            return true;
+        }
+        return false;
+    }
+
+    String name = value.as<String>();
+    for (int i = 0; i < FADE_CURVE_COUNT; i++) {
+        if (name == curveName((FadeCurve)i)) {
+            curve = (FadeCurve)i;
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef FADER_H
+#define FADER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+enum FadeCurve {
+    FADE_LINEAR = 0,
+    FADE_EASE_IN,
+    FADE_EASE_OUT,
+    FADE_EASE_IN_OUT,
+    FADE_CURVE_COUNT
+};
+
+// Time-based fade between two duty values. Nothing blocks: the owner calls update()
+// from its own update() and writes the returned value to the hardware.
+class Fader {
+    private:
+        int _from;
+        int _to;
+        int _value;
+        unsigned long _startTime;
+        unsigned long _duration;
+        FadeCurve _curve;
+        bool _active;
+
+        long _ease(long progress);
+
+    public:
+        Fader();
+        void start(int from, int to, unsigned long duration, FadeCurve curve = FADE_LINEAR);
+        void stop();
+        // Advances the fade to the current time and returns the duty value to apply.
+        int update();
+        bool isActive();
+        int getValue();
+        int getTarget();
+
+        static const char* curveName(FadeCurve curve);
+        static bool parseCurve(JsonVariant value, FadeCurve& curve);
+};
+
+#endif
\ No newline at end of file
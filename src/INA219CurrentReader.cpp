@@ -1,14 +1,8 @@
 #include "INA219CurrentReader.h"
-#include <EEPROM.h>
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 #include "Logger.h"
 
-struct INA219Config {
-    int intervalMs;
-    int calibrationMode;
-    int averagingSamples;
-    uint32_t magic;
-};
-
 INA219CurrentReader::INA219CurrentReader(String name, uint8_t addr, int intervalMs, int eepromOffset, int averagingSamples)
     : _name(name), _addr(addr), _intervalMs(intervalMs), _eepromOffset(eepromOffset),
       _calibrationMode(0), _averagingSamples(averagingSamples), _ina(addr), _wire(&Wire), _available(false), _currentSum(0.0), _readingsCount(0), _lastReadingTime(0), _lastReconnectAttempt(0),
@@ -99,6 +93,13 @@ void INA219CurrentReader::update() {
     }
 }
 
+unsigned long INA219CurrentReader::getUpdateDelay() {
+    if (!_available) {
+        return timeUntil(_lastReconnectAttempt, 120000);
+    }
+    return timeUntil(_lastReadingTime, (unsigned long)_intervalMs);
+}
+
 float INA219CurrentReader::getAverageCurrent() {
     if (_readingsCount == 0) {
         return 0.0;
@@ -111,16 +112,6 @@ void INA219CurrentReader::addToJson(JsonArray& doc) {
     nested["type"] = "Sensor";
     nested["subtype"] = "INA219";
     nested["name"] = _name;
-    nested["interval"] = _intervalMs;
-    if (_isExternalShunt) {
-        nested["shuntType"] = "external";
-        nested["shuntOhms"] = _shuntOhms;
-        nested["maxAmps"] = _maxAmps;
-    } else {
-        nested["shuntType"] = "internal";
-        nested["calibrationMode"] = _calibrationMode;
-    }
-    nested["averagingSamples"] = _averagingSamples;
     nested["available"] = _available;
 
     if (_available) {
@@ -140,13 +131,75 @@ void INA219CurrentReader::addToJson(JsonArray& doc) {
     _readingsCount = 0;
 }
 
+uint32_t INA219CurrentReader::getStateFingerprint() {
+    // Bus voltage is not cached and would need an I2C read; it is left to the keyframes.
+    StateFingerprint fp;
+    fp.add(_available);
+    fp.add(getConfigFingerprint());
+    fp.add(getAverageCurrent(), 5.0f);
+    return fp.value();
+}
+
+void INA219CurrentReader::addConfigToJson(JsonObject& nested) {
+    nested["interval"] = _intervalMs;
+    if (_isExternalShunt) {
+        nested["shuntType"] = "external";
+        nested["shuntOhms"] = _shuntOhms;
+        nested["maxAmps"] = _maxAmps;
+    } else {
+        nested["shuntType"] = "internal";
+        nested["calibrationMode"] = _calibrationMode;
+    }
+    nested["averagingSamples"] = _averagingSamples;
+}
+
+uint32_t INA219CurrentReader::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_intervalMs);
+    fp.add(_isExternalShunt);
+    fp.add(_shuntOhms, 0.0001f);
+    fp.add(_maxAmps, 0.01f);
+    fp.add(_calibrationMode);
+    fp.add(_averagingSamples);
+    return fp.value();
+}
+
+// The accumulators cover the whole publish period, so they carry over duty-cycle sleeps.
+struct INA219SleepState {
+    double currentSum;
+    int readingsCount;
+};
+
+size_t INA219CurrentReader::saveSleepState(uint8_t* buffer, size_t capacity) {
+    INA219SleepState state = { _currentSum, _readingsCount };
+    if (capacity < sizeof(state)) return 0;
+    memcpy(buffer, &state, sizeof(state));
+    return sizeof(state);
+}
+
+void INA219CurrentReader::restoreSleepState(const uint8_t* buffer, size_t length) {
+    INA219SleepState state;
+    if (length != sizeof(state)) return;
+    memcpy(&state, buffer, sizeof(state));
+    _currentSum = state.currentSum;
+    _readingsCount = state.readingsCount;
+}
+
+int INA219CurrentReader::getSampleCount() {
+    return 1;
+}
+
+void INA219CurrentReader::getSamples(float* values) {
+    values[0] = _available && _readingsCount > 0 ? getAverageCurrent() : NAN;
+}
+
 const String& INA219CurrentReader::getName() {
     return _name;
 }
 
 void INA219CurrentReader::loadConfig() {
-    INA219Config config;
-    EEPROM.get(_eepromOffset, config);
+    Config config;
+    Settings.get(_eepromOffset, config);
     
     // Magic updated to 0xDEADBEF1 to force reset of config structure if upgrading from old version
     if (config.magic == 0xDEADBEF1) {
@@ -164,43 +217,39 @@ void INA219CurrentReader::loadConfig() {
 
 void INA219CurrentReader::saveConfig() {
     if (_eepromOffset < 0) return;
-    INA219Config config = { _intervalMs, _calibrationMode, _averagingSamples, 0xDEADBEF1 };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Config config = { _intervalMs, _calibrationMode, _averagingSamples, 0xDEADBEF1 };
+    Settings.put(_eepromOffset, config);
 }
 
-void INA219CurrentReader::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
-        bool changed = false;
+void INA219CurrentReader::processCommand(JsonObject& config) {
+    bool changed = false;
 
-        if (config.containsKey("setInterval")) {
-            _intervalMs = config["setInterval"].as<int>();
+    if (config.containsKey("setInterval")) {
+        _intervalMs = config["setInterval"].as<int>();
+        changed = true;
+    }
+    if (config.containsKey("setCalibrationMode")) {
+        int mode = config["setCalibrationMode"].as<int>();
+        // 0: 32V 2A (Default)
+        // 1: 32V 1A
+        // 2: 16V 400mA
+        if (mode >= 0 && mode <= 2) {
+            _calibrationMode = mode;
+            applyCalibration();
             changed = true;
         }
-        if (config.containsKey("setCalibrationMode")) {
-            int mode = config["setCalibrationMode"].as<int>();
-            // 0: 32V 2A (Default)
-            // 1: 32V 1A
-            // 2: 16V 400mA
-            if (mode >= 0 && mode <= 2) {
-                _calibrationMode = mode;
-                applyCalibration();
-                changed = true;
-            }
-        }
-        if (config.containsKey("setAveragingSamples")) {
-            int samples = config["setAveragingSamples"].as<int>();
-            if (samples == 1 || samples == 2 || samples == 4 || samples == 8 || samples == 16 || samples == 32 || samples == 64 || samples == 128) {
-                _averagingSamples = samples;
-                applyCalibration(); // Re-apply calibration and averaging
-                changed = true;
-            }
+    }
+    if (config.containsKey("setAveragingSamples")) {
+        int samples = config["setAveragingSamples"].as<int>();
+        if (samples == 1 || samples == 2 || samples == 4 || samples == 8 || samples == 16 || samples == 32 || samples == 64 || samples == 128) {
+            _averagingSamples = samples;
+            applyCalibration(); // Re-apply calibration and averaging
+            changed = true;
         }
+    }
 
-        if (changed) {
-            saveConfig();
-        }
+    if (changed) {
+        saveConfig();
     }
 }
 
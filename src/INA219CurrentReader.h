@@ -9,6 +9,13 @@
 
 class INA219CurrentReader : public Device {
 public:
+    struct Config {
+        int intervalMs;
+        int calibrationMode;
+        int averagingSamples;
+        uint32_t magic;
+    };
+
     // Constructor
     // name: The key used in the JSON output
     // addr: I2C address of the INA219 (default 0x40)
@@ -21,8 +28,16 @@ public:
     void begin() override;
     
     void update() override;
+    unsigned long getUpdateDelay() override;
     void addToJson(JsonArray& doc) override;
-    void processJson(JsonObject& doc) override;
+    uint32_t getStateFingerprint() override;
+    void addConfigToJson(JsonObject& nested) override;
+    uint32_t getConfigFingerprint() override;
+    void processCommand(JsonObject& command) override;
+    size_t saveSleepState(uint8_t* buffer, size_t capacity) override;
+    void restoreSleepState(const uint8_t* buffer, size_t length) override;
+    int getSampleCount() override;
+    void getSamples(float* values) override;
     const String& getName() override;
 
     // Configure the sensor to use an external shunt
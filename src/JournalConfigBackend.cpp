@@ -0,0 +1,177 @@
+#include "JournalConfigBackend.h"
+#include "Logger.h"
+#include <LittleFS.h>
+
+static const char* JOURNAL_PATH = "/config.jnl";
+static const char* COMPACT_PATH = "/config.tmp";
+static const uint32_t JOURNAL_MAGIC = 0x434A4E31;
+// The journal is compacted once it is this many times the size of a snapshot.
+static const size_t COMPACT_FACTOR = 4;
+
+struct JournalFileHeader {
+    uint32_t magic;
+    uint16_t imageSize;
+    uint16_t reserved;
+};
+
+// Followed by length bytes of the image, starting at offset. The CRC covers offset, length and
+// the data.
+struct JournalEntryHeader {
+    uint16_t offset;
+    uint16_t length;
+    uint32_t crc;
+};
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t entryCrc(uint16_t offset, uint16_t length, const uint8_t* data) {
+    uint16_t fields[2] = { offset, length };
+    return crc32(crc32(0, (const uint8_t*)fields, sizeof(fields)), data, length);
+}
+
+JournalConfigBackend::JournalConfigBackend() : _journalSize(0), _snapshotSize(0), _compactions(0), _discardedEntries(0) {
+}
+
+const char* JournalConfigBackend::getName() {
+    return "journal";
+}
+
+bool JournalConfigBackend::begin(size_t size) {
+    _snapshotSize = sizeof(JournalFileHeader) + sizeof(JournalEntryHeader) + size;
+#ifdef ESP32
+    return LittleFS.begin(true);
+#else
+    return LittleFS.begin();
+#endif
+}
+
+bool JournalConfigBackend::load(std::vector<uint8_t>& image) {
+    // A compaction replaces the journal only after the snapshot is complete, so a snapshot
+    // without a journal is good, and one next to a journal may be torn.
+    if (!LittleFS.exists(JOURNAL_PATH) && LittleFS.exists(COMPACT_PATH)) {
+        LittleFS.rename(COMPACT_PATH, JOURNAL_PATH);
+    }
+    if (LittleFS.exists(COMPACT_PATH)) {
+        LittleFS.remove(COMPACT_PATH);
+    }
+    if (!LittleFS.exists(JOURNAL_PATH)) {
+        return false;
+    }
+
+    if (!_loadJournal(image)) {
+        // Later appends would land behind the damage and never be read; start a clean journal.
+        Log.warn(("JournalConfigBackend: Journal damaged, dropped entries: " + String(_discardedEntries)).c_str());
+        store(image);
+    }
+    Log.info(("JournalConfigBackend: Loaded config journal, bytes: " + String((unsigned long)_journalSize)).c_str());
+    return true;
+}
+
+// Replays the entries into the image. Returns false if the file ends in a torn or corrupt entry.
+bool JournalConfigBackend::_loadJournal(std::vector<uint8_t>& image) {
+    File file = LittleFS.open(JOURNAL_PATH, "r");
+    if (!file) {
+        return false;
+    }
+    JournalFileHeader header;
+    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != JOURNAL_MAGIC) {
+        file.close();
+        _discardedEntries++;
+        _journalSize = 0;
+        return false;
+    }
+    _journalSize = sizeof(header);
+
+    std::vector<uint8_t> data;
+    bool clean = true;
+    while (file.available() > 0) {
+        JournalEntryHeader entry;
+        if (file.read((uint8_t*)&entry, sizeof(entry)) != sizeof(entry) || entry.length == 0) {
+            clean = false;
+            break;
+        }
+        data.resize(entry.length);
+        if (file.read(data.data(), entry.length) != entry.length || entryCrc(entry.offset, entry.length, data.data()) != entry.crc) {
+            clean = false;
+            break;
+        }
+        // Entries written by a build with a larger layout may reach past the image.
+        if (entry.offset < image.size()) {
+            size_t length = min((size_t)entry.length, image.size() - entry.offset);
+            memcpy(image.data() + entry.offset, data.data(), length);
+        }
+        _journalSize += sizeof(entry) + entry.length;
+    }
+    if (!clean) {
+        _discardedEntries++;
+    }
+    file.close();
+    return clean;
+}
+
+bool JournalConfigBackend::_appendEntry(File& file, const std::vector<uint8_t>& image, uint16_t offset, uint16_t length) {
+    const uint8_t* data = image.data() + offset;
+    JournalEntryHeader entry = { offset, length, entryCrc(offset, length, data) };
+    if (file.write((const uint8_t*)&entry, sizeof(entry)) != sizeof(entry) || file.write(data, length) != length) {
+        return false;
+    }
+    _journalSize += sizeof(entry) + length;
+    return true;
+}
+
+bool JournalConfigBackend::commit(const std::vector<uint8_t>& image, const std::vector<ConfigRecord>& records) {
+    File file = LittleFS.open(JOURNAL_PATH, "a");
+    bool ok = (bool)file;
+    for (size_t i = 0; ok && i < records.size(); i++) {
+        ok = _appendEntry(file, image, records[i].offset, records[i].length);
+    }
+    if (file) {
+        file.close();
+    }
+    // A failed append may have left a partial entry; a fresh snapshot holds everything.
+    return ok || store(image);
+}
+
+bool JournalConfigBackend::store(const std::vector<uint8_t>& image) {
+    File file = LittleFS.open(COMPACT_PATH, "w");
+    if (!file) {
+        Log.error("JournalConfigBackend: Cannot create the compacted journal");
+        return false;
+    }
+    JournalFileHeader header = { JOURNAL_MAGIC, (uint16_t)image.size(), 0 };
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    _journalSize = sizeof(header);
+    ok = ok && _appendEntry(file, image, 0, image.size());
+    file.close();
+    if (!ok) {
+        Log.error("JournalConfigBackend: Writing the compacted journal failed");
+        LittleFS.remove(COMPACT_PATH);
+        return false;
+    }
+
+    LittleFS.remove(JOURNAL_PATH);
+    LittleFS.rename(COMPACT_PATH, JOURNAL_PATH);
+    _compactions++;
+    return true;
+}
+
+void JournalConfigBackend::update(const std::vector<uint8_t>& image) {
+    if (_journalSize > COMPACT_FACTOR * _snapshotSize) {
+        store(image);
+    }
+}
+
+void JournalConfigBackend::addToJson(JsonObject& nested) {
+    nested["configJournalBytes"] = _journalSize;
+    nested["configCompactions"] = _compactions;
+    nested["configDiscardedEntries"] = _discardedEntries;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef JOURNAL_CONFIG_BACKEND_H
+#define JOURNAL_CONFIG_BACKEND_H
+
+#include "ConfigBackend.h"
+#include <FS.h>
+
+// An append-only journal file on LittleFS. Commits append the changed records, each with a CRC;
+// loading replays the entries in order and stops at the first torn or corrupt one, so a power
+// cut mid-commit loses at most that commit and never touches other records. Once the journal
+// has grown, it is compacted between commits into a single snapshot of the image. LittleFS
+// spreads the writes over its blocks.
+class JournalConfigBackend : public ConfigBackend {
+    private:
+        size_t _journalSize;
+        size_t _snapshotSize;
+        uint32_t _compactions;
+        uint32_t _discardedEntries;
+
+        bool _loadJournal(std::vector<uint8_t>& image);
+        bool _appendEntry(File& file, const std::vector<uint8_t>& image, uint16_t offset, uint16_t length);
+
+    public:
+        JournalConfigBackend();
+        const char* getName() override;
+        bool begin(size_t size) override;
+        bool load(std::vector<uint8_t>& image) override;
+        bool commit(const std::vector<uint8_t>& image, const std::vector<ConfigRecord>& records) override;
+        // Rewrites the journal as a single snapshot of the image.
+        bool store(const std::vector<uint8_t>& image) override;
+        void update(const std::vector<uint8_t>& image) override;
+        void addToJson(JsonObject& nested) override;
+};
+
+#endif
\ No newline at end of file
@@ -7,8 +7,40 @@
 class JsonProvider {
 public:
     virtual void addToJson(JsonArray& doc) = 0;
-    virtual void processJson(JsonObject& doc) {}
+    // Commands arrive keyed by provider name; DataExchanger looks the name up and passes only
+    // the provider's own object.
+    virtual void processCommand(JsonObject& command) {}
+    virtual const String& getName() = 0;
+    // Cheap summary of the state addToJson() would publish. DataExchanger leaves a provider out
+    // of non-keyframe exchanges while this is unchanged; 0 means publish on every exchange.
+    virtual uint32_t getStateFingerprint() { return 0; }
+    // Settings, as opposed to measurements. addConfigToJson() adds them to an object that
+    // DataExchanger publishes to the retained config topic; getConfigFingerprint() hashes them and
+    // goes out with every measurement as "configHash". 0 means the provider has no settings.
+    virtual void addConfigToJson(JsonObject& nested) {}
+    virtual uint32_t getConfigFingerprint() { return 0; }
     virtual ~JsonProvider() {}
+
+    // Set by DataExchanger while it builds a payload for a binary encoding (MessagePack).
+    static void setBinaryFormat(bool binary) { _binaryFormat() = binary; }
+    static bool isBinaryFormat() { return _binaryFormat(); }
+
+protected:
+    // Adds a number with a fixed count of decimals. JSON gets the exact text; binary encodings
+    // get a plain float, because raw text would be copied into them verbatim and corrupt them.
+    static void setFixed(JsonObject& nested, const char* key, float value, unsigned char decimals) {
+        if (isBinaryFormat()) {
+            nested[key] = value;
+        } else {
+            nested[key] = serialized(String(value, decimals));
+        }
+    }
+
+private:
+    static bool& _binaryFormat() {
+        static bool binary = false;
+        return binary;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "LoopScheduler.h"
+#ifndef ESP32
+#include <coredecls.h>
+#endif
+
+volatile bool LoopScheduler::_wakeRequested = false;
+#ifdef ESP32
+volatile TaskHandle_t LoopScheduler::_loopTask = nullptr;
+#endif
+
+LoopScheduler::LoopScheduler(DeviceList<Device>& devices) : _devices(devices), _passes(0), _updates(0), _wakeups(0) {
+}
+
+void IRAM_ATTR LoopScheduler::wake() {
+    _wakeRequested = true;
+#ifdef ESP32
+    if (_loopTask) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(_loopTask, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+#else
+    // Resumes the loop suspended in esp_delay().
+    esp_schedule();
+#endif
+}
+
+void LoopScheduler::sleep(unsigned long ms) {
+#ifdef ESP32
+    // Block on a task notification; the loop task still idles (and light sleeps) like in delay().
+    _loopTask = xTaskGetCurrentTaskHandle();
+    // A wake that arrived while the loop was busy leaves a notification behind; consume it either way.
+    ulTaskNotifyTake(pdTRUE, _wakeRequested ? 0 : pdMS_TO_TICKS(ms));
+#else
+    // Suspend like delay() does, in one piece; esp_schedule() in wake() resumes the loop early.
+    esp_delay(ms, []() { return !_wakeRequested; });
+#endif
+    if (_wakeRequested) {
+        _wakeRequested = false;
+        _wakeups++;
+    }
+}
+
+void LoopScheduler::beginPass() {
+    _passes++;
+}
+
+bool LoopScheduler::isDue(Device* device) {
+    if (device->getUpdateDelay() > 0) {
+        return false;
+    }
+    _updates++;
+    return true;
+}
+
+unsigned long LoopScheduler::getSleepTime(unsigned long pollInterval, unsigned long maxSleep) {
+    unsigned long sleepTime = maxSleep;
+
+    for (auto* device : _devices) {
+        unsigned long delay = device->getUpdateDelay();
+        if (delay == 0) {
+            // Polling device, or one that is already due again.
+            delay = pollInterval;
+        }
+        if (delay < sleepTime) {
+            sleepTime = delay;
+        }
+    }
+    return sleepTime;
+}
+
+unsigned long LoopScheduler::getPasses() {
+    return _passes;
+}
+
+unsigned long LoopScheduler::getUpdates() {
+    return _updates;
+}
+
+unsigned long LoopScheduler::getWakeups() {
+    return _wakeups;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef LOOP_SCHEDULER_H
+#define LOOP_SCHEDULER_H
+
+#include <Arduino.h>
+#include "Device.h"
+#include "DeviceList.h"
+
+// Decides which devices run on a loop pass and how long the loop may sleep afterwards,
+// based on the deadlines the devices report through Device::getUpdateDelay().
+class LoopScheduler {
+  private:
+    DeviceList<Device>& _devices;
+    unsigned long _passes;
+    unsigned long _updates;
+    unsigned long _wakeups;
+
+    static volatile bool _wakeRequested;
+#ifdef ESP32
+    static volatile TaskHandle_t _loopTask;
+#endif
+
+  public:
+    LoopScheduler(DeviceList<Device>& devices);
+    // True if the device has work due on this pass. Counts the pass/update for stats.
+    bool isDue(Device* device);
+    void beginPass();
+    // Milliseconds until the earliest device deadline. Polling devices (delay 0) wake
+    // the loop every pollInterval; the result never exceeds maxSleep.
+    unsigned long getSleepTime(unsigned long pollInterval, unsigned long maxSleep);
+    // Sleeps for up to ms milliseconds, returning early if wake() is called meanwhile.
+    void sleep(unsigned long ms);
+    // Ends the current sleep() early. Safe to call from an interrupt handler.
+    static void IRAM_ATTR wake();
+    unsigned long getPasses();
+    unsigned long getUpdates();
+    unsigned long getWakeups();
+};
+
+#endif
\ No newline at end of file
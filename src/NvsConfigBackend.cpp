@@ -0,0 +1,114 @@
+#ifdef ESP32
+
+#include "NvsConfigBackend.h"
+#include "Logger.h"
+
+static const char* NVS_NAMESPACE = "config";
+static const char* INDEX_KEY = "index";
+static const char* IMAGE_KEY = "image";
+
+const char* NvsConfigBackend::getName() {
+    return "nvs";
+}
+
+void NvsConfigBackend::_key(uint16_t offset, char* key) {
+    snprintf(key, 8, "r%04x", offset);
+}
+
+bool NvsConfigBackend::begin(size_t size) {
+    return _prefs.begin(NVS_NAMESPACE, false);
+}
+
+bool NvsConfigBackend::load(std::vector<uint8_t>& image) {
+    if (!_prefs.isKey(IMAGE_KEY) && !_prefs.isKey(INDEX_KEY)) {
+        return false;
+    }
+
+    size_t imageLength = _prefs.isKey(IMAGE_KEY) ? _prefs.getBytesLength(IMAGE_KEY) : 0;
+    if (imageLength > 0) {
+        std::vector<uint8_t> stored(imageLength);
+        _prefs.getBytes(IMAGE_KEY, stored.data(), imageLength);
+        memcpy(image.data(), stored.data(), min(imageLength, image.size()));
+    }
+
+    _index.resize(_prefs.isKey(INDEX_KEY) ? _prefs.getBytesLength(INDEX_KEY) / sizeof(ConfigRecord) : 0);
+    if (!_index.empty()) {
+        _prefs.getBytes(INDEX_KEY, _index.data(), _index.size() * sizeof(ConfigRecord));
+    }
+    char key[8];
+    for (const ConfigRecord& record : _index) {
+        // Records of a build with a larger layout may reach past the image.
+        if (record.offset + record.length > image.size()) {
+            continue;
+        }
+        _key(record.offset, key);
+        _prefs.getBytes(key, image.data() + record.offset, record.length);
+    }
+    Log.info(("NvsConfigBackend: Loaded config records: " + String((unsigned long)_index.size())).c_str());
+    return true;
+}
+
+bool NvsConfigBackend::_saveIndex() {
+    // Preferences does not store empty blobs; right after store() there is nothing to list.
+    if (_index.empty()) {
+        return true;
+    }
+    size_t length = _index.size() * sizeof(ConfigRecord);
+    return _prefs.putBytes(INDEX_KEY, _index.data(), length) == length;
+}
+
+bool NvsConfigBackend::commit(const std::vector<uint8_t>& image, const std::vector<ConfigRecord>& records) {
+    bool ok = true;
+    bool indexChanged = false;
+    char key[8];
+    for (const ConfigRecord& record : records) {
+        _key(record.offset, key);
+        if (_prefs.putBytes(key, image.data() + record.offset, record.length) != record.length) {
+            Log.error(("NvsConfigBackend: Writing failed for key: " + String(key)).c_str());
+            ok = false;
+            continue;
+        }
+
+        bool known = false;
+        for (ConfigRecord& entry : _index) {
+            if (entry.offset == record.offset) {
+                if (entry.length != record.length) {
+                    entry.length = record.length;
+                    indexChanged = true;
+                }
+                known = true;
+                break;
+            }
+        }
+        if (!known) {
+            _index.push_back(record);
+            indexChanged = true;
+        }
+    }
+    if (indexChanged && !_saveIndex()) {
+        Log.error("NvsConfigBackend: Writing the index failed");
+        ok = false;
+    }
+    return ok;
+}
+
+bool NvsConfigBackend::store(const std::vector<uint8_t>& image) {
+    _prefs.clear();
+    _index.clear();
+    if (_prefs.putBytes(IMAGE_KEY, image.data(), image.size()) != image.size()) {
+        Log.error("NvsConfigBackend: Writing the image failed");
+        return false;
+    }
+    return _saveIndex();
+}
+
+void NvsConfigBackend::end() {
+    _prefs.end();
+}
+
+void NvsConfigBackend::addToJson(JsonObject& nested) {
+    nested["configNvsKeys"] = _index.size();
+    nested["configNvsFreeEntries"] = _prefs.freeEntries();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef NVS_CONFIG_BACKEND_H
+#define NVS_CONFIG_BACKEND_H
+
+#ifdef ESP32
+
+#include "ConfigBackend.h"
+#include <Preferences.h>
+
+// The ESP32's NVS, one key per config record, so a commit writes only the records that changed
+// instead of the whole EEPROM blob. NVS does its own wear leveling across its pages.
+//
+// NVS cannot list its keys, so an index key lists the records written so far. A migrated image
+// is stored under one key of its own and loaded first; the per-record keys written since
+// override it.
+class NvsConfigBackend : public ConfigBackend {
+    private:
+        Preferences _prefs;
+        std::vector<ConfigRecord> _index;
+
+        static void _key(uint16_t offset, char* key);
+        bool _saveIndex();
+
+    public:
+        const char* getName() override;
+        bool begin(size_t size) override;
+        bool load(std::vector<uint8_t>& image) override;
+        bool commit(const std::vector<uint8_t>& image, const std::vector<ConfigRecord>& records) override;
+        bool store(const std::vector<uint8_t>& image) override;
+        void end() override;
+        void addToJson(JsonObject& nested) override;
+};
+
+#endif
+
+#endif
\ No newline at end of file
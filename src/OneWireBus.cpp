@@ -0,0 +1,190 @@
+#include "OneWireBus.h"
+#include "StateFingerprint.h"
+#include "Logger.h"
+
+// A finished conversion is reused by other sensors on the bus for this long.
+static const unsigned long CONVERSION_FRESH_TIME = 2000;
+// How often the bus is searched for newly attached sensors.
+static const unsigned long RESCAN_INTERVAL = 600000;
+// How often unclaimed sensors are read.
+static const unsigned long UNCLAIMED_READ_INTERVAL = 60000;
+
+OneWireBus::OneWireBus(int pin)
+    : _oneWire(pin), _sensors(&_oneWire), _name("oneWire" + String(pin)), _pin(pin), _begun(false),
+      _hasConversion(false), _conversionStart(0), _conversionTime(0), _lastScanTime(0),
+      _lastUnclaimedRead(0), _unclaimedReadPending(false) {
+}
+
+std::vector<OneWireBus*>& OneWireBus::_registry() {
+    // Function-local so that buses can be requested from other static constructors.
+    static std::vector<OneWireBus*> buses;
+    return buses;
+}
+
+OneWireBus* OneWireBus::forPin(int pin) {
+    for (auto* bus : _registry()) {
+        if (bus->_pin == pin) {
+            return bus;
+        }
+    }
+    OneWireBus* bus = new OneWireBus(pin);
+    _registry().push_back(bus);
+    return bus;
+}
+
+const std::vector<OneWireBus*>& OneWireBus::all() {
+    return _registry();
+}
+
+void OneWireBus::begin() {
+    if (_begun) return;
+    _begun = true;
+
+    _sensors.begin();
+    // Don't block in requestTemperatures(); callers wait out getConversionDelay() instead.
+    _sensors.setWaitForConversion(false);
+    _scan();
+    // Read unclaimed sensors on the first pass.
+    _lastUnclaimedRead = millis() - UNCLAIMED_READ_INTERVAL;
+}
+
+void OneWireBus::_scan() {
+    _lastScanTime = millis();
+    _sensors.begin();
+
+    // Append new ROMs only, so the cached addresses of claimed sensors stay put.
+    int count = _sensors.getDeviceCount();
+    for (int i = 0; i < count; i++) {
+        Sensor sensor;
+        if (!_sensors.getAddress(sensor.address, i)) continue;
+
+        bool known = false;
+        for (const Sensor& existing : _roms) {
+            if (memcmp(existing.address, sensor.address, sizeof(DeviceAddress)) == 0) {
+                known = true;
+                break;
+            }
+        }
+        if (!known) {
+            sensor.claimed = false;
+            sensor.tempC = NAN;
+            _roms.push_back(sensor);
+            Log.info(("OneWire bus " + _name + " found sensor " + romToString(sensor.address)).c_str());
+        }
+    }
+}
+
+bool OneWireBus::claim(int index, uint8_t* address) {
+    begin();
+    if (index < 0 || index >= (int)_roms.size()) {
+        return false;
+    }
+    memcpy(address, _roms[index].address, sizeof(DeviceAddress));
+    _roms[index].claimed = true;
+    return true;
+}
+
+bool OneWireBus::_isConverting() {
+    return _hasConversion && millis() - _conversionStart < _conversionTime;
+}
+
+void OneWireBus::requestConversion() {
+    if (_hasConversion && millis() - _conversionStart < _conversionTime + CONVERSION_FRESH_TIME) {
+        // Running or recent enough to share.
+        return;
+    }
+    _sensors.requestTemperatures();
+    _conversionTime = _sensors.millisToWaitForConversion();
+    _conversionStart = millis();
+    _hasConversion = true;
+}
+
+unsigned long OneWireBus::getConversionDelay() {
+    if (!_hasConversion) return 0;
+    return timeUntil(_conversionStart, _conversionTime);
+}
+
+float OneWireBus::getTempC(const uint8_t* address) {
+    // Reads the scratchpad by address; no bus search.
+    return _sensors.getTempC(address);
+}
+
+bool OneWireBus::_hasUnclaimed() {
+    for (const Sensor& sensor : _roms) {
+        if (!sensor.claimed) return true;
+    }
+    return false;
+}
+
+void OneWireBus::update() {
+    if (_unclaimedReadPending) {
+        if (getConversionDelay() == 0) {
+            _unclaimedReadPending = false;
+            for (Sensor& sensor : _roms) {
+                if (!sensor.claimed) {
+                    float tempC = getTempC(sensor.address);
+                    sensor.tempC = (tempC >= -70 && tempC <= 84) ? tempC : NAN;
+                }
+            }
+        }
+    } else if (_hasUnclaimed() && millis() - _lastUnclaimedRead >= UNCLAIMED_READ_INTERVAL) {
+        _lastUnclaimedRead = millis();
+        requestConversion();
+        _unclaimedReadPending = true;
+    }
+
+    // Don't search while a conversion is running.
+    if (!_isConverting() && millis() - _lastScanTime >= RESCAN_INTERVAL) {
+        _scan();
+    }
+}
+
+unsigned long OneWireBus::getUpdateDelay() {
+    unsigned long next = timeUntil(_lastScanTime, RESCAN_INTERVAL);
+    if (_unclaimedReadPending) {
+        next = min(next, getConversionDelay());
+    } else if (_hasUnclaimed()) {
+        next = min(next, timeUntil(_lastUnclaimedRead, UNCLAIMED_READ_INTERVAL));
+    }
+    return next;
+}
+
+void OneWireBus::addToJson(JsonArray& doc) {
+    for (const Sensor& sensor : _roms) {
+        if (sensor.claimed) continue;
+
+        JsonObject nested = doc.createNestedObject();
+        nested["type"] = "Sensor";
+        nested["subtype"] = "DS18B20";
+        nested["name"] = romToString(sensor.address);
+        nested["bus"] = _name;
+        nested["available"] = !isnan(sensor.tempC);
+        if (!isnan(sensor.tempC)) {
+            nested["tempC"] = sensor.tempC;
+            nested["tempF"] = DallasTemperature::toFahrenheit(sensor.tempC);
+        }
+    }
+}
+
+uint32_t OneWireBus::getStateFingerprint() {
+    StateFingerprint fp;
+    for (const Sensor& sensor : _roms) {
+        if (sensor.claimed) continue;
+        fp.add(romToString(sensor.address));
+        fp.add(sensor.tempC, 0.1f);
+    }
+    return fp.value();
+}
+
+const String& OneWireBus::getName() {
+    return _name;
+}
+
+String OneWireBus::romToString(const uint8_t* address) {
+    String rom;
+    for (int i = 0; i < 8; i++) {
+        if (address[i] < 0x10) rom += "0";
+        rom += String(address[i], HEX);
+    }
+    return rom;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef ONE_WIRE_BUS_H
+#define ONE_WIRE_BUS_H
+
+#include <Arduino.h>
+#include <vector>
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include "Device.h"
+
+// One instance per OneWire pin, shared by all DS18B20s on that pin. ROM addresses are
+// enumerated once and cached; a single conversion serves every sensor on the bus.
+// Sensors that are on the bus but not claimed by a configured DS18B20 are published
+// under their ROM id, so adding a sensor needs no code change.
+class OneWireBus : public Device {
+    private:
+        struct Sensor {
+            DeviceAddress address;
+            bool claimed;
+            float tempC;
+        };
+
+        OneWire _oneWire;
+        DallasTemperature _sensors;
+        String _name;
+        int _pin;
+        bool _begun;
+        std::vector<Sensor> _roms;
+
+        bool _hasConversion;
+        unsigned long _conversionStart;
+        unsigned long _conversionTime;
+        unsigned long _lastScanTime;
+        unsigned long _lastUnclaimedRead;
+        bool _unclaimedReadPending;
+
+        OneWireBus(int pin);
+        void _scan();
+        bool _hasUnclaimed();
+        bool _isConverting();
+        static std::vector<OneWireBus*>& _registry();
+
+    public:
+        // Returns the bus for the pin, creating it on first use.
+        static OneWireBus* forPin(int pin);
+        static const std::vector<OneWireBus*>& all();
+
+        void begin() override;
+        void update() override;
+        unsigned long getUpdateDelay() override;
+
+        // Copies the ROM address of the sensor at the given enumeration index and marks it as claimed.
+        bool claim(int index, uint8_t* address);
+        // Starts a conversion for all sensors on the bus, unless one is running or the last result is still fresh.
+        void requestConversion();
+        // Milliseconds until the current conversion is done (0 if it is).
+        unsigned long getConversionDelay();
+        float getTempC(const uint8_t* address);
+
+        void addToJson(JsonArray& doc) override;
+        uint32_t getStateFingerprint() override;
+        const String& getName() override;
+
+        static String romToString(const uint8_t* address);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "Profiler.h"
+
+Profiler Prof;
+
+// Upper bound on samples kept by one capture. They all go into a single payload.
+static const size_t MAX_CAPTURE_SAMPLES = 48;
+static const unsigned long MAX_CAPTURE_DURATION = 60000;
+
+Profiler::Profiler()
+    : _windowStart(0), _passStart(0), _sleepStart(0), _plannedSleep(0), _sleeping(false), _thresholdUs(1000),
+      _capturing(false), _captureStart(0), _captureDuration(0) {
+    _reset(_loopWork);
+    _reset(_wakeJitter);
+}
+
+void Profiler::_reset(Stats& stats) {
+    memset(&stats, 0, sizeof(stats));
+    stats.minUs = UINT32_MAX;
+}
+
+void Profiler::_add(Stats& stats, uint32_t us) {
+    stats.count++;
+    stats.sumUs += us;
+    if (us < stats.minUs) stats.minUs = us;
+    if (us > stats.maxUs) stats.maxUs = us;
+
+    int bucket = 0;
+    while (bucket < HISTOGRAM_BUCKETS - 1 && us >= (4UL << bucket)) {
+        bucket++;
+    }
+    if (stats.histogram[bucket] < UINT16_MAX) {
+        stats.histogram[bucket]++;
+    }
+}
+
+uint32_t Profiler::_percentile(const Stats& stats, int percent) {
+    // Upper bound of the bucket holding the percentile, which can't be more than the max.
+    uint32_t target = (stats.count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        seen += stats.histogram[bucket];
+        if (seen >= target) {
+            uint32_t bound = bucket < HISTOGRAM_BUCKETS - 1 ? (4UL << bucket) : stats.maxUs;
+            return bound < stats.maxUs ? bound : stats.maxUs;
+        }
+    }
+    return stats.maxUs;
+}
+
+int Profiler::_slotFor(JsonProvider* provider) {
+    for (size_t i = 0; i < _slots.size(); i++) {
+        if (_slots[i].provider == provider) {
+            return i;
+        }
+    }
+    Slot slot;
+    slot.provider = provider;
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        _reset(slot.phases[phase]);
+    }
+    _slots.push_back(slot);
+    return _slots.size() - 1;
+}
+
+void Profiler::record(JsonProvider* provider, ProfilePhase phase, uint32_t startCycles) {
+    uint32_t cycles = ESP.getCycleCount() - startCycles;
+    int slot = _slotFor(provider);
+    _add(_slots[slot].phases[phase], cycles / ESP.getCpuFreqMHz());
+
+    if (_capturing) {
+        if (millis() - _captureStart >= _captureDuration || _capture.size() >= MAX_CAPTURE_SAMPLES) {
+            _capturing = false;
+        } else {
+            Sample sample = { (uint8_t)slot, (uint8_t)phase, cycles };
+            _capture.push_back(sample);
+        }
+    }
+}
+
+void Profiler::beginPass() {
+    uint32_t now = micros();
+    if (_sleeping) {
+        // How much later than planned the loop woke up. Early wake-ups (button interrupts) count as 0.
+        uint32_t slept = now - _sleepStart;
+        uint32_t planned = _plannedSleep * 1000;
+        _add(_wakeJitter, slept > planned ? slept - planned : 0);
+        _sleeping = false;
+    }
+    _passStart = now;
+}
+
+void Profiler::endPass(unsigned long plannedSleep) {
+    uint32_t now = micros();
+    _add(_loopWork, now - _passStart);
+    _sleepStart = now;
+    _plannedSleep = plannedSleep;
+    _sleeping = true;
+}
+
+void Profiler::setThreshold(uint32_t us) {
+    _thresholdUs = us;
+}
+
+void Profiler::startCapture(unsigned long durationMs) {
+    if (durationMs == 0 || durationMs > MAX_CAPTURE_DURATION) durationMs = MAX_CAPTURE_DURATION;
+    _capture.clear();
+    _capture.reserve(MAX_CAPTURE_SAMPLES);
+    _captureStart = millis();
+    _captureDuration = durationMs;
+    _capturing = true;
+}
+
+bool Profiler::isCapturing() {
+    if (_capturing && millis() - _captureStart >= _captureDuration) {
+        _capturing = false;
+    }
+    return _capturing;
+}
+
+bool Profiler::hasReport() {
+    if (!_capture.empty() && !isCapturing()) {
+        return true;
+    }
+    for (Slot& slot : _slots) {
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+            if (slot.phases[phase].count > 0 && slot.phases[phase].maxUs >= _thresholdUs) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+const char* Profiler::phaseName(ProfilePhase phase) {
+    switch (phase) {
+        case PROFILE_UPDATE: return "update";
+        case PROFILE_ADD_TO_JSON: return "addToJson";
+        case PROFILE_PROCESS_COMMAND: return "processCommand";
+        default: return "unknown";
+    }
+}
+
+void Profiler::_addStats(JsonArray array, const Stats& stats) {
+    // [count, min, mean, p99, max] in microseconds
+    array.add(stats.count);
+    array.add(stats.count > 0 ? stats.minUs : 0);
+    array.add(stats.count > 0 ? stats.sumUs / stats.count : 0);
+    array.add(_percentile(stats, 99));
+    array.add(stats.maxUs);
+}
+
+void Profiler::addToJson(JsonObject& nested) {
+    JsonObject timing = nested.createNestedObject("timing");
+    timing["windowMs"] = millis() - _windowStart;
+    timing["fields"] = "count,min,mean,p99,max (us)";
+    _addStats(timing.createNestedArray("loopWork"), _loopWork);
+    _addStats(timing.createNestedArray("wakeJitter"), _wakeJitter);
+    timing["thresholdUs"] = _thresholdUs;
+
+    // Only devices that got slow enough to matter, to keep the payload small.
+    JsonObject slow = timing.createNestedObject("slow");
+    for (Slot& slot : _slots) {
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+            Stats& stats = slot.phases[phase];
+            if (stats.count > 0 && stats.maxUs >= _thresholdUs) {
+                String key = slot.provider->getName() + "." + phaseName((ProfilePhase)phase);
+                _addStats(slow.createNestedArray(key), stats);
+            }
+            _reset(stats);
+        }
+    }
+    _reset(_loopWork);
+    _reset(_wakeJitter);
+    _windowStart = millis();
+
+    if (isCapturing()) {
+        timing["captureActive"] = true;
+    } else if (!_capture.empty()) {
+        // Raw cycle counts in the order they were taken, per device and phase; cycles / cpuMHz gives microseconds.
+        JsonObject capture = timing.createNestedObject("capture");
+        capture["cpuMHz"] = ESP.getCpuFreqMHz();
+        JsonObject samples = capture.createNestedObject("samples");
+        for (const Sample& sample : _capture) {
+            String key = _slots[sample.slot].provider->getName() + "." + phaseName((ProfilePhase)sample.phase);
+            JsonArray cycles = samples.containsKey(key) ? samples[key].as<JsonArray>() : samples.createNestedArray(key);
+            cycles.add(sample.cycles);
+        }
+        _capture.clear();
+        _capture.shrink_to_fit();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include "JsonProvider.h"
+
+enum ProfilePhase {
+    PROFILE_UPDATE = 0,
+    PROFILE_ADD_TO_JSON,
+    PROFILE_PROCESS_COMMAND,
+    PROFILE_PHASE_COUNT
+};
+
+// Times device calls with the CPU cycle counter and keeps per-device statistics (min, mean,
+// p99 from a log2 histogram, max) plus loop work time and wake-up jitter. Statistics cover
+// the window since the last addToJson(). A capture records individual samples at full
+// resolution for a limited time.
+//
+//     uint32_t start = Prof.start();
+//     device->update();
+//     Prof.record(device, PROFILE_UPDATE, start);
+class Profiler {
+    public:
+        static const int HISTOGRAM_BUCKETS = 16;
+
+    private:
+        struct Stats {
+            uint32_t count;
+            uint32_t minUs;
+            uint32_t maxUs;
+            uint32_t sumUs;
+            // Bucket i counts durations below (4 << i) us; the last bucket takes the rest.
+            uint16_t histogram[HISTOGRAM_BUCKETS];
+        };
+
+        struct Slot {
+            JsonProvider* provider;
+            Stats phases[PROFILE_PHASE_COUNT];
+        };
+
+        struct Sample {
+            uint8_t slot;
+            uint8_t phase;
+            uint32_t cycles;
+        };
+
+        std::vector<Slot> _slots;
+        Stats _loopWork;
+        Stats _wakeJitter;
+        unsigned long _windowStart;
+        uint32_t _passStart;
+        uint32_t _sleepStart;
+        unsigned long _plannedSleep;
+        bool _sleeping;
+        uint32_t _thresholdUs;
+
+        std::vector<Sample> _capture;
+        bool _capturing;
+        unsigned long _captureStart;
+        unsigned long _captureDuration;
+
+        int _slotFor(JsonProvider* provider);
+        static void _reset(Stats& stats);
+        static void _add(Stats& stats, uint32_t us);
+        static uint32_t _percentile(const Stats& stats, int percent);
+        static void _addStats(JsonArray array, const Stats& stats);
+
+    public:
+        Profiler();
+
+        uint32_t start() { return ESP.getCycleCount(); }
+        void record(JsonProvider* provider, ProfilePhase phase, uint32_t startCycles);
+
+        // Called at the top of loop() and right before it goes to sleep for plannedSleep ms.
+        void beginPass();
+        void endPass(unsigned long plannedSleep);
+
+        // Devices whose max exceeds this are published individually (0 = all).
+        void setThreshold(uint32_t us);
+        void startCapture(unsigned long durationMs);
+        bool isCapturing();
+        // True if the next addToJson() has more than the loop statistics to report.
+        bool hasReport();
+
+        // Adds the window's statistics (and a finished capture) to the object and starts a new window.
+        void addToJson(JsonObject& nested);
+        static const char* phaseName(ProfilePhase phase);
+};
+
+extern Profiler Prof;
+
+#endif
\ No newline at end of file
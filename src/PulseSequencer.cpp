@@ -0,0 +1,84 @@
+#include "PulseSequencer.h"
+#include <limits.h>
+
+PulseSequencer::PulseSequencer() : _nextId(1) {
+}
+
+unsigned long PulseSequencer::enqueue(int pin, int rail, unsigned long duration) {
+    Pulse pulse = { _nextId++, pin, rail, duration, 0, false };
+    _pulses.push_back(pulse);
+    update();
+    return pulse.id;
+}
+
+bool PulseSequencer::_railBusy(int rail) {
+    for (const Pulse& pulse : _pulses) {
+        if (pulse.active && pulse.rail == rail) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PulseSequencer::update() {
+    unsigned long now = millis();
+
+    // Release coils whose pulse has run its course.
+    for (auto it = _pulses.begin(); it != _pulses.end();) {
+        if (it->active && now - it->startTime >= it->duration) {
+            digitalWrite(it->pin, LOW);
+            it = _pulses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Start queued pulses in order, at most one per rail.
+    for (Pulse& pulse : _pulses) {
+        if (!pulse.active && !_railBusy(pulse.rail)) {
+            digitalWrite(pulse.pin, HIGH);
+            pulse.startTime = now;
+            pulse.active = true;
+        }
+    }
+}
+
+bool PulseSequencer::isPending(unsigned long id) {
+    for (const Pulse& pulse : _pulses) {
+        if (pulse.id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PulseSequencer::hasPending() {
+    return !_pulses.empty();
+}
+
+void PulseSequencer::finish() {
+    while (hasPending()) {
+        update();
+        unsigned long wait = getUpdateDelay();
+        if (wait != ULONG_MAX) {
+            delay(wait);
+        }
+    }
+}
+
+unsigned long PulseSequencer::getUpdateDelay() {
+    unsigned long next = ULONG_MAX;
+    unsigned long now = millis();
+
+    // Queued pulses only wait on active ones, so the earliest active pulse sets the pace.
+    for (const Pulse& pulse : _pulses) {
+        if (pulse.active) {
+            unsigned long elapsed = now - pulse.startTime;
+            unsigned long remaining = elapsed >= pulse.duration ? 0 : pulse.duration - elapsed;
+            if (remaining < next) {
+                next = remaining;
+            }
+        }
+    }
+    return next;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef PULSE_SEQUENCER_H
+#define PULSE_SEQUENCER_H
+
+#include <Arduino.h>
+#include <vector>
+
+// Queues coil pulses for latching relays and runs them without blocking. Pulses that share
+// a supply rail are fired one after the other; pulses on different rails may overlap.
+class PulseSequencer {
+    private:
+        struct Pulse {
+            unsigned long id;
+            int pin;
+            int rail;
+            unsigned long duration;
+            unsigned long startTime;
+            bool active;
+        };
+
+        std::vector<Pulse> _pulses;
+        unsigned long _nextId;
+
+        bool _railBusy(int rail);
+
+    public:
+        PulseSequencer();
+        // Queues a HIGH pulse on the pin and returns its id. The pulse starts right away if its rail is free.
+        unsigned long enqueue(int pin, int rail, unsigned long duration);
+        // Ends finished pulses and starts the next queued pulse on each free rail.
+        void update();
+        // True while the pulse is queued or still driving the coil.
+        bool isPending(unsigned long id);
+        bool hasPending();
+        // Runs every queued pulse to its end, blocking. For right before the chip sleeps or
+        // restarts, which would otherwise cut a pulse short or drop it.
+        void finish();
+        // Milliseconds until the sequencer next has work to do (ULONG_MAX when idle).
+        unsigned long getUpdateDelay();
+};
+
+#endif
\ No newline at end of file
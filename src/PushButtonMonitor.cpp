@@ -1,7 +1,21 @@
 #include "PushButtonMonitor.h"
+#include "StateFingerprint.h"
+#include "LoopScheduler.h"
+
+static const unsigned long DEBOUNCE_TIME = 50;
+static const unsigned long LONG_PRESS_TIME = 600;
+// Hold-to-dim: RAMP_STEP percent every RAMP_STEP_INTERVAL ms, between RAMP_MIN and 100 percent.
+static const unsigned long RAMP_STEP_INTERVAL = 50;
+static const int RAMP_STEP = 2;
+static const int RAMP_MIN = 5;
+static const unsigned long MAX_DOUBLE_PRESS_WINDOW = 1000;
 
 PushButtonMonitor::PushButtonMonitor(String name, int pin, bool activeLow) 
-    : _pin(pin), _name(name), _activeLow(activeLow), _lastReading(false), _state(false), _lastDebounceTime(0), _localAction(true), _targetDevice(nullptr), _triggerExchange(false) {
+    : _pin(pin), _name(name), _activeLow(activeLow), _localAction(true), _targetDevice(nullptr), _triggerExchange(false), _useInterrupt(false),
+      _head(0), _tail(0), _overflows(0), _lastPolledLevel(false),
+      _candidatePending(false), _candidateState(false), _candidateTime(0), _state(false),
+      _pressTime(0), _releaseTime(0), _holding(false), _secondPress(false), _shortPending(false), _rampDirection(1), _lastRampStep(0),
+      _doublePressWindow(0), _lastGesture(""), _gestureCount(0) {
     if (_activeLow) {
         pinMode(_pin, INPUT_PULLUP);
     } else {
@@ -9,52 +23,238 @@ PushButtonMonitor::PushButtonMonitor(String name, int pin, bool activeLow)
     }
 }
 
+void PushButtonMonitor::begin() {
+    _lastPolledLevel = digitalRead(_pin);
+    _state = _isActive(_lastPolledLevel);
+
+    // Fall back to polling on pins without interrupt support (e.g. GPIO16 on the ESP8266).
+    int interrupt = digitalPinToInterrupt(_pin);
+    if (interrupt != NOT_AN_INTERRUPT) {
+        attachInterruptArg(interrupt, _isr, this, CHANGE);
+        _useInterrupt = true;
+    }
+}
+
+void IRAM_ATTR PushButtonMonitor::_isr(void* arg) {
+    PushButtonMonitor* self = static_cast<PushButtonMonitor*>(arg);
+    self->_queueEdge(digitalRead(self->_pin), millis());
+    LoopScheduler::wake();
+}
+
+void IRAM_ATTR PushButtonMonitor::_queueEdge(bool level, unsigned long time) {
+    uint8_t head = _head;
+    uint8_t next = (head + 1) % EDGE_BUFFER_SIZE;
+    if (next == _tail) {
+        // Full: drop the edge. Debouncing recovers from the next edge that fits.
+        _overflows++;
+        return;
+    }
+    _edges[head].time = time;
+    _edges[head].level = level;
+    _head = next;
+}
+
 void PushButtonMonitor::setTarget(DeviceControl* target) {
     _targetDevice = target;
 }
 
+void PushButtonMonitor::setDoublePressWindow(unsigned long window) {
+    if (window > MAX_DOUBLE_PRESS_WINDOW) window = MAX_DOUBLE_PRESS_WINDOW;
+    _doublePressWindow = window;
+}
+
+bool PushButtonMonitor::_isActive(bool level) {
+    return _activeLow ? (level == LOW) : (level == HIGH);
+}
+
+bool PushButtonMonitor::_gesturesEnabled() {
+    // Without double press or dimming there is nothing to wait for, so act on the press itself.
+    return _doublePressWindow > 0 || (_localAction && _targetDevice && _targetDevice->isDimmable());
+}
+
 void PushButtonMonitor::update() {
-    if (checkPressed()) {
-        if (_localAction && _targetDevice) {
-            _targetDevice->toggle();
+    if (!_useInterrupt) {
+        bool level = digitalRead(_pin);
+        if (level != _lastPolledLevel) {
+            _lastPolledLevel = level;
+            _queueEdge(level, millis());
         }
-        _triggerExchange = true;
+    }
+
+    // Drain the edges the ISR queued. An edge that follows the candidate within the debounce
+    // time means the candidate was bounce; otherwise the candidate was a real state change.
+    while (_tail != _head) {
+        uint8_t tail = _tail;
+        unsigned long time = _edges[tail].time;
+        bool pressed = _isActive(_edges[tail].level);
+        _tail = (tail + 1) % EDGE_BUFFER_SIZE;
+
+        if (_candidatePending && time - _candidateTime > DEBOUNCE_TIME) {
+            _commitState(_candidateState, _candidateTime);
+        }
+        _candidatePending = true;
+        _candidateState = pressed;
+        _candidateTime = time;
+    }
+
+    unsigned long now = millis();
+    if (_candidatePending && now - _candidateTime > DEBOUNCE_TIME) {
+        _candidatePending = false;
+        _commitState(_candidateState, _candidateTime);
+    }
+
+    if (_state && !_holding && _gesturesEnabled() && now - _pressTime >= LONG_PRESS_TIME) {
+        _startHold(now);
+    }
+    if (_holding && now - _lastRampStep >= RAMP_STEP_INTERVAL) {
+        _lastRampStep = now;
+        _rampStep();
+    }
+    if (_shortPending && now - _releaseTime > _doublePressWindow) {
+        _shortPending = false;
+        _shortPress();
     }
 }
 
-bool PushButtonMonitor::shouldTriggerExchange() {
-    return _triggerExchange;
+unsigned long PushButtonMonitor::getUpdateDelay() {
+    if (!_useInterrupt || _tail != _head) {
+        return 0;
+    }
+
+    unsigned long next = UPDATE_IDLE;
+    if (_candidatePending) {
+        next = min(next, timeUntil(_candidateTime, DEBOUNCE_TIME + 1));
+    }
+    if (_state && !_holding && _gesturesEnabled()) {
+        next = min(next, timeUntil(_pressTime, LONG_PRESS_TIME));
+    }
+    if (_holding) {
+        next = min(next, timeUntil(_lastRampStep, RAMP_STEP_INTERVAL));
+    }
+    if (_shortPending) {
+        next = min(next, timeUntil(_releaseTime, _doublePressWindow + 1));
+    }
+    return next;
 }
 
-void PushButtonMonitor::resetTriggerExchange() {
-    _triggerExchange = false;
+void PushButtonMonitor::_commitState(bool pressed, unsigned long time) {
+    if (pressed == _state) return;
+    _state = pressed;
+    if (pressed) {
+        _onPress(time);
+    } else {
+        _onRelease(time);
+    }
 }
 
-bool PushButtonMonitor::isPressed() {
-    int state = digitalRead(_pin);
-    return _activeLow ? (state == LOW) : (state == HIGH);
+void PushButtonMonitor::_onPress(unsigned long time) {
+    _pressTime = time;
+    _holding = false;
+
+    if (!_gesturesEnabled()) {
+        _shortPress();
+        return;
+    }
+
+    // A press while a short press is still waiting out the double press window makes it a double press.
+    _secondPress = _shortPending;
+    _shortPending = false;
 }
 
-bool PushButtonMonitor::checkPressed() {
-    bool reading = isPressed();
+void PushButtonMonitor::_onRelease(unsigned long time) {
+    _releaseTime = time;
 
-    // If the switch changed, due to noise or pressing:
-    if (reading != _lastReading) {
-        _lastDebounceTime = millis();
+    if (_holding) {
+        _holding = false;
+        // Persist the level the ramp ended on; the ramp itself doesn't write to flash.
+        if (_targetDevice) {
+            _targetDevice->setPercentage(_targetDevice->getPercentage(), true);
+        }
+        return;
+    }
+    if (!_gesturesEnabled()) {
+        return;
+    }
+
+    if (_secondPress) {
+        _secondPress = false;
+        _doublePress();
+    } else if (_doublePressWindow > 0) {
+        _shortPending = true;
+    } else {
+        _shortPress();
     }
-    _lastReading = reading;
+}
 
-    if ((millis() - _lastDebounceTime) > 50) {
-        // If the state has changed:
-        if (reading != _state) {
-            _state = reading;
-            // Only return true if the new state is PRESSED
-            if (_state) {
-                return true;
-            }
+void PushButtonMonitor::_startHold(unsigned long now) {
+    _holding = true;
+    _secondPress = false;
+    _lastRampStep = now;
+    _gesture("long");
+
+    if (!_localAction || !_targetDevice || !_targetDevice->isDimmable()) return;
+
+    if (!_targetDevice->isOn()) {
+        // Start from the bottom when the light is off.
+        _targetDevice->setPercentage(RAMP_MIN, false);
+        _targetDevice->turnOn();
+        _rampDirection = 1;
+    } else {
+        int percentage = _targetDevice->getPercentage();
+        if (percentage >= 100) {
+            _rampDirection = -1;
+        } else if (percentage <= RAMP_MIN) {
+            _rampDirection = 1;
+        } else {
+            // Alternate direction between holds.
+            _rampDirection = -_rampDirection;
         }
     }
-    return false;
+}
+
+void PushButtonMonitor::_rampStep() {
+    if (!_localAction || !_targetDevice || !_targetDevice->isDimmable()) return;
+
+    int percentage = _targetDevice->getPercentage() + _rampDirection * RAMP_STEP;
+    percentage = constrain(percentage, RAMP_MIN, 100);
+    if (percentage != _targetDevice->getPercentage()) {
+        _targetDevice->stepPercentage(percentage, RAMP_STEP_INTERVAL);
+    }
+}
+
+void PushButtonMonitor::_shortPress() {
+    _gesture("short");
+    if (_localAction && _targetDevice) {
+        _targetDevice->toggle();
+    }
+}
+
+void PushButtonMonitor::_doublePress() {
+    _gesture("double");
+    if (_localAction && _targetDevice) {
+        if (_targetDevice->isDimmable()) {
+            _targetDevice->setPercentage(100, true);
+        }
+        _targetDevice->turnOn();
+    }
+}
+
+void PushButtonMonitor::_gesture(const char* name) {
+    _lastGesture = name;
+    _gestureCount++;
+    _triggerExchange = true;
+}
+
+bool PushButtonMonitor::shouldTriggerExchange() {
+    return _triggerExchange;
+}
+
+void PushButtonMonitor::resetTriggerExchange() {
+    _triggerExchange = false;
+}
+
+bool PushButtonMonitor::isPressed() {
+    return _isActive(digitalRead(_pin));
 }
 
 void PushButtonMonitor::addToJson(JsonArray& doc) {
@@ -63,15 +263,41 @@ void PushButtonMonitor::addToJson(JsonArray& doc) {
     nested["subtype"] = "PushButton";
     nested["name"] = _name;
     nested["isPressed"] = isPressed();
+    nested["lastGesture"] = _lastGesture;
+    nested["gestureCount"] = _gestureCount;
+    nested["edgeOverflows"] = (unsigned long)_overflows;
+}
+
+uint32_t PushButtonMonitor::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(isPressed());
+    fp.add(getConfigFingerprint());
+    fp.add(_lastGesture);
+    fp.add(_gestureCount);
+    fp.add((unsigned long)_overflows);
+    return fp.value();
+}
+
+void PushButtonMonitor::addConfigToJson(JsonObject& nested) {
     nested["localAction"] = _localAction;
+    nested["doublePressWindow"] = _doublePressWindow;
+    nested["interrupt"] = _useInterrupt;
 }
 
-void PushButtonMonitor::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
-        if (config.containsKey("localAction")) {
-            _localAction = config["localAction"].as<bool>();
-        }
+uint32_t PushButtonMonitor::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_localAction);
+    fp.add(_doublePressWindow);
+    fp.add(_useInterrupt);
+    return fp.value();
+}
+
+void PushButtonMonitor::processCommand(JsonObject& config) {
+    if (config.containsKey("localAction")) {
+        _localAction = config["localAction"].as<bool>();
+    }
+    if (config.containsKey("setDoublePressWindow")) {
+        setDoublePressWindow(config["setDoublePressWindow"].as<unsigned long>());
     }
 }
 
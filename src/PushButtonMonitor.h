@@ -5,28 +5,82 @@
 #include "Device.h"
 #include "DeviceControl.h"
 
+// Buttons are sampled by a GPIO interrupt that queues timestamped edges; update() debounces
+// and interprets them later, so presses are neither missed nor mistimed while the loop sleeps.
+// Gestures: short press toggles the target, holding ramps a dimmable target's brightness,
+// and an optional double press (see setDoublePressWindow) turns it on at full brightness.
 class PushButtonMonitor : public Device {
     private:
+        static const uint8_t EDGE_BUFFER_SIZE = 16;
+
+        struct Edge {
+            unsigned long time;
+            bool level;
+        };
+
         int _pin;
         String _name;
         bool _activeLow;
-        bool _lastReading;
-        bool _state;
-        unsigned long _lastDebounceTime;
         bool _localAction;
         DeviceControl* _targetDevice;
         bool _triggerExchange;
+        bool _useInterrupt;
+
+        // Written by the ISR (head) and update() (tail) only.
+        volatile Edge _edges[EDGE_BUFFER_SIZE];
+        volatile uint8_t _head;
+        volatile uint8_t _tail;
+        volatile unsigned long _overflows;
+        bool _lastPolledLevel;
+
+        // Debouncing: an edge becomes a state change once no other edge follows it for the debounce time.
+        bool _candidatePending;
+        bool _candidateState;
+        unsigned long _candidateTime;
+        bool _state;
+
+        // Gestures
+        unsigned long _pressTime;
+        unsigned long _releaseTime;
+        bool _holding;
+        bool _secondPress;
+        bool _shortPending;
+        int _rampDirection;
+        unsigned long _lastRampStep;
+        unsigned long _doublePressWindow;
+        String _lastGesture;
+        unsigned long _gestureCount;
+
+        static void IRAM_ATTR _isr(void* arg);
+        void _queueEdge(bool level, unsigned long time);
+        bool _isActive(bool level);
+        bool _gesturesEnabled();
+        void _commitState(bool pressed, unsigned long time);
+        void _onPress(unsigned long time);
+        void _onRelease(unsigned long time);
+        void _startHold(unsigned long now);
+        void _rampStep();
+        void _shortPress();
+        void _doublePress();
+        void _gesture(const char* name);
 
     public:
         PushButtonMonitor(String name, int pin, bool activeLow = true);
+        void begin() override;
         void setTarget(DeviceControl* target);
+        // Max gap between two presses to count as a double press. 0 (the default) disables double
+        // press detection so that single presses act without waiting for the window to pass.
+        void setDoublePressWindow(unsigned long window);
         void update() override;
+        unsigned long getUpdateDelay() override;
         bool shouldTriggerExchange() override;
         void resetTriggerExchange() override;
         bool isPressed();
-        bool checkPressed();
         void addToJson(JsonArray& doc) override;
-        void processJson(JsonObject& doc) override;
+        uint32_t getStateFingerprint() override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
+        void processCommand(JsonObject& command) override;
         bool localAction();
         const String& getName();
 };
@@ -0,0 +1,250 @@
+#include "PwmAllocator.h"
+#include "StateFingerprint.h"
+#include "Logger.h"
+#include "LoopScheduler.h"
+
+PwmAllocator Pwm;
+
+PwmAllocator::PwmAllocator() : _failures(0), _conflicts(0) {
+    memset(_owners, 0, sizeof(_owners));
+    memset(_timers, 0, sizeof(_timers));
+#ifdef ESP32
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        _fading[channel] = false;
+        _fades[channel] = {};
+    }
+    _fadeInstalled = false;
+    _hardwareFades = 0;
+#endif
+}
+
+// The timer the core's ledcSetup() configures for a channel: the speed mode by the upper half,
+// then one timer per channel pair.
+int PwmAllocator::_timerOf(int channel) {
+#ifdef ESP32
+    return (channel / 8) * 4 + (channel / 2) % 4;
+#else
+    return 0;
+#endif
+}
+
+int PwmAllocator::_findChannel(uint32_t frequency, uint8_t resolution) {
+    // A timer already running at this setting costs no timer.
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        Timer& timer = _timers[_timerOf(channel)];
+        if (!_owners[channel] && timer.users > 0 && timer.frequency == frequency && timer.resolution == resolution) {
+            return channel;
+        }
+    }
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        if (!_owners[channel] && _timers[_timerOf(channel)].users == 0) {
+            return channel;
+        }
+    }
+#ifndef ESP32
+    // Every pin runs off the one timer, whatever it was asked for.
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        if (!_owners[channel]) {
+            return channel;
+        }
+    }
+#endif
+    return NO_CHANNEL;
+}
+
+int PwmAllocator::acquire(JsonProvider* owner, uint32_t frequency, uint8_t resolution) {
+    int channel = _findChannel(frequency, resolution);
+    if (channel == NO_CHANNEL) {
+        _failures++;
+        Log.error(("PwmAllocator: No PWM channel left for " + owner->getName() + " at Hz: " + String(frequency)).c_str());
+        return NO_CHANNEL;
+    }
+
+    Timer& timer = _timers[_timerOf(channel)];
+    if (timer.users == 0) {
+        timer.frequency = frequency;
+        timer.resolution = resolution;
+#ifndef ESP32
+        analogWriteFreq(frequency);
+        analogWriteRange((1 << resolution) - 1);
+#endif
+    } else if (timer.frequency != frequency || timer.resolution != resolution) {
+        _conflicts++;
+        Log.error(("PwmAllocator: " + owner->getName() + " wants Hz: " + String(frequency) + ", all pins run at Hz: " + String(timer.frequency)).c_str());
+    }
+    timer.users++;
+    _owners[channel] = owner;
+#ifdef ESP32
+    // Sets up the channel's shared timer again with the same values; the core also keeps the
+    // channel's resolution from this call.
+    ledcSetup(channel, timer.frequency, timer.resolution);
+#endif
+    return channel;
+}
+
+void PwmAllocator::release(int channel) {
+    if (channel < 0 || channel >= CHANNEL_COUNT || !_owners[channel]) {
+        return;
+    }
+    _owners[channel] = nullptr;
+    _timers[_timerOf(channel)].users--;
+}
+
+uint32_t PwmAllocator::getFrequency(int channel) {
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return 0;
+    }
+    return _timers[_timerOf(channel)].frequency;
+}
+
+#ifdef ESP32
+// Runs in the fade-end interrupt.
+bool IRAM_ATTR PwmAllocator::_onFadeEnd(const ledc_cb_param_t* param, void* arg) {
+    if (param->event == LEDC_FADE_END_EVT) {
+        Pwm._fading[(intptr_t)arg] = false;
+        LoopScheduler::wake();
+    }
+    return false;
+}
+
+bool PwmAllocator::fade(int channel, uint32_t duty, unsigned long durationMs) {
+    if (channel < 0 || channel >= CHANNEL_COUNT || !_owners[channel] || isFading(channel)) {
+        return false;
+    }
+    if (!_fadeInstalled) {
+        if (ledc_fade_func_install(0) != ESP_OK) {
+            Log.error("PwmAllocator: LEDC fade not available, fading in software");
+            return false;
+        }
+        _fadeInstalled = true;
+    }
+
+    // Reads back one more than the resolution holds when fully on, like ledcWrite() writes it.
+    uint32_t maxDuty = (1 << _timers[_timerOf(channel)].resolution) - 1;
+    uint32_t from = min(ledc_get_duty((ledc_mode_t)(channel / 8), (ledc_channel_t)(channel % 8)), maxDuty);
+    uint32_t steps = duty > from ? duty - from : from - duty;
+    uint32_t slices = (durationMs + FADE_SLICE_MS - 1) / FADE_SLICE_MS;
+    // Every slice moves the duty by at least one step.
+    slices = constrain(slices, (uint32_t)1, max(steps, (uint32_t)1));
+    _fades[channel] = { from, duty, (uint32_t)durationMs, (uint16_t)slices, 0, from, false };
+    if (!_startSlice(channel)) {
+        _fades[channel] = {};
+        return false;
+    }
+    _hardwareFades++;
+    return true;
+}
+
+uint32_t PwmAllocator::_sliceDuty(const Fade& fade, uint16_t slice) {
+    return (int32_t)fade.from + ((int32_t)fade.to - (int32_t)fade.from) * slice / fade.slices;
+}
+
+bool PwmAllocator::_startSlice(int channel) {
+    Fade& fade = _fades[channel];
+    // Channel numbering of the core's ledc* functions: the speed mode by the upper half.
+    ledc_mode_t mode = (ledc_mode_t)(channel / 8);
+    ledc_channel_t ledcChannel = (ledc_channel_t)(channel % 8);
+    uint32_t reached = _sliceDuty(fade, fade.slice + 1);
+    uint32_t duty = reached;
+    int durationMs = (uint64_t)fade.durationMs * (fade.slice + 1) / fade.slices - (uint64_t)fade.durationMs * fade.slice / fade.slices;
+    // Like ledcWrite(): a duty of all ones means fully on, one more than the resolution holds.
+    if (duty == (uint32_t)(1 << _timers[_timerOf(channel)].resolution) - 1) {
+        duty++;
+    }
+    ledc_cbs_t callbacks = { _onFadeEnd };
+    _fading[channel] = true;
+    if (ledc_cb_register(mode, ledcChannel, &callbacks, (void*)(intptr_t)channel) != ESP_OK ||
+        ledc_set_fade_with_time(mode, ledcChannel, duty, durationMs) != ESP_OK ||
+        ledc_fade_start(mode, ledcChannel, LEDC_FADE_NO_WAIT) != ESP_OK) {
+        _fading[channel] = false;
+        return false;
+    }
+    fade.slice++;
+    fade.reached = reached;
+    return true;
+}
+
+bool PwmAllocator::isFading(int channel) {
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return false;
+    }
+    return _fading[channel] || isSliceDue(channel);
+}
+
+bool PwmAllocator::isSliceDue(int channel) {
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return false;
+    }
+    const Fade& fade = _fades[channel];
+    return !_fading[channel] && !fade.stopped && fade.slice < fade.slices;
+}
+
+void PwmAllocator::advanceFade(int channel) {
+    if (isSliceDue(channel) && !_startSlice(channel)) {
+        // The duty stays where the last slice left it; the owner fades on from there.
+        _fades[channel].stopped = true;
+    }
+}
+
+void PwmAllocator::stopFade(int channel) {
+    if (channel >= 0 && channel < CHANNEL_COUNT) {
+        _fades[channel].stopped = true;
+    }
+}
+
+void PwmAllocator::resumeFade(int channel) {
+    if (channel >= 0 && channel < CHANNEL_COUNT) {
+        _fades[channel].stopped = false;
+    }
+}
+
+uint32_t PwmAllocator::getFadeDuty(int channel) {
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return 0;
+    }
+    return _fades[channel].reached;
+}
+#endif
+
+uint32_t PwmAllocator::getFingerprint() {
+    StateFingerprint fp;
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        fp.add(_owners[channel] ? getFrequency(channel) : 0);
+    }
+    fp.add(_failures);
+    fp.add(_conflicts);
+    return fp.value();
+}
+
+void PwmAllocator::addToJson(JsonObject& nested) {
+    JsonObject pwm = nested.createNestedObject("pwm");
+    pwm["fields"] = "channel,timer,hz,bits,owner";
+    JsonArray channels = pwm.createNestedArray("channels");
+    int freeChannels = 0;
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        if (!_owners[channel]) {
+            freeChannels++;
+            continue;
+        }
+        Timer& timer = _timers[_timerOf(channel)];
+        JsonArray entry = channels.createNestedArray();
+        entry.add(channel);
+        entry.add(_timerOf(channel));
+        entry.add(timer.frequency);
+        entry.add(timer.resolution);
+        entry.add(_owners[channel]->getName());
+    }
+    int freeTimers = 0;
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (_timers[i].users == 0) {
+            freeTimers++;
+        }
+    }
+    pwm["freeChannels"] = freeChannels;
+    pwm["freeTimers"] = freeTimers;
+    pwm["failures"] = _failures;
+    pwm["conflicts"] = _conflicts;
+#ifdef ESP32
+    pwm["hardwareFades"] = _hardwareFades;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef PWM_ALLOCATOR_H
+#define PWM_ALLOCATOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "JsonProvider.h"
+#ifdef ESP32
+#include <driver/ledc.h>
+#endif
+
+// Hands out the PWM outputs of the chip to the devices that dim something.
+//
+// ESP32: the LEDC has 16 channels and 8 timers, 4 per speed mode; channels 2n and 2n+1 run off
+// the same timer, so they share its frequency and resolution. acquire() puts a channel on a timer
+// that already runs at the requested frequency and resolution before it starts a free one, and
+// fails with an error once neither is left.
+//
+// ESP8266: analogWrite() has one frequency and range for all pins. The first output sets them; a
+// later one asking for another frequency runs at the one in use, and the conflict is logged.
+//
+// On the ESP32, fade() hands a linear fade to the LEDC, which ramps the duty without the CPU and
+// wakes the loop when it is done. The LEDC can't be stopped part way (ESP-IDF 4.4 has no
+// ledc_fade_stop(), and writing a fading channel waits for the fade), so it gets the fade in
+// short slices, which the owner's update() hands over with advanceFade(). stopFade() ends a fade
+// with the slice in flight, for a new target.
+//
+// The allocation map is published by the SystemMonitor.
+class PwmAllocator {
+    public:
+        static const int CHANNEL_COUNT = 16;
+        static const int NO_CHANNEL = -1;
+#ifdef ESP32
+        static const int TIMER_COUNT = 8;
+        static const uint8_t RESOLUTION = 8;
+#else
+        static const int TIMER_COUNT = 1;
+        static const uint8_t RESOLUTION = 10;
+#endif
+        static const int MAX_DUTY = (1 << RESOLUTION) - 1;
+#ifdef ESP32
+        // Longest stretch of a fade the LEDC runs on its own: how late a new target can be.
+        static const unsigned long FADE_SLICE_MS = 100;
+#endif
+
+    private:
+        struct Timer {
+            uint32_t frequency;
+            uint8_t resolution;
+            uint8_t users;
+        };
+
+        JsonProvider* _owners[CHANNEL_COUNT];
+        Timer _timers[TIMER_COUNT];
+        uint32_t _failures;
+        uint32_t _conflicts;
+#ifdef ESP32
+        struct Fade {
+            uint32_t from;
+            uint32_t to;
+            uint32_t durationMs;
+            uint16_t slices;
+            // Slices handed to the LEDC so far, and where the last of them ends.
+            uint16_t slice;
+            uint32_t reached;
+            bool stopped;
+        };
+
+        // Set when a slice starts, cleared by the fade-end interrupt.
+        volatile bool _fading[CHANNEL_COUNT];
+        Fade _fades[CHANNEL_COUNT];
+        bool _fadeInstalled;
+        uint32_t _hardwareFades;
+
+        static bool IRAM_ATTR _onFadeEnd(const ledc_cb_param_t* param, void* arg);
+        static uint32_t _sliceDuty(const Fade& fade, uint16_t slice);
+        bool _startSlice(int channel);
+#endif
+
+        static int _timerOf(int channel);
+        int _findChannel(uint32_t frequency, uint8_t resolution);
+
+    public:
+        PwmAllocator();
+
+        // Takes a channel running at the frequency and resolution for owner; NO_CHANNEL if none is
+        // left. On the ESP32 the caller attaches its pins with ledcAttachPin().
+        int acquire(JsonProvider* owner, uint32_t frequency, uint8_t resolution = RESOLUTION);
+        // Gives the channel back; the caller detaches its pins first.
+        void release(int channel);
+        // What the channel's timer actually runs at.
+        uint32_t getFrequency(int channel);
+
+#ifdef ESP32
+        // Starts a linear fade from the channel's current duty to duty. False if the LEDC would
+        // not take it; the caller then fades in software. The channel must not be written until
+        // isFading() turns false.
+        bool fade(int channel, uint32_t duty, unsigned long durationMs);
+        // True until the fade is over: a slice runs or more are due.
+        bool isFading(int channel);
+        // True once a slice has ended and the next one is due; the fade-end interrupt wakes the
+        // loop for it.
+        bool isSliceDue(int channel);
+        // Hands the LEDC the next slice if one is due; call it from the owner's update().
+        void advanceFade(int channel);
+        // Ends the fade with the slice the LEDC is running, at most FADE_SLICE_MS from now.
+        void stopFade(int channel);
+        // Takes back stopFade() while the fade is not over yet.
+        void resumeFade(int channel);
+        // The duty the last fade left the channel at, once isFading() is false.
+        uint32_t getFadeDuty(int channel);
+#endif
+
+        uint32_t getFingerprint();
+        void addToJson(JsonObject& nested);
+};
+
+extern PwmAllocator Pwm;
+
+#endif
\ No newline at end of file
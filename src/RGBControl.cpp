@@ -1,45 +1,25 @@
 #include "RGBControl.h"
-#include <EEPROM.h>
-
-#ifdef ESP32
-// Start from 8 to avoid conflict with RelayControl (which usually starts at 0)
-int RGBControl::_nextLedcChannel = 8;
-#endif
-
-struct RGBConfig {
-    unsigned long autoOffTimer;
-    int fadeDuration;
-    int percentage;
-    int r;
-    int g;
-    int b;
-    uint32_t magic;
-};
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
+#include "PwmAllocator.h"
+#include "Logger.h"
 
 RGBControl::RGBControl(String name, int pinR, int pinG, int pinB, bool activeLow, int frequency, int eepromOffset) 
-    : DeviceControl(name), _pinR(pinR), _pinG(pinG), _pinB(pinB), _activeLow(activeLow), _percentage(100), _frequency(frequency), 
+    : DeviceControl(name), _pinR(pinR), _pinG(pinG), _pinB(pinB), _activeLow(activeLow), _percentage(100), _percentageUnsaved(false), _frequency(frequency), 
       _on(false), _autoOffTimer(0), _turnOnTime(0), _eepromOffset(eepromOffset), _fadeDuration(0),
       _targetR(255), _targetG(255), _targetB(255),
-      _lastHardwareDutyR(0), _lastHardwareDutyG(0), _lastHardwareDutyB(0) {
+      _lastHardwareDutyR(0), _lastHardwareDutyG(0), _lastHardwareDutyB(0), _fadeCurve(FADE_LINEAR),
+      _pwmChannelR(PwmAllocator::NO_CHANNEL), _pwmChannelG(PwmAllocator::NO_CHANNEL), _pwmChannelB(PwmAllocator::NO_CHANNEL) {
     
     pinMode(_pinR, OUTPUT);
     pinMode(_pinG, OUTPUT);
     pinMode(_pinB, OUTPUT);
-
     #ifdef ESP32
-        _ledcChannelR = _nextLedcChannel++;
-        _ledcChannelG = _nextLedcChannel++;
-        _ledcChannelB = _nextLedcChannel++;
-        
-        ledcSetup(_ledcChannelR, _frequency, 8);
-        ledcSetup(_ledcChannelG, _frequency, 8);
-        ledcSetup(_ledcChannelB, _frequency, 8);
-        
-        ledcAttachPin(_pinR, _ledcChannelR);
-        ledcAttachPin(_pinG, _ledcChannelG);
-        ledcAttachPin(_pinB, _ledcChannelB);
-    #else
-        analogWriteFreq(_frequency);
+        _hardwareFadeToR = -1;
+        _hardwareFadeToG = -1;
+        _hardwareFadeToB = -1;
+        _retargetDuration = 0;
+        _retargetCurve = FADE_LINEAR;
     #endif
 
     // Init
@@ -50,11 +30,50 @@ void RGBControl::begin() {
     if (_eepromOffset >= 0) {
         loadConfig();
     }
+    if (!_acquirePwm()) {
+        Log.warn(("RGB " + _name + " got no PWM channels, colors only switch").c_str());
+    }
+    _updateHardware();
+}
+
+bool RGBControl::_acquirePwm() {
+    _pwmChannelR = Pwm.acquire(this, _frequency);
+    _pwmChannelG = Pwm.acquire(this, _frequency);
+    _pwmChannelB = Pwm.acquire(this, _frequency);
+    if (_pwmChannelR == PwmAllocator::NO_CHANNEL || _pwmChannelG == PwmAllocator::NO_CHANNEL || _pwmChannelB == PwmAllocator::NO_CHANNEL) {
+        // Colors need all three; leave the channels to others.
+        _releasePwm();
+        return false;
+    }
+    #ifdef ESP32
+        ledcAttachPin(_pinR, _pwmChannelR);
+        ledcAttachPin(_pinG, _pwmChannelG);
+        ledcAttachPin(_pinB, _pwmChannelB);
+    #endif
+    // Carry on from the levels the pins were at, so nothing fades in from a wrong one.
+    _writeDuty(_lastHardwareDutyR, _lastHardwareDutyG, _lastHardwareDutyB);
+    return true;
+}
+
+void RGBControl::_releasePwm() {
+    #ifdef ESP32
+        if (_pwmChannelR != PwmAllocator::NO_CHANNEL && _pwmChannelG != PwmAllocator::NO_CHANNEL && _pwmChannelB != PwmAllocator::NO_CHANNEL) {
+            ledcDetachPin(_pinR);
+            ledcDetachPin(_pinG);
+            ledcDetachPin(_pinB);
+        }
+    #endif
+    Pwm.release(_pwmChannelR);
+    Pwm.release(_pwmChannelG);
+    Pwm.release(_pwmChannelB);
+    _pwmChannelR = PwmAllocator::NO_CHANNEL;
+    _pwmChannelG = PwmAllocator::NO_CHANNEL;
+    _pwmChannelB = PwmAllocator::NO_CHANNEL;
 }
 
 void RGBControl::loadConfig() {
-    RGBConfig config;
-    EEPROM.get(_eepromOffset, config);
+    Config config;
+    Settings.get(_eepromOffset, config);
     
     if (config.magic == 0xDEADBEEF) {
         _autoOffTimer = config.autoOffTimer;
@@ -70,9 +89,8 @@ void RGBControl::loadConfig() {
 
 void RGBControl::saveConfig() {
     if (_eepromOffset < 0) return;
-    RGBConfig config = { _autoOffTimer, _fadeDuration, _percentage, _targetR, _targetG, _targetB, 0xDEADBEEF };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Config config = { (uint32_t)_autoOffTimer, _fadeDuration, _percentage, _targetR, _targetG, _targetB, 0xDEADBEEF };
+    Settings.put(_eepromOffset, config);
 }
 
 void RGBControl::turnOn() {
@@ -94,12 +112,24 @@ bool RGBControl::isOn() {
     return _on;
 }
 
-void RGBControl::setPercentage(int percentage) {
+bool RGBControl::isDimmable() {
+    return true;
+}
+
+int RGBControl::getPercentage() {
+    return _percentage;
+}
+
+void RGBControl::setPercentage(int percentage, bool persist) {
     if (percentage < 0) percentage = 0;
     if (percentage > 100) percentage = 100;
     
     if (_percentage != percentage) {
         _percentage = percentage;
+        _percentageUnsaved = true;
+    }
+    if (persist && _percentageUnsaved) {
+        _percentageUnsaved = false;
         saveConfig();
     }
 
@@ -108,6 +138,20 @@ void RGBControl::setPercentage(int percentage) {
     }
 }
 
+void RGBControl::stepPercentage(int percentage, unsigned long duration) {
+    if (percentage < 0) percentage = 0;
+    if (percentage > 100) percentage = 100;
+
+    if (_percentage != percentage) {
+        _percentage = percentage;
+        _percentageUnsaved = true;
+    }
+    if (_on) {
+        // A step fades over its own interval at most, linearly so that the steps join up.
+        _updateHardware(min(_fadeDuration, (int)duration), FADE_LINEAR);
+    }
+}
+
 void RGBControl::setRGB(int r, int g, int b) {
     if (r < 0) r = 0;
     if (r > 255) r = 255;
@@ -129,15 +173,15 @@ void RGBControl::setRGB(int r, int g, int b) {
 }
 
 void RGBControl::_updateHardware() {
+    _updateHardware(_fadeDuration, _fadeCurve);
+}
+
+void RGBControl::_updateHardware(int fadeDuration, FadeCurve fadeCurve) {
     int effectiveR = _on ? (_targetR * _percentage / 100) : 0;
     int effectiveG = _on ? (_targetG * _percentage / 100) : 0;
     int effectiveB = _on ? (_targetB * _percentage / 100) : 0;
 
-    #ifdef ESP32
-        int maxDuty = 255;
-    #else
-        int maxDuty = 1023;
-    #endif
+    int maxDuty = PwmAllocator::MAX_DUTY;
 
     int targetDutyR = map(effectiveR, 0, 255, 0, maxDuty);
     int targetDutyG = map(effectiveG, 0, 255, 0, maxDuty);
@@ -149,58 +193,144 @@ void RGBControl::_updateHardware() {
         targetDutyB = maxDuty - targetDutyB;
     }
 
-    if (_fadeDuration > 0 && (_lastHardwareDutyR != targetDutyR || _lastHardwareDutyG != targetDutyG || _lastHardwareDutyB != targetDutyB)) {
-        int diffR = targetDutyR - _lastHardwareDutyR;
-        int diffG = targetDutyG - _lastHardwareDutyG;
-        int diffB = targetDutyB - _lastHardwareDutyB;
-        
-        int steps = max(abs(diffR), max(abs(diffG), abs(diffB)));
-        if (steps > 0) {
-            int stepDelay = _fadeDuration / steps;
-            for (int i = 1; i <= steps; i++) {
-                int dR = _lastHardwareDutyR + (diffR * i / steps);
-                int dG = _lastHardwareDutyG + (diffG * i / steps);
-                int dB = _lastHardwareDutyB + (diffB * i / steps);
-                
-                #ifdef ESP32
-                    ledcWrite(_ledcChannelR, dR);
-                    ledcWrite(_ledcChannelG, dG);
-                    ledcWrite(_ledcChannelB, dB);
-                #else
-                    analogWrite(_pinR, dR);
-                    analogWrite(_pinG, dG);
-                    analogWrite(_pinB, dB);
-                #endif
-                
-                if (stepDelay > 0) delay(stepDelay);
+    #ifdef ESP32
+        // The channels can't be written while the LEDC fades them. A fade heading for another
+        // color ends with its current slice; update() then comes back here. Back at the fade's
+        // own color, it runs on as it was.
+        if (_isHardwareFading()) {
+            if (targetDutyR != (_hardwareFadeToR >= 0 ? _hardwareFadeToR : _lastHardwareDutyR) ||
+                targetDutyG != (_hardwareFadeToG >= 0 ? _hardwareFadeToG : _lastHardwareDutyG) ||
+                targetDutyB != (_hardwareFadeToB >= 0 ? _hardwareFadeToB : _lastHardwareDutyB)) {
+                Pwm.stopFade(_pwmChannelR);
+                Pwm.stopFade(_pwmChannelG);
+                Pwm.stopFade(_pwmChannelB);
+                _retargetDuration = fadeDuration;
+                _retargetCurve = fadeCurve;
+            } else {
+                Pwm.resumeFade(_pwmChannelR);
+                Pwm.resumeFade(_pwmChannelG);
+                Pwm.resumeFade(_pwmChannelB);
+                _retargetDuration = 0;
+                _retargetCurve = FADE_LINEAR;
             }
+            return;
+        }
+    #endif
+
+    if (fadeDuration > 0 && (_lastHardwareDutyR != targetDutyR || _lastHardwareDutyG != targetDutyG || _lastHardwareDutyB != targetDutyB)) {
+        if (_fadeInHardware(targetDutyR, targetDutyG, targetDutyB, fadeDuration, fadeCurve)) {
+            return;
+        }
+        // Fade all channels together from their current duty; update() advances them.
+        // Don't restart a fade that is already heading to this color.
+        bool sameTarget = _isFading() && _faderR.getTarget() == targetDutyR && _faderG.getTarget() == targetDutyG && _faderB.getTarget() == targetDutyB;
+        if (!sameTarget) {
+            _faderR.start(_lastHardwareDutyR, targetDutyR, fadeDuration, fadeCurve);
+            _faderG.start(_lastHardwareDutyG, targetDutyG, fadeDuration, fadeCurve);
+            _faderB.start(_lastHardwareDutyB, targetDutyB, fadeDuration, fadeCurve);
         }
+    } else {
+        _faderR.stop();
+        _faderG.stop();
+        _faderB.stop();
+        _writeDuty(targetDutyR, targetDutyG, targetDutyB);
+    }
+}
+
+void RGBControl::_writeDuty(int dutyR, int dutyG, int dutyB) {
+    if (_pwmChannelR == PwmAllocator::NO_CHANNEL) {
+        // No PWM: each color is on from half its duty.
+        digitalWrite(_pinR, dutyR > PwmAllocator::MAX_DUTY / 2 ? HIGH : LOW);
+        digitalWrite(_pinG, dutyG > PwmAllocator::MAX_DUTY / 2 ? HIGH : LOW);
+        digitalWrite(_pinB, dutyB > PwmAllocator::MAX_DUTY / 2 ? HIGH : LOW);
     } else {
         #ifdef ESP32
-            ledcWrite(_ledcChannelR, targetDutyR);
-            ledcWrite(_ledcChannelG, targetDutyG);
-            ledcWrite(_ledcChannelB, targetDutyB);
+            ledcWrite(_pwmChannelR, dutyR);
+            ledcWrite(_pwmChannelG, dutyG);
+            ledcWrite(_pwmChannelB, dutyB);
         #else
-            analogWrite(_pinR, targetDutyR);
-            analogWrite(_pinG, targetDutyG);
-            analogWrite(_pinB, targetDutyB);
+            analogWrite(_pinR, dutyR);
+            analogWrite(_pinG, dutyG);
+            analogWrite(_pinB, dutyB);
         #endif
     }
-    
-    _lastHardwareDutyR = targetDutyR;
-    _lastHardwareDutyG = targetDutyG;
-    _lastHardwareDutyB = targetDutyB;
+
+    _lastHardwareDutyR = dutyR;
+    _lastHardwareDutyG = dutyG;
+    _lastHardwareDutyB = dutyB;
 }
 
-void RGBControl::setFrequency(int frequency) {
-    _frequency = frequency;
+bool RGBControl::_isFading() {
+    return _faderR.isActive() || _faderG.isActive() || _faderB.isActive();
+}
+
+bool RGBControl::_isHardwareFading() {
     #ifdef ESP32
-        ledcSetup(_ledcChannelR, _frequency, 8);
-        ledcSetup(_ledcChannelG, _frequency, 8);
-        ledcSetup(_ledcChannelB, _frequency, 8);
+        return _hardwareFadeToR >= 0 || _hardwareFadeToG >= 0 || _hardwareFadeToB >= 0;
+    #else
+        return false;
+    #endif
+}
+
+bool RGBControl::_hardwareFadeDone() {
+    #ifdef ESP32
+        return !Pwm.isFading(_pwmChannelR) && !Pwm.isFading(_pwmChannelG) && !Pwm.isFading(_pwmChannelB);
+    #else
+        return true;
+    #endif
+}
+
+// The LEDC fades linearly on its own, so the loop can sleep through the fade. False if the fade
+// has to run in software.
+bool RGBControl::_fadeInHardware(int dutyR, int dutyG, int dutyB, int fadeDuration, FadeCurve fadeCurve) {
+    #ifdef ESP32
+        if (fadeCurve != FADE_LINEAR || _pwmChannelR == PwmAllocator::NO_CHANNEL) {
+            return false;
+        }
+        _faderR.stop();
+        _faderG.stop();
+        _faderB.stop();
+        // A color the LEDC refused keeps its duty and is faded once the others are done.
+        _hardwareFadeToR = dutyR != _lastHardwareDutyR && Pwm.fade(_pwmChannelR, dutyR, fadeDuration) ? dutyR : -1;
+        _hardwareFadeToG = dutyG != _lastHardwareDutyG && Pwm.fade(_pwmChannelG, dutyG, fadeDuration) ? dutyG : -1;
+        _hardwareFadeToB = dutyB != _lastHardwareDutyB && Pwm.fade(_pwmChannelB, dutyB, fadeDuration) ? dutyB : -1;
+        return _isHardwareFading();
     #else
-        analogWriteFreq(_frequency);
+        return false;
     #endif
+}
+
+void RGBControl::setFrequency(int frequency) {
+    int previous = _frequency;
+    _frequency = frequency;
+    if (_pwmChannelR != PwmAllocator::NO_CHANNEL) {
+        #ifdef ESP32
+            // The channels may go to someone else; the fades end with their current slices, and
+            // new ones start from there on the channels acquired below.
+            if (_isHardwareFading()) {
+                Pwm.stopFade(_pwmChannelR);
+                Pwm.stopFade(_pwmChannelG);
+                Pwm.stopFade(_pwmChannelB);
+                if (_hardwareFadeToR >= 0) _lastHardwareDutyR = Pwm.getFadeDuty(_pwmChannelR);
+                if (_hardwareFadeToG >= 0) _lastHardwareDutyG = Pwm.getFadeDuty(_pwmChannelG);
+                if (_hardwareFadeToB >= 0) _lastHardwareDutyB = Pwm.getFadeDuty(_pwmChannelB);
+                _hardwareFadeToR = -1;
+                _hardwareFadeToG = -1;
+                _hardwareFadeToB = -1;
+                _retargetDuration = 0;
+                _retargetCurve = FADE_LINEAR;
+            }
+        #endif
+        // The channels' timers may be shared; move to ones that run at the new frequency.
+        _releasePwm();
+        if (!_acquirePwm()) {
+            _frequency = previous;
+            if (!_acquirePwm()) {
+                // Colors only switch on and off from here on.
+                Log.warn(("RGB " + _name + " lost its PWM channels, colors only switch now").c_str());
+            }
+        }
+    }
     _updateHardware();
 }
 
@@ -218,64 +348,114 @@ void RGBControl::setFadeDuration(int duration) {
     }
 }
 
+void RGBControl::setFadeCurve(FadeCurve curve) {
+    _fadeCurve = curve;
+}
+
 void RGBControl::update() {
+    if (_isFading()) {
+        int dutyR = _faderR.update();
+        int dutyG = _faderG.update();
+        int dutyB = _faderB.update();
+        if (dutyR != _lastHardwareDutyR || dutyG != _lastHardwareDutyG || dutyB != _lastHardwareDutyB) {
+            _writeDuty(dutyR, dutyG, dutyB);
+        }
+    }
+    #ifdef ESP32
+        if (_isHardwareFading()) {
+            // Each channel gets its next slice even while another is still busy.
+            Pwm.advanceFade(_pwmChannelR);
+            Pwm.advanceFade(_pwmChannelG);
+            Pwm.advanceFade(_pwmChannelB);
+        }
+        if (_isHardwareFading() && _hardwareFadeDone()) {
+            if (_hardwareFadeToR >= 0) _lastHardwareDutyR = Pwm.getFadeDuty(_pwmChannelR);
+            if (_hardwareFadeToG >= 0) _lastHardwareDutyG = Pwm.getFadeDuty(_pwmChannelG);
+            if (_hardwareFadeToB >= 0) _lastHardwareDutyB = Pwm.getFadeDuty(_pwmChannelB);
+            _hardwareFadeToR = -1;
+            _hardwareFadeToG = -1;
+            _hardwareFadeToB = -1;
+            // Catch up with anything that changed during the fade, the way it was asked for.
+            int duration = _retargetDuration;
+            _retargetDuration = 0;
+            _updateHardware(duration, _retargetCurve);
+        }
+    #endif
+
     if (_on && _autoOffTimer > 0 && (millis() - _turnOnTime >= _autoOffTimer)) {
         turnOff();
     }
 }
 
+unsigned long RGBControl::getUpdateDelay() {
+    if (_isFading()) {
+        return 0;
+    }
+    #ifdef ESP32
+        // The fade-end interrupt wakes the loop for the next slice, and for the end of the fade.
+        bool sliceDue = Pwm.isSliceDue(_pwmChannelR) || Pwm.isSliceDue(_pwmChannelG) || Pwm.isSliceDue(_pwmChannelB);
+        if (_isHardwareFading() && (sliceDue || _hardwareFadeDone())) {
+            return 0;
+        }
+    #endif
+    if (_on && _autoOffTimer > 0) {
+        return timeUntil(_turnOnTime, _autoOffTimer);
+    }
+    return UPDATE_IDLE;
+}
+
 void RGBControl::refreshState() {
     _updateHardware();
 }
 
-void RGBControl::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        if (doc[_name].is<JsonObject>()) {
-            JsonObject command = doc[_name].as<JsonObject>();
-
-            if (command.containsKey("setPercentage")) {
-                setPercentage(command["setPercentage"].as<int>());
-            }
-
-            int r = _targetR;
-            int g = _targetG;
-            int b = _targetB;
-            bool updateColor = false;
-
-            if (command.containsKey("setRGB")) {
-                JsonObject rgb = command["setRGB"];
-                r = rgb["r"];
-                g = rgb["g"];
-                b = rgb["b"];
-                updateColor = true;
-            }
-            if (command.containsKey("setR")) { r = command["setR"].as<int>(); updateColor = true; }
-            if (command.containsKey("setG")) { g = command["setG"].as<int>(); updateColor = true; }
-            if (command.containsKey("setB")) { b = command["setB"].as<int>(); updateColor = true; }
+void RGBControl::processCommand(JsonObject& command) {
+    if (command.containsKey("setPercentage")) {
+        setPercentage(command["setPercentage"].as<int>());
+    }
 
-            if (updateColor) {
-                setRGB(r, g, b);
-            }
+    int r = _targetR;
+    int g = _targetG;
+    int b = _targetB;
+    bool updateColor = false;
+
+    if (command.containsKey("setRGB")) {
+        JsonObject rgb = command["setRGB"];
+        r = rgb["r"];
+        g = rgb["g"];
+        b = rgb["b"];
+        updateColor = true;
+    }
+    if (command.containsKey("setR")) { r = command["setR"].as<int>(); updateColor = true; }
+    if (command.containsKey("setG")) { g = command["setG"].as<int>(); updateColor = true; }
+    if (command.containsKey("setB")) { b = command["setB"].as<int>(); updateColor = true; }
 
-            if (command.containsKey("setFrequency")) {
-                setFrequency(command["setFrequency"].as<int>());
-            }
-            if (command.containsKey("setAutoOffTimer")) {
-                setAutoOffTimer(command["setAutoOffTimer"].as<unsigned long>());
-            }
-            if (command.containsKey("setFadeDuration")) {
-                setFadeDuration(command["setFadeDuration"].as<int>());
-            }
+    if (updateColor) {
+        setRGB(r, g, b);
+    }
 
-            if (command.containsKey("toggleState") && command["toggleState"].as<bool>()) {
-                toggle();
-            }
-            if (command.containsKey("setState") && command["setState"].is<bool>()) {
-                bool state = command["setState"].as<bool>();
-                state ? turnOn() : turnOff();
-            }
+    if (command.containsKey("setFrequency")) {
+        setFrequency(command["setFrequency"].as<int>());
+    }
+    if (command.containsKey("setAutoOffTimer")) {
+        setAutoOffTimer(command["setAutoOffTimer"].as<unsigned long>());
+    }
+    if (command.containsKey("setFadeDuration")) {
+        setFadeDuration(command["setFadeDuration"].as<int>());
+    }
+    if (command.containsKey("setFadeCurve")) {
+        FadeCurve curve;
+        if (Fader::parseCurve(command["setFadeCurve"], curve)) {
+            setFadeCurve(curve);
         }
     }
+
+    if (command.containsKey("toggleState") && command["toggleState"].as<bool>()) {
+        toggle();
+    }
+    if (command.containsKey("setState") && command["setState"].is<bool>()) {
+        bool state = command["setState"].as<bool>();
+        state ? turnOn() : turnOff();
+    }
 }
 
 void RGBControl::addToJson(JsonArray& doc) {
@@ -290,9 +470,7 @@ void RGBControl::addToJson(JsonArray& doc) {
     nested["g"] = _targetG;
     nested["b"] = _targetB;
 
-    nested["frequency"] = _frequency;
-    nested["autoOffTimer"] = _autoOffTimer;
-    nested["fadeDuration"] = _fadeDuration;
+    nested["isFading"] = _isFading() || _isHardwareFading();
 
     unsigned long remaining = 0;
     if (_on && _autoOffTimer > 0) {
@@ -304,6 +482,38 @@ void RGBControl::addToJson(JsonArray& doc) {
     nested["autoOffRemaining"] = remaining;
 }
 
+uint32_t RGBControl::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(isOn());
+    fp.add(_percentage);
+    fp.add(_targetR);
+    fp.add(_targetG);
+    fp.add(_targetB);
+    fp.add(getConfigFingerprint());
+    fp.add(_isFading() || _isHardwareFading());
+    // The auto-off countdown only counts as a change once per minute.
+    if (_on && _autoOffTimer > 0) {
+        fp.add(timeUntil(_turnOnTime, _autoOffTimer) / 60000UL);
+    }
+    return fp.value();
+}
+
+void RGBControl::addConfigToJson(JsonObject& nested) {
+    nested["frequency"] = _frequency;
+    nested["autoOffTimer"] = _autoOffTimer;
+    nested["fadeDuration"] = _fadeDuration;
+    nested["fadeCurve"] = Fader::curveName(_fadeCurve);
+}
+
+uint32_t RGBControl::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_frequency);
+    fp.add(_autoOffTimer);
+    fp.add(_fadeDuration);
+    fp.add((int)_fadeCurve);
+    return fp.value();
+}
+
 const String& RGBControl::getName() {
     return _name;
 }
\ No newline at end of file
@@ -3,12 +3,14 @@
 
 #include <Arduino.h>
 #include "DeviceControl.h"
+#include "Fader.h"
 
 class RGBControl : public DeviceControl {
     private:
         int _pinR, _pinG, _pinB;
         bool _activeLow;
         int _percentage;
+        bool _percentageUnsaved;
         int _frequency;
         bool _on;
         unsigned long _autoOffTimer;
@@ -26,14 +28,40 @@ class RGBControl : public DeviceControl {
         int _lastHardwareDutyG;
         int _lastHardwareDutyB;
 
+        Fader _faderR;
+        Fader _faderG;
+        Fader _faderB;
+        FadeCurve _fadeCurve;
+
+        // From the PwmAllocator in begin(); until then, or if they were not all available, the
+        // colors are only switched on and off.
+        int _pwmChannelR;
+        int _pwmChannelG;
+        int _pwmChannelB;
 #ifdef ESP32
-        int _ledcChannelR;
-        int _ledcChannelG;
-        int _ledcChannelB;
-        static int _nextLedcChannel;
+        // Targets of the fades the LEDC is running, -1 where there is none.
+        int _hardwareFadeToR;
+        int _hardwareFadeToG;
+        int _hardwareFadeToB;
+        // How to go on from a fade that was stopped for a new color.
+        int _retargetDuration;
+        FadeCurve _retargetCurve;
 #endif
 
     public:
+        struct Config {
+            uint32_t autoOffTimer;
+            int fadeDuration;
+            int percentage;
+            int r;
+            int g;
+            int b;
+            uint32_t magic;
+        };
+
+        // PWM channels a strip takes, counted by the room's DeviceTable.
+        static constexpr int PWM_CHANNELS = 3;
+
         RGBControl(String name, int pinR, int pinG, int pinB, bool activeLow = false, int frequency = 1000, int eepromOffset = -1);
         void begin() override;
         void turnOn() override;
@@ -41,20 +69,36 @@ class RGBControl : public DeviceControl {
         void toggle() override;
         bool isOn() override;
         
-        void setPercentage(int percentage);
+        bool isDimmable() override;
+        int getPercentage() override;
+        void setPercentage(int percentage, bool persist = true) override;
+        void stepPercentage(int percentage, unsigned long duration) override;
         void setRGB(int r, int g, int b);
         void setFrequency(int frequency);
         void setAutoOffTimer(unsigned long duration);
         void setFadeDuration(int duration);
+        void setFadeCurve(FadeCurve curve);
         
         void update() override;
+        unsigned long getUpdateDelay() override;
         void refreshState() override;
-        void processJson(JsonObject& doc) override;
+        void processCommand(JsonObject& command) override;
         void addToJson(JsonArray& doc) override;
+        uint32_t getStateFingerprint() override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
         const String& getName() override;
 
     private:
         void _updateHardware();
+        void _updateHardware(int fadeDuration, FadeCurve fadeCurve);
+        void _writeDuty(int dutyR, int dutyG, int dutyB);
+        bool _acquirePwm();
+        void _releasePwm();
+        bool _isFading();
+        bool _isHardwareFading();
+        bool _hardwareFadeDone();
+        bool _fadeInHardware(int dutyR, int dutyG, int dutyB, int fadeDuration, FadeCurve fadeCurve);
         void loadConfig();
         void saveConfig();
 };
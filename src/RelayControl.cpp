@@ -1,40 +1,25 @@
 #include "RelayControl.h"
-#include <EEPROM.h>
-
-#ifdef ESP32
-int RelayControl::_nextLedcChannel = 0;
-#endif
-
-struct RelayConfig {
-    unsigned long autoOffTimer;
-    int fadeDuration;
-    int percentage;
-    uint32_t magic;
-};
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
+#include "PwmAllocator.h"
+#include "Logger.h"
 
 RelayControl::RelayControl(String name, int pin, bool activeLow, bool pwm, int frequency, int eepromOffset) 
     : RelayControl(name, std::vector<int>{pin}, activeLow, pwm, frequency, eepromOffset) {
 }
 
 RelayControl::RelayControl(String name, const std::vector<int>& pins, bool activeLow, bool pwm, int frequency, int eepromOffset) 
-    : DeviceControl(name), _pins(pins), _activeLow(activeLow), _pwm(pwm), _percentage(100), _frequency(frequency), _on(false), _autoOffTimer(0), _turnOnTime(0), _eepromOffset(eepromOffset), _fadeDuration(0), _lastHardwareDuty(0) {
+    : DeviceControl(name), _pins(pins), _activeLow(activeLow), _pwm(pwm), _percentage(100), _percentageUnsaved(false), _frequency(frequency), _on(false), _autoOffTimer(0), _turnOnTime(0), _eepromOffset(eepromOffset), _fadeDuration(0), _lastHardwareDuty(activeLow ? PwmAllocator::MAX_DUTY : 0), _fadeCurve(FADE_LINEAR),
+      _pwmChannel(PwmAllocator::NO_CHANNEL) {
     
     for (int p : _pins) {
         pinMode(p, OUTPUT);
     }
-
-    if (_pwm) {
-        #ifdef ESP32
-            _ledcChannel = _nextLedcChannel++;
-            ledcSetup(_ledcChannel, _frequency, 8);
-            for (int p : _pins) {
-                ledcAttachPin(p, _ledcChannel);
-            }
-        #else
-            // This will change frequency for all pins on the ES08266, as it can only be globally set.
-            analogWriteFreq(_frequency);
-        #endif
-    }
+    #ifdef ESP32
+        _hardwareFadeTo = -1;
+        _retargetDuration = 0;
+        _retargetCurve = FADE_LINEAR;
+    #endif
 
     // Init
     turnOff();
@@ -44,11 +29,42 @@ void RelayControl::begin() {
     if (_eepromOffset >= 0) {
         loadConfig();
     }
+    if (_pwm && !_acquirePwm()) {
+        // Still switches, just without dimming.
+        _pwm = false;
+        Log.warn(("Relay " + _name + " got no PWM channel, it only switches").c_str());
+    }
+    _updateHardware();
+}
+
+bool RelayControl::_acquirePwm() {
+    _pwmChannel = Pwm.acquire(this, _frequency);
+    if (_pwmChannel == PwmAllocator::NO_CHANNEL) {
+        return false;
+    }
+    #ifdef ESP32
+        for (int p : _pins) {
+            ledcAttachPin(p, _pwmChannel);
+        }
+    #endif
+    // Carry on from the level the pins were at, so nothing fades in from a wrong one.
+    _writeDuty(_lastHardwareDuty);
+    return true;
+}
+
+void RelayControl::_releasePwm() {
+    #ifdef ESP32
+        for (int p : _pins) {
+            ledcDetachPin(p);
+        }
+    #endif
+    Pwm.release(_pwmChannel);
+    _pwmChannel = PwmAllocator::NO_CHANNEL;
 }
 
 void RelayControl::loadConfig() {
-    RelayConfig config;
-    EEPROM.get(_eepromOffset, config);
+    Config config;
+    Settings.get(_eepromOffset, config);
     
     if (config.magic == 0xCAFEBABE) {
         _autoOffTimer = config.autoOffTimer;
@@ -61,9 +77,8 @@ void RelayControl::loadConfig() {
 
 void RelayControl::saveConfig() {
     if (_eepromOffset < 0) return;
-    RelayConfig config = { _autoOffTimer, _fadeDuration, _percentage, 0xCAFEBABE };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Config config = { (uint32_t)_autoOffTimer, _fadeDuration, _percentage, 0xCAFEBABE };
+    Settings.put(_eepromOffset, config);
 }
 
 void RelayControl::turnOn() {
@@ -85,12 +100,24 @@ bool RelayControl::isOn() {
     return _on;
 }
 
-void RelayControl::setPercentage(int percentage) {
+bool RelayControl::isDimmable() {
+    return _pwm;
+}
+
+int RelayControl::getPercentage() {
+    return _percentage;
+}
+
+void RelayControl::setPercentage(int percentage, bool persist) {
     if (percentage < 0) percentage = 0;
     if (percentage > 100) percentage = 100;
     
     if (_percentage != percentage) {
         _percentage = percentage;
+        _percentageUnsaved = true;
+    }
+    if (persist && _percentageUnsaved) {
+        _percentageUnsaved = false;
         saveConfig();
     }
 
@@ -101,47 +128,71 @@ void RelayControl::setPercentage(int percentage) {
     }
 }
 
+void RelayControl::stepPercentage(int percentage, unsigned long duration) {
+    if (percentage < 0) percentage = 0;
+    if (percentage > 100) percentage = 100;
+
+    if (_percentage != percentage) {
+        _percentage = percentage;
+        _percentageUnsaved = true;
+    }
+    if (_on) {
+        // Each step restarting the full fade would make the ramp lag behind the button; a step
+        // only fades over its own interval, linearly so that the steps join up.
+        _updateHardware(min(_fadeDuration, (int)duration), FADE_LINEAR);
+    }
+}
+
 void RelayControl::_updateHardware() {
+    _updateHardware(_fadeDuration, _fadeCurve);
+}
+
+void RelayControl::_updateHardware(int fadeDuration, FadeCurve fadeCurve) {
     int effectivePercentage = _on ? _percentage : 0;
 
-    if (_pwm) {
+    if (_pwmChannel != PwmAllocator::NO_CHANNEL) {
         int targetDuty = 0;
-        #ifdef ESP32
-            int maxDuty = 255;
-        #else
-            int maxDuty = 1023;
-        #endif
+        int maxDuty = PwmAllocator::MAX_DUTY;
 
         targetDuty = map(effectivePercentage, 0, 100, 0, maxDuty);
         if (_activeLow) targetDuty = maxDuty - targetDuty;
 
-        if (_fadeDuration > 0 && _lastHardwareDuty != targetDuty) {
-            int diff = targetDuty - _lastHardwareDuty;
-            int steps = abs(diff);
-            if (steps > 0) {
-                int stepDelay = _fadeDuration / steps;
-                for (int i = 1; i <= steps; i++) {
-                    int d = _lastHardwareDuty + (diff * i / steps);
-                    #ifdef ESP32
-                        ledcWrite(_ledcChannel, d);
-                    #else
-                        for (int p : _pins) {
-                            analogWrite(p, d);
-                        }
-                    #endif
-                    if (stepDelay > 0) delay(stepDelay);
+        #ifdef ESP32
+            // The channel can't be written while the LEDC fades it. A fade heading elsewhere
+            // ends with its current slice; update() then comes back here. Back at the fade's own
+            // target, it runs on as it was.
+            if (_hardwareFadeTo >= 0) {
+                if (targetDuty != _hardwareFadeTo) {
+                    Pwm.stopFade(_pwmChannel);
+                    _retargetDuration = fadeDuration;
+                    _retargetCurve = fadeCurve;
+                } else {
+                    Pwm.resumeFade(_pwmChannel);
+                    _retargetDuration = 0;
+                    _retargetCurve = FADE_LINEAR;
                 }
+                return;
             }
-        } else {
+        #endif
+
+        if (fadeDuration > 0 && _lastHardwareDuty != targetDuty) {
             #ifdef ESP32
-                ledcWrite(_ledcChannel, targetDuty);
-            #else
-                for (int p : _pins) {
-                    analogWrite(p, targetDuty);
+                // The LEDC fades linearly on its own, so the loop can sleep through the fade.
+                if (fadeCurve == FADE_LINEAR && Pwm.fade(_pwmChannel, targetDuty, fadeDuration)) {
+                    _fader.stop();
+                    _hardwareFadeTo = targetDuty;
+                    return;
                 }
             #endif
+            // Fade from wherever the output currently is; update() advances it.
+            // Don't restart a fade that is already heading to this target.
+            if (!_fader.isActive() || _fader.getTarget() != targetDuty) {
+                _fader.start(_lastHardwareDuty, targetDuty, fadeDuration, fadeCurve);
+            }
+        } else {
+            _fader.stop();
+            _writeDuty(targetDuty);
         }
-        _lastHardwareDuty = targetDuty;
     } else {
         bool on = effectivePercentage > 0;
         int state = _activeLow ? (on ? LOW : HIGH) : (on ? HIGH : LOW);
@@ -151,14 +202,42 @@ void RelayControl::_updateHardware() {
     }
 }
 
+void RelayControl::_writeDuty(int duty) {
+    #ifdef ESP32
+        ledcWrite(_pwmChannel, duty);
+    #else
+        for (int p : _pins) {
+            analogWrite(p, duty);
+        }
+    #endif
+    _lastHardwareDuty = duty;
+}
+
 void RelayControl::setFrequency(int frequency) {
+    int previous = _frequency;
     _frequency = frequency;
-    if (_pwm) {
+    if (_pwmChannel != PwmAllocator::NO_CHANNEL) {
         #ifdef ESP32
-            ledcSetup(_ledcChannel, _frequency, 8);
-        #else
-            analogWriteFreq(_frequency);
+            // The channel may go to someone else; the fade ends with its current slice, and a
+            // new one starts from there on the channel acquired below.
+            if (_hardwareFadeTo >= 0) {
+                Pwm.stopFade(_pwmChannel);
+                _lastHardwareDuty = Pwm.getFadeDuty(_pwmChannel);
+                _hardwareFadeTo = -1;
+                _retargetDuration = 0;
+                _retargetCurve = FADE_LINEAR;
+            }
         #endif
+        // The channel's timer may be shared; move to one that runs at the new frequency.
+        _releasePwm();
+        if (!_acquirePwm()) {
+            _frequency = previous;
+            if (!_acquirePwm()) {
+                // Still switches, just without dimming.
+                _pwm = false;
+                Log.warn(("Relay " + _name + " lost its PWM channel, it only switches now").c_str());
+            }
+        }
         // Re-apply percentage to ensure duty cycle is correct
         _updateHardware();
     }
@@ -178,46 +257,95 @@ void RelayControl::setFadeDuration(int duration) {
     }
 }
 
+void RelayControl::setFadeCurve(FadeCurve curve) {
+    _fadeCurve = curve;
+}
+
+bool RelayControl::_isFading() {
+    #ifdef ESP32
+        if (_hardwareFadeTo >= 0) {
+            return true;
+        }
+    #endif
+    return _fader.isActive();
+}
+
 void RelayControl::update() {
+    if (_fader.isActive()) {
+        int duty = _fader.update();
+        if (duty != _lastHardwareDuty) {
+            _writeDuty(duty);
+        }
+    }
+    #ifdef ESP32
+        if (_hardwareFadeTo >= 0) {
+            Pwm.advanceFade(_pwmChannel);
+        }
+        if (_hardwareFadeTo >= 0 && !Pwm.isFading(_pwmChannel)) {
+            _lastHardwareDuty = Pwm.getFadeDuty(_pwmChannel);
+            _hardwareFadeTo = -1;
+            // Catch up with anything that changed during the fade, the way it was asked for.
+            int duration = _retargetDuration;
+            _retargetDuration = 0;
+            _updateHardware(duration, _retargetCurve);
+        }
+    #endif
+
     if (_on && _autoOffTimer > 0 && (millis() - _turnOnTime >= _autoOffTimer)) {
         turnOff();
     }
 }
 
+unsigned long RelayControl::getUpdateDelay() {
+    if (_fader.isActive()) {
+        return 0;
+    }
+    #ifdef ESP32
+        // The fade-end interrupt wakes the loop for the next slice, and for the end of the fade.
+        if (_hardwareFadeTo >= 0 && (Pwm.isSliceDue(_pwmChannel) || !Pwm.isFading(_pwmChannel))) {
+            return 0;
+        }
+    #endif
+    if (_on && _autoOffTimer > 0) {
+        return timeUntil(_turnOnTime, _autoOffTimer);
+    }
+    return UPDATE_IDLE;
+}
+
 void RelayControl::refreshState() {
     _updateHardware();
 }
 
-void RelayControl::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        if (doc[_name].is<JsonObject>()) {
-            JsonObject command = doc[_name].as<JsonObject>();
-
-            // Process settings first to ensure they apply before any state change
-            if (command.containsKey("setPercentage")) {
-                setPercentage(command["setPercentage"].as<int>());
-            }
-            if (command.containsKey("setFrequency")) {
-                setFrequency(command["setFrequency"].as<int>());
-            }
-            if (command.containsKey("setAutoOffTimer")) {
-                setAutoOffTimer(command["setAutoOffTimer"].as<unsigned long>());
-            }
-            if (command.containsKey("setFadeDuration")) {
-                setFadeDuration(command["setFadeDuration"].as<int>());
-            }
-
-            // Process state changes
-            if (command.containsKey("toggleState") && command["toggleState"].as<bool>()) {
-                toggle();
-            }
-            if (command.containsKey("setState") && command["setState"].is<bool>()) {
-                // Only act if setState is explicitly true or false, ignore null/string/etc.
-                bool state = command["setState"].as<bool>();
-                state ? turnOn() : turnOff();
-            }
+void RelayControl::processCommand(JsonObject& command) {
+    // Process settings first to ensure they apply before any state change
+    if (command.containsKey("setPercentage")) {
+        setPercentage(command["setPercentage"].as<int>());
+    }
+    if (command.containsKey("setFrequency")) {
+        setFrequency(command["setFrequency"].as<int>());
+    }
+    if (command.containsKey("setAutoOffTimer")) {
+        setAutoOffTimer(command["setAutoOffTimer"].as<unsigned long>());
+    }
+    if (command.containsKey("setFadeDuration")) {
+        setFadeDuration(command["setFadeDuration"].as<int>());
+    }
+    if (command.containsKey("setFadeCurve")) {
+        FadeCurve curve;
+        if (Fader::parseCurve(command["setFadeCurve"], curve)) {
+            setFadeCurve(curve);
         }
     }
+
+    // Process state changes
+    if (command.containsKey("toggleState") && command["toggleState"].as<bool>()) {
+        toggle();
+    }
+    if (command.containsKey("setState") && command["setState"].is<bool>()) {
+        // Only act if setState is explicitly true or false, ignore null/string/etc.
+        bool state = command["setState"].as<bool>();
+        state ? turnOn() : turnOff();
+    }
 }
 
 void RelayControl::addToJson(JsonArray& doc) {
@@ -225,12 +353,9 @@ void RelayControl::addToJson(JsonArray& doc) {
     nested["type"] = "DeviceControl";
     nested["subtype"] = "Relay";
     nested["name"] = _name;
-    nested["pwm"] = _pwm;    
     nested["isOn"] = isOn();
     nested["percentage"] = _percentage;
-    nested["frequency"] = _frequency;
-    nested["autoOffTimer"] = _autoOffTimer;
-    nested["fadeDuration"] = _fadeDuration;
+    nested["isFading"] = _isFading();
 
     unsigned long remaining = 0;
     if (_on && _autoOffTimer > 0) {
@@ -242,6 +367,37 @@ void RelayControl::addToJson(JsonArray& doc) {
     nested["autoOffRemaining"] = remaining;
 }
 
+uint32_t RelayControl::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(getConfigFingerprint());
+    fp.add(isOn());
+    fp.add(_percentage);
+    fp.add(_isFading());
+    // The auto-off countdown only counts as a change once per minute.
+    if (_on && _autoOffTimer > 0) {
+        fp.add(timeUntil(_turnOnTime, _autoOffTimer) / 60000UL);
+    }
+    return fp.value();
+}
+
+void RelayControl::addConfigToJson(JsonObject& nested) {
+    nested["pwm"] = _pwm;
+    nested["frequency"] = _frequency;
+    nested["autoOffTimer"] = _autoOffTimer;
+    nested["fadeDuration"] = _fadeDuration;
+    nested["fadeCurve"] = Fader::curveName(_fadeCurve);
+}
+
+uint32_t RelayControl::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_pwm);
+    fp.add(_frequency);
+    fp.add(_autoOffTimer);
+    fp.add(_fadeDuration);
+    fp.add((int)_fadeCurve);
+    return fp.value();
+}
+
 const String& RelayControl::getName() {
     return _name;
 }
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "DeviceControl.h"
+#include "Fader.h"
 #include <vector>
 
 class RelayControl : public DeviceControl {
@@ -11,6 +12,7 @@ class RelayControl : public DeviceControl {
         bool _activeLow;
         bool _pwm;
         int _percentage;
+        bool _percentageUnsaved;
         int _frequency;
         bool _on;
         unsigned long _autoOffTimer;
@@ -18,12 +20,29 @@ class RelayControl : public DeviceControl {
         int _eepromOffset;
         int _fadeDuration;
         int _lastHardwareDuty;
+        Fader _fader;
+        FadeCurve _fadeCurve;
+        // From the PwmAllocator in begin(); until then, or if none was left, the relay only switches.
+        int _pwmChannel;
 #ifdef ESP32
-        int _ledcChannel;
-        static int _nextLedcChannel;
+        // Target of the fade the LEDC is running, -1 if there is none.
+        int _hardwareFadeTo;
+        // How to go on from a fade that was stopped for a new target.
+        int _retargetDuration;
+        FadeCurve _retargetCurve;
 #endif
 
     public:
+        struct Config {
+            uint32_t autoOffTimer;
+            int fadeDuration;
+            int percentage;
+            uint32_t magic;
+        };
+
+        // PWM channels a relay takes, counted by the room's DeviceTable. All its pins share one.
+        static constexpr int PWM_CHANNELS = 1;
+
         RelayControl(String name, int pin, bool activeLow = false, bool pwm = false, int frequency = 1000, int eepromOffset = -1);
         RelayControl(String name, const std::vector<int>& pins, bool activeLow = false, bool pwm = false, int frequency = 1000, int eepromOffset = -1);
         void begin();
@@ -31,18 +50,31 @@ class RelayControl : public DeviceControl {
         void turnOff() override;
         void toggle() override;
         bool isOn() override;
-        void setPercentage(int percentage);
+        bool isDimmable() override;
+        int getPercentage() override;
+        void setPercentage(int percentage, bool persist = true) override;
+        void stepPercentage(int percentage, unsigned long duration) override;
         void setFrequency(int frequency);
         void setAutoOffTimer(unsigned long duration);
         void setFadeDuration(int duration);
+        void setFadeCurve(FadeCurve curve);
         void update();
+        unsigned long getUpdateDelay() override;
         void refreshState() override;
-        void processJson(JsonObject& doc) override;
+        void processCommand(JsonObject& command) override;
         void addToJson(JsonArray& doc) override;
+        uint32_t getStateFingerprint() override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
         const String& getName();
 
     private:
         void _updateHardware();
+        void _updateHardware(int fadeDuration, FadeCurve fadeCurve);
+        void _writeDuty(int duty);
+        bool _isFading();
+        bool _acquirePwm();
+        void _releasePwm();
         void loadConfig();
         void saveConfig();
 };
@@ -1,8 +1,14 @@
 #include "SHT31.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
 #include "Logger.h"
 
+// Single-shot, high repeatability, no clock stretching. The conversion takes up to 15.5ms.
+static const uint16_t SHT31_MEAS_HIGHREP = 0x2400;
+static const unsigned long SHT31_CONVERSION_TIME = 16;
+
 SHT31::SHT31(String name, uint8_t address, unsigned long interval, int eepromOffset) 
-    : _name(name), _address(address), _interval(interval), _lastUpdateTime(0), _eepromOffset(eepromOffset),
+    : _name(name), _address(address), _interval(interval), _lastUpdateTime(0), _measurementPending(false), _eepromOffset(eepromOffset),
       _temperature(NAN), _humidity(NAN),
       _tempSum(0), _humSum(0), _readingsCount(0), _available(false), _heaterOn(false), _tempOffset(0.0), _humOffset(0.0) {
 }
@@ -29,7 +35,7 @@ void SHT31::begin() {
 
 void SHT31::loadConfig() {
     Config config;
-    EEPROM.get(_eepromOffset, config);
+    Settings.get(_eepromOffset, config);
     // Magic number to validate EEPROM data
     if (config.magic == 0xDEADBEE1) {
         if (config.interval >= 1000) {
@@ -43,31 +49,79 @@ void SHT31::loadConfig() {
 
 void SHT31::saveConfig() {
     if (_eepromOffset < 0) return;
-    Config config = { _interval, _heaterOn, _tempOffset, _humOffset, 0xDEADBEE1 };
-    EEPROM.put(_eepromOffset, config);
-    EEPROM.commit();
+    Config config = { (uint32_t)_interval, _heaterOn, _tempOffset, _humOffset, 0xDEADBEE1 };
+    Settings.put(_eepromOffset, config);
 }
 
 void SHT31::update() {
     if (!_available) return;
 
+    if (_measurementPending) {
+        if (millis() - _lastUpdateTime >= SHT31_CONVERSION_TIME) {
+            collectMeasurement();
+        }
+        return;
+    }
+
     if (millis() - _lastUpdateTime >= _interval) {
-        _lastUpdateTime = millis();
-        
-        float t = _sht.readTemperature();
-        float h = _sht.readHumidity();
-
-        if (!isnan(t) && !isnan(h)) {
-            t += _tempOffset;
-            h += _humOffset;
-            
-            _temperature = t;
-            _humidity = h;
-            _tempSum += t;
-            _humSum += h;
-            _readingsCount++;
+        startMeasurement();
+    }
+}
+
+bool SHT31::startMeasurement() {
+    // The Adafruit driver waits out the conversion, so the single-shot command is issued directly.
+    _lastUpdateTime = millis();
+    Wire.beginTransmission(_address);
+    Wire.write((uint8_t)(SHT31_MEAS_HIGHREP >> 8));
+    Wire.write((uint8_t)(SHT31_MEAS_HIGHREP & 0xFF));
+    _measurementPending = (Wire.endTransmission() == 0);
+    return _measurementPending;
+}
+
+void SHT31::collectMeasurement() {
+    _measurementPending = false;
+
+    uint8_t data[6];
+    if (Wire.requestFrom(_address, (uint8_t)6) != 6) return;
+    for (int i = 0; i < 6; i++) {
+        data[i] = Wire.read();
+    }
+    if (_crc8(data, 2) != data[2] || _crc8(data + 3, 2) != data[5]) return;
+
+    uint16_t rawT = (data[0] << 8) | data[1];
+    uint16_t rawH = (data[3] << 8) | data[4];
+    float t = -45.0 + 175.0 * rawT / 65535.0 + _tempOffset;
+    float h = 100.0 * rawH / 65535.0 + _humOffset;
+
+    _temperature = t;
+    _humidity = h;
+    _tempSum += t;
+    _humSum += h;
+    _readingsCount++;
+}
+
+bool SHT31::measurementPending() {
+    return _measurementPending;
+}
+
+uint8_t SHT31::_crc8(const uint8_t* data, int len) {
+    // CRC-8 as specified in the SHT3x datasheet: polynomial 0x31, init 0xFF.
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
         }
     }
+    return crc;
+}
+
+unsigned long SHT31::getUpdateDelay() {
+    if (!_available) return UPDATE_IDLE;
+    if (_measurementPending) {
+        return timeUntil(_lastUpdateTime, SHT31_CONVERSION_TIME);
+    }
+    return timeUntil(_lastUpdateTime, _interval);
 }
 
 void SHT31::addToJson(JsonArray& doc) {
@@ -75,12 +129,9 @@ void SHT31::addToJson(JsonArray& doc) {
     nested["type"] = "Sensor";
     nested["subtype"] = "SHT31";
     nested["name"] = _name;
-    nested["interval"] = _interval;
     
     if (_available) {
         nested["heater"] = _heaterOn;
-        nested["tempCOffset"] = serialized(String(_tempOffset, 2));
-        nested["humOffset"] = serialized(String(_humOffset, 2));
 
         float t = _temperature;
         float h = _humidity;
@@ -99,40 +150,63 @@ void SHT31::addToJson(JsonArray& doc) {
     }
 }
 
-void SHT31::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        JsonObject config = doc[_name];
-        bool changed = false;
-
-        if (config.containsKey("setInterval")) {
-            unsigned long newInterval = config["setInterval"].as<unsigned long>();
-            if (newInterval >= 1000 && newInterval != _interval) {
-                _interval = newInterval;
-                changed = true;
-            }
-        }
+uint32_t SHT31::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(_available);
+    fp.add(getConfigFingerprint());
+    fp.add(_heaterOn);
+    // The averages addToJson() would publish, without resetting them.
+    bool averaged = _readingsCount > 0;
+    fp.add(averaged ? _tempSum / _readingsCount : _temperature, 0.1f);
+    fp.add(averaged ? _humSum / _readingsCount : _humidity, 1.0f);
+    return fp.value();
+}
 
-        if (config.containsKey("setHeater")) {
-            bool newHeater = config["setHeater"].as<bool>();
-            if (newHeater != _heaterOn) {
-                _heaterOn = newHeater;
-                if (_available) _sht.heater(_heaterOn);
-                changed = true;
-            }
-        }
+void SHT31::addConfigToJson(JsonObject& nested) {
+    nested["interval"] = _interval;
+    setFixed(nested, "tempCOffset", _tempOffset, 2);
+    setFixed(nested, "humOffset", _humOffset, 2);
+}
 
-        if (config.containsKey("setTempCOffset")) {
-            _tempOffset = config["setTempCOffset"].as<float>();
+uint32_t SHT31::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_interval);
+    fp.add(_tempOffset, 0.01f);
+    fp.add(_humOffset, 0.01f);
+    return fp.value();
+}
+
+void SHT31::processCommand(JsonObject& config) {
+    bool changed = false;
+
+    if (config.containsKey("setInterval")) {
+        unsigned long newInterval = config["setInterval"].as<unsigned long>();
+        if (newInterval >= 1000 && newInterval != _interval) {
+            _interval = newInterval;
             changed = true;
         }
+    }
 
-        if (config.containsKey("setHumOffset")) {
-            _humOffset = config["setHumOffset"].as<float>();
+    if (config.containsKey("setHeater")) {
+        bool newHeater = config["setHeater"].as<bool>();
+        if (newHeater != _heaterOn) {
+            _heaterOn = newHeater;
+            if (_available) _sht.heater(_heaterOn);
             changed = true;
         }
+    }
+
+    if (config.containsKey("setTempCOffset")) {
+        _tempOffset = config["setTempCOffset"].as<float>();
+        changed = true;
+    }
 
-        if (changed) saveConfig();
+    if (config.containsKey("setHumOffset")) {
+        _humOffset = config["setHumOffset"].as<float>();
+        changed = true;
     }
+
+    if (changed) saveConfig();
 }
 
 const String& SHT31::getName() {
@@ -5,7 +5,6 @@
 #include <Wire.h>
 #include "Adafruit_SHT31.h"
 #include "Device.h"
-#include <EEPROM.h>
 
 class SHT31 : public Device {
     private:
@@ -14,6 +13,7 @@ class SHT31 : public Device {
         uint8_t _address;
         unsigned long _interval;
         unsigned long _lastUpdateTime;
+        bool _measurementPending;
         int _eepromOffset;
         
         float _temperature;
@@ -27,23 +27,31 @@ class SHT31 : public Device {
         float _tempOffset;
         float _humOffset;
 
+        void loadConfig();
+        void saveConfig();
+        static uint8_t _crc8(const uint8_t* data, int len);
+
+    public:
         struct Config {
-            unsigned long interval;
+            uint32_t interval;
             bool heaterOn;
             float tempOffset;
             float humOffset;
             uint32_t magic;
         };
 
-        void loadConfig();
-        void saveConfig();
-
-    public:
         SHT31(String name, uint8_t address = 0x44, unsigned long interval = 20000, int eepromOffset = -1);
         void begin() override;
         void update() override;
+        unsigned long getUpdateDelay() override;
+        bool startMeasurement() override;
+        void collectMeasurement() override;
+        bool measurementPending() override;
         void addToJson(JsonArray& doc) override;
-        void processJson(JsonObject& doc) override;
+        uint32_t getStateFingerprint() override;
+        void addConfigToJson(JsonObject& nested) override;
+        uint32_t getConfigFingerprint() override;
+        void processCommand(JsonObject& command) override;
         const String& getName() override;
 };
 
@@ -0,0 +1,55 @@
+#ifndef STATE_FINGERPRINT_H
+#define STATE_FINGERPRINT_H
+
+#include <Arduino.h>
+#include <math.h>
+
+// Incremental FNV-1a hash over the values a provider publishes, used to tell whether its
+// state changed since the last exchange. Floats are quantized to a resolution first so that
+// noise below it does not count as a change.
+//
+//     StateFingerprint fp;
+//     fp.add(_isOn);
+//     fp.add(_temperature, 0.1f);
+//     return fp.value();
+class StateFingerprint {
+    private:
+        uint32_t _hash;
+
+        void _mix(uint32_t value) {
+            for (int i = 0; i < 4; i++) {
+                _hash ^= (value >> (i * 8)) & 0xFF;
+                _hash *= 16777619UL;
+            }
+        }
+
+    public:
+        StateFingerprint() : _hash(2166136261UL) {}
+
+        void add(bool value) { _mix(value ? 1 : 0); }
+        void add(int value) { _mix((uint32_t)value); }
+        void add(unsigned int value) { _mix((uint32_t)value); }
+        void add(long value) { _mix((uint32_t)value); }
+        void add(unsigned long value) { _mix((uint32_t)value); }
+
+        void add(float value, float resolution) {
+            if (isnan(value)) {
+                _mix(0x7FC00000UL);
+                return;
+            }
+            _mix((uint32_t)lroundf(value / resolution));
+        }
+
+        void add(const String& value) {
+            for (unsigned int i = 0; i < value.length(); i++) {
+                _hash ^= (uint8_t)value[i];
+                _hash *= 16777619UL;
+            }
+            _mix(value.length());
+        }
+
+        // Never 0, which JsonProvider reserves for "always publish".
+        uint32_t value() const { return _hash == 0 ? 1 : _hash; }
+};
+
+#endif
\ No newline at end of file
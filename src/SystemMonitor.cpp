@@ -1,11 +1,16 @@
 #include "SystemMonitor.h"
+#include "StateFingerprint.h"
+#include "Profiler.h"
+#include "ConfigStore.h"
+#include "PwmAllocator.h"
+#include "BistableRelayControl.h"
 #ifdef ESP32
 #include <WiFi.h>
 #else
 #include <ESP8266WiFi.h>
 #endif
 
-SystemMonitor::SystemMonitor(String name, String deviceId) : _deviceId(deviceId), _name(name), _loopDelay(20) {
+SystemMonitor::SystemMonitor(String name, String deviceId) : _deviceId(deviceId), _name(name), _loopDelay(20), _maxLoopDelay(1000) {
     if (_name.length() == 0) {
         _name = "_system";
     }
@@ -16,12 +21,40 @@ void SystemMonitor::addToJson(JsonArray& doc) {
     nested["type"] = "System";
     nested["subtype"] = "SystemMonitor";
     nested["name"] = _name;
-    nested["deviceId"] = _deviceId;
     nested["freeHeap"] = getFreeHeap();
     nested["largestBlock"] = getLargestBlock();
     nested["uptime"] = getUptime();
     nested["rssi"] = WiFi.RSSI();
+    Settings.addToJson(nested);
+    Prof.addToJson(nested);
+    Pwm.addToJson(nested);
+}
+
+uint32_t SystemMonitor::getStateFingerprint() {
+    // Uptime is left out on purpose; it would make every exchange a change.
+    StateFingerprint fp;
+    fp.add(getFreeHeap() / 1024);
+    fp.add(getLargestBlock() / 1024);
+    fp.add((int)(WiFi.RSSI() / 5));
+    fp.add(getConfigFingerprint());
+    fp.add(Settings.getCommitsPerHour());
+    fp.add(Prof.hasReport());
+    fp.add(Pwm.getFingerprint());
+    return fp.value();
+}
+
+void SystemMonitor::addConfigToJson(JsonObject& nested) {
+    nested["deviceId"] = _deviceId;
     nested["loopDelay"] = _loopDelay;
+    nested["maxLoopDelay"] = _maxLoopDelay;
+}
+
+uint32_t SystemMonitor::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_deviceId);
+    fp.add(_loopDelay);
+    fp.add(_maxLoopDelay);
+    return fp.value();
 }
 
 uint32_t SystemMonitor::getFreeHeap() {
@@ -44,31 +77,45 @@ bool SystemMonitor::fragmentationIsCritical() {
     return getLargestBlock() < 4096;
 }
 
-void SystemMonitor::processJson(JsonObject& doc) {
-    if (doc.containsKey(_name)) {
-        if (doc[_name].is<JsonObject>()) {
-            JsonObject command = doc[_name].as<JsonObject>();
-
-            if (command.containsKey("reboot") && command["reboot"].as<bool>()) {
-                ESP.restart();
-            }
-
-            if (command.containsKey("sleep") && command["sleep"].is<unsigned long>()) {
-                // Use 1000ULL to force 64-bit arithmetic, preventing overflow when converting ms to us
-                uint64_t sleepTime = command["sleep"].as<unsigned long>() * 1000ULL;
-                #ifdef ESP32
-                    esp_deep_sleep(sleepTime);
-                #else
-                    ESP.deepSleep(sleepTime);
-                #endif
-            }
-
-            if (command.containsKey("setLoopDelay")) {
-                int newDelay = command["setLoopDelay"].as<int>();
-                if (newDelay >= 0) {
-                    _loopDelay = newDelay;
-                }
-            }
+void SystemMonitor::processCommand(JsonObject& command) {
+    if (command.containsKey("reboot") && command["reboot"].as<bool>()) {
+        Settings.flush();
+        BistableRelayControl::finishPulses();
+        ESP.restart();
+    }
+
+    if (command.containsKey("sleep") && command["sleep"].is<unsigned long>()) {
+        // Use 1000ULL to force 64-bit arithmetic, preventing overflow when converting ms to us
+        uint64_t sleepTime = command["sleep"].as<unsigned long>() * 1000ULL;
+        Settings.flush();
+        BistableRelayControl::finishPulses();
+        #ifdef ESP32
+            esp_deep_sleep(sleepTime);
+        #else
+            ESP.deepSleep(sleepTime);
+        #endif
+    }
+
+    if (command.containsKey("setLoopDelay")) {
+        int newDelay = command["setLoopDelay"].as<int>();
+        if (newDelay >= 0) {
+            _loopDelay = newDelay;
+        }
+    }
+
+    if (command.containsKey("captureTiming")) {
+        // Duration in ms; the samples are published with the first exchange after it ends.
+        Prof.startCapture(command["captureTiming"].as<unsigned long>());
+    }
+
+    if (command.containsKey("setTimingThreshold")) {
+        Prof.setThreshold(command["setTimingThreshold"].as<unsigned long>());
+    }
+
+    if (command.containsKey("setMaxLoopDelay")) {
+        int newDelay = command["setMaxLoopDelay"].as<int>();
+        if (newDelay >= _loopDelay && newDelay <= 60000) {
+            _maxLoopDelay = newDelay;
         }
     }
 }
@@ -77,6 +124,11 @@ int SystemMonitor::getLoopDelay() {
     return _loopDelay;
 }
 
+int SystemMonitor::getMaxLoopDelay() {
+    // Never sleep for less than the base loop delay.
+    return _maxLoopDelay > _loopDelay ? _maxLoopDelay : _loopDelay;
+}
+
 const String& SystemMonitor::getName() {
     return _name;
 }
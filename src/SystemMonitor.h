@@ -9,18 +9,24 @@ private:
     String _deviceId;
     String _name;
     int _loopDelay;
+    int _maxLoopDelay;
 
 public:
     SystemMonitor(String name, String deviceId);
     void begin() override {}
     void update() override {}
+    unsigned long getUpdateDelay() override { return UPDATE_IDLE; }
     void addToJson(JsonArray& doc) override;
+    uint32_t getStateFingerprint() override;
+    void addConfigToJson(JsonObject& nested) override;
+    uint32_t getConfigFingerprint() override;
     uint32_t getFreeHeap();
     uint32_t getLargestBlock();
     bool fragmentationIsCritical();
     unsigned long getUptime();
-    void processJson(JsonObject& doc) override;
+    void processCommand(JsonObject& command) override;
     int getLoopDelay();
+    int getMaxLoopDelay();
     const String& getName() override;
 };
 
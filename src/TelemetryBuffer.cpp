@@ -0,0 +1,436 @@
+#include "TelemetryBuffer.h"
+#include "Logger.h"
+#include <LittleFS.h>
+
+static const char* LOG_PATH = "/telemetry.log";
+static const char* OLD_PATH = "/telemetry.old";
+static const char* BOOT_PATH = "/telemetry.boot";
+
+// Records are copied between flash and the output in pieces of this size.
+static const size_t COPY_CHUNK = 128;
+
+// Framing of one batch entry. JSON: {"ageMs":N,"data":...} or {"data":...}.
+// MessagePack: a map of the same keys, ageMs as uint32.
+static const char JSON_AGE[] = "{\"ageMs\":";
+static const char JSON_DATA_AFTER_AGE[] = ",\"data\":";
+static const char JSON_DATA[] = "{\"data\":";
+static const uint8_t MSGPACK_AGE[] = {0x82, 0xa5, 'a', 'g', 'e', 'M', 's', 0xce};
+static const uint8_t MSGPACK_DATA[] = {0xa4, 'd', 'a', 't', 'a'};
+static const uint8_t MSGPACK_DATA_ONLY = 0x81;
+
+TelemetryBuffer::TelemetryBuffer(size_t ramCapacity, size_t fileCapacity)
+    : _ramUsed(0), _ramCapacity(ramCapacity), _fileCapacity(fileCapacity), _fsReady(false), _bootAssigned(false), _boot(0),
+      _oldSize(0), _oldOffset(0), _logSize(0), _logOffset(0), _droppedBytes(0),
+      _batchSource(SOURCE_NONE), _batchStart(0), _batchEnd(0), _batchCount(0), _batchBinary(false), _batchNow(0) {
+}
+
+void TelemetryBuffer::begin() {
+#ifdef ESP32
+    _fsReady = LittleFS.begin(true);
+#else
+    _fsReady = LittleFS.begin();
+#endif
+    if (!_fsReady) {
+        Log.warn("TelemetryBuffer: LittleFS not available, buffering in RAM only.");
+        return;
+    }
+
+    File old = LittleFS.open(OLD_PATH, "r");
+    if (old) {
+        _oldSize = old.size();
+        old.close();
+    }
+    File log = LittleFS.open(LOG_PATH, "r");
+    if (log) {
+        _logSize = log.size();
+        log.close();
+    }
+    if (!isEmpty()) {
+        Log.info(("TelemetryBuffer: History from an earlier boot, bytes: " + String(pendingBytes())).c_str());
+    }
+}
+
+void TelemetryBuffer::_encodeHeader(uint8_t* out, const Header& header) {
+    out[0] = header.length & 0xFF;
+    out[1] = header.length >> 8;
+    out[2] = header.binary;
+    out[3] = header.boot & 0xFF;
+    out[4] = header.boot >> 8;
+    for (int i = 0; i < 4; i++) {
+        out[5 + i] = (header.capturedAt >> (i * 8)) & 0xFF;
+    }
+}
+
+void TelemetryBuffer::_decodeHeader(const uint8_t* in, Header& header) {
+    header.length = in[0] | (in[1] << 8);
+    header.binary = in[2];
+    header.boot = in[3] | (in[4] << 8);
+    header.capturedAt = 0;
+    for (int i = 0; i < 4; i++) {
+        header.capturedAt |= (uint32_t)in[5 + i] << (i * 8);
+    }
+}
+
+size_t TelemetryBuffer::_digits(uint32_t value) {
+    size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+// Tells this boot's records from older ones in the log. The counter is only advanced once this
+// boot actually stores something, so normal boots do not write to flash.
+uint16_t TelemetryBuffer::_bootTag() {
+    if (!_bootAssigned) {
+        _bootAssigned = true;
+        _boot = 1;
+        if (_fsReady) {
+            File file = LittleFS.open(BOOT_PATH, "r");
+            if (file) {
+                uint8_t bytes[2] = {0, 0};
+                file.read(bytes, 2);
+                file.close();
+                _boot = (bytes[0] | (bytes[1] << 8)) + 1;
+            }
+            file = LittleFS.open(BOOT_PATH, "w");
+            if (file) {
+                uint8_t bytes[2] = {(uint8_t)(_boot & 0xFF), (uint8_t)(_boot >> 8)};
+                file.write(bytes, 2);
+                file.close();
+            }
+        }
+    }
+    return _boot;
+}
+
+bool TelemetryBuffer::_isCurrentBoot(const Header& header) {
+    return _bootAssigned && header.boot == _boot;
+}
+
+size_t TelemetryBuffer::_entryOverhead(const Header& header, bool binary) {
+    bool aged = _isCurrentBoot(header);
+    if (binary) {
+        return aged ? sizeof(MSGPACK_AGE) + 4 + sizeof(MSGPACK_DATA) : 1 + sizeof(MSGPACK_DATA);
+    }
+    if (aged) {
+        return (sizeof(JSON_AGE) - 1) + _digits(_batchNow - header.capturedAt) + (sizeof(JSON_DATA_AFTER_AGE) - 1) + 1;
+    }
+    return (sizeof(JSON_DATA) - 1) + 1;
+}
+
+void TelemetryBuffer::store(JsonDocument& doc, bool binary) {
+    size_t length = binary ? measureMsgPack(doc) : measureJson(doc);
+    if (length == 0 || length > 0xFFFF) {
+        return;
+    }
+
+    Header header;
+    header.length = length;
+    header.binary = binary ? 1 : 0;
+    header.boot = _bootTag();
+    header.capturedAt = millis();
+
+    // The serializers write a terminating zero, hence the extra byte.
+    size_t needed = HEADER_SIZE + length + 1;
+    if (needed > _ramCapacity) {
+        // Too large to stage: straight to flash.
+        flush();
+        if (!_fsReady) {
+            _droppedBytes += HEADER_SIZE + length;
+            return;
+        }
+        uint8_t head[HEADER_SIZE];
+        _encodeHeader(head, header);
+        File file = LittleFS.open(LOG_PATH, "a");
+        if (!file) {
+            _droppedBytes += HEADER_SIZE + length;
+            return;
+        }
+        file.write(head, HEADER_SIZE);
+        size_t written = binary ? serializeMsgPack(doc, file) : serializeJson(doc, file);
+        file.close();
+        _logSize += HEADER_SIZE + written;
+        _rotateIfFull();
+        return;
+    }
+
+    if (_ramUsed + needed > _ramCapacity) {
+        flush();
+    }
+    if (_ram.size() < _ramCapacity) {
+        _ram.resize(_ramCapacity);
+    }
+    _encodeHeader(&_ram[_ramUsed], header);
+    char* payload = (char*)&_ram[_ramUsed + HEADER_SIZE];
+    if (binary) {
+        serializeMsgPack(doc, payload, length + 1);
+    } else {
+        serializeJson(doc, payload, length + 1);
+    }
+    _ramUsed += HEADER_SIZE + length;
+}
+
+void TelemetryBuffer::flush() {
+    if (_ramUsed == 0) {
+        return;
+    }
+    // A planned batch may point into the RAM buffer.
+    _batchSource = SOURCE_NONE;
+    if (_fsReady) {
+        _appendToLog(_ram.data(), _ramUsed);
+    } else {
+        _droppedBytes += _ramUsed;
+    }
+    _ramUsed = 0;
+}
+
+void TelemetryBuffer::_appendToLog(const uint8_t* data, size_t length) {
+    File file = LittleFS.open(LOG_PATH, "a");
+    if (!file) {
+        _droppedBytes += length;
+        return;
+    }
+    _logSize += file.write(data, length);
+    file.close();
+    _rotateIfFull();
+}
+
+void TelemetryBuffer::_rotateIfFull() {
+    if (_logSize < _fileCapacity / 2) {
+        return;
+    }
+    if (_oldSize > _oldOffset) {
+        _droppedBytes += _oldSize - _oldOffset;
+        Log.warn("TelemetryBuffer: History full, dropping the oldest half.");
+    }
+    LittleFS.remove(OLD_PATH);
+    LittleFS.rename(LOG_PATH, OLD_PATH);
+    _oldSize = _logSize;
+    _oldOffset = _logOffset;
+    _logSize = 0;
+    _logOffset = 0;
+    _batchSource = SOURCE_NONE;
+}
+
+bool TelemetryBuffer::isEmpty() {
+    return _oldestSource() == SOURCE_NONE;
+}
+
+size_t TelemetryBuffer::pendingBytes() {
+    return (_oldSize - _oldOffset) + (_logSize - _logOffset) + _ramUsed;
+}
+
+unsigned long TelemetryBuffer::getDroppedBytes() {
+    return _droppedBytes;
+}
+
+TelemetryBuffer::Source TelemetryBuffer::_oldestSource() {
+    if (_oldOffset < _oldSize) return SOURCE_OLD_FILE;
+    if (_logOffset < _logSize) return SOURCE_LOG_FILE;
+    if (_ramUsed > 0) return SOURCE_RAM;
+    return SOURCE_NONE;
+}
+
+size_t TelemetryBuffer::_sourceSize(Source source) {
+    switch (source) {
+        case SOURCE_OLD_FILE: return _oldSize;
+        case SOURCE_LOG_FILE: return _logSize;
+        case SOURCE_RAM: return _ramUsed;
+        default: return 0;
+    }
+}
+
+size_t TelemetryBuffer::_sourceOffset(Source source) {
+    switch (source) {
+        case SOURCE_OLD_FILE: return _oldOffset;
+        case SOURCE_LOG_FILE: return _logOffset;
+        default: return 0;
+    }
+}
+
+const char* TelemetryBuffer::_sourcePath(Source source) {
+    return source == SOURCE_OLD_FILE ? OLD_PATH : LOG_PATH;
+}
+
+bool TelemetryBuffer::_readHeader(Source source, File* file, size_t offset, Header& header) {
+    if (offset + HEADER_SIZE > _sourceSize(source)) {
+        return false;
+    }
+    if (source == SOURCE_RAM) {
+        _decodeHeader(&_ram[offset], header);
+    } else {
+        uint8_t head[HEADER_SIZE];
+        if (!file->seek(offset) || file->read(head, HEADER_SIZE) != HEADER_SIZE) {
+            return false;
+        }
+        _decodeHeader(head, header);
+    }
+    return offset + HEADER_SIZE + header.length <= _sourceSize(source);
+}
+
+size_t TelemetryBuffer::beginBatch(size_t maxBytes, bool& binary) {
+    _batchSource = _oldestSource();
+    if (_batchSource == SOURCE_NONE) {
+        return 0;
+    }
+
+    File file;
+    if (_batchSource != SOURCE_RAM) {
+        file = LittleFS.open(_sourcePath(_batchSource), "r");
+        if (!file) {
+            // The file is gone; forget what it held.
+            _droppedBytes += _sourceSize(_batchSource) - _sourceOffset(_batchSource);
+            if (_batchSource == SOURCE_OLD_FILE) {
+                _oldSize = _oldOffset = 0;
+            } else {
+                _logSize = _logOffset = 0;
+            }
+            _batchSource = SOURCE_NONE;
+            return 0;
+        }
+    }
+
+    _batchNow = millis();
+    _batchStart = _sourceOffset(_batchSource);
+    _batchEnd = _batchStart;
+    _batchCount = 0;
+
+    // Array header and closing bracket (JSON) or array16 header (MessagePack).
+    size_t total = 3;
+    Header header;
+    while (_batchCount < 0xFFFF && _readHeader(_batchSource, &file, _batchEnd, header)) {
+        if (_batchCount == 0) {
+            _batchBinary = header.binary != 0;
+        } else if ((header.binary != 0) != _batchBinary) {
+            break;
+        }
+        size_t entry = _entryOverhead(header, _batchBinary) + header.length + (_batchBinary || _batchCount == 0 ? 0 : 1);
+        if (_batchCount > 0 && total + entry > maxBytes) {
+            break;
+        }
+        total += entry;
+        _batchEnd += HEADER_SIZE + header.length;
+        _batchCount++;
+    }
+    if (file) {
+        file.close();
+    }
+
+    if (_batchCount == 0) {
+        // Truncated record at the end of a file (e.g. power lost while writing): skip it.
+        _droppedBytes += _sourceSize(_batchSource) - _batchStart;
+        _batchEnd = _sourceSize(_batchSource);
+        commitBatch();
+        return 0;
+    }
+    if (!_batchBinary) {
+        // "[" and "]" instead of the 3-byte array16 header.
+        total -= 1;
+    }
+    binary = _batchBinary;
+    return total;
+}
+
+bool TelemetryBuffer::writeBatch(Print& out) {
+    if (_batchSource == SOURCE_NONE) {
+        return false;
+    }
+
+    File file;
+    if (_batchSource != SOURCE_RAM) {
+        file = LittleFS.open(_sourcePath(_batchSource), "r");
+        if (!file) {
+            return false;
+        }
+    }
+
+    if (_batchBinary) {
+        uint8_t head[3] = {0xdc, (uint8_t)(_batchCount >> 8), (uint8_t)(_batchCount & 0xFF)};
+        out.write(head, 3);
+    } else {
+        out.write((const uint8_t*)"[", 1);
+    }
+
+    size_t offset = _batchStart;
+    Header header;
+    for (uint16_t i = 0; i < _batchCount && _readHeader(_batchSource, &file, offset, header); i++) {
+        bool aged = _isCurrentBoot(header);
+        uint32_t age = _batchNow - header.capturedAt;
+        if (_batchBinary) {
+            if (aged) {
+                uint8_t value[4] = {(uint8_t)(age >> 24), (uint8_t)(age >> 16), (uint8_t)(age >> 8), (uint8_t)age};
+                out.write(MSGPACK_AGE, sizeof(MSGPACK_AGE));
+                out.write(value, 4);
+            } else {
+                out.write(&MSGPACK_DATA_ONLY, 1);
+            }
+            out.write(MSGPACK_DATA, sizeof(MSGPACK_DATA));
+        } else {
+            if (i > 0) {
+                out.write((const uint8_t*)",", 1);
+            }
+            if (aged) {
+                out.print(JSON_AGE);
+                out.print(String(age));
+                out.print(JSON_DATA_AFTER_AGE);
+            } else {
+                out.print(JSON_DATA);
+            }
+        }
+
+        size_t start = offset + HEADER_SIZE;
+        if (_batchSource == SOURCE_RAM) {
+            out.write(&_ram[start], header.length);
+        } else {
+            uint8_t chunk[COPY_CHUNK];
+            size_t remaining = header.length;
+            file.seek(start);
+            while (remaining > 0) {
+                size_t n = file.read(chunk, remaining < COPY_CHUNK ? remaining : COPY_CHUNK);
+                if (n == 0) break;
+                out.write(chunk, n);
+                remaining -= n;
+            }
+        }
+        if (!_batchBinary) {
+            out.write((const uint8_t*)"}", 1);
+        }
+        offset = start + header.length;
+    }
+
+    if (!_batchBinary) {
+        out.write((const uint8_t*)"]", 1);
+    }
+    if (file) {
+        file.close();
+    }
+    return true;
+}
+
+void TelemetryBuffer::commitBatch() {
+    switch (_batchSource) {
+        case SOURCE_OLD_FILE:
+            _oldOffset = _batchEnd;
+            if (_oldOffset >= _oldSize) {
+                LittleFS.remove(OLD_PATH);
+                _oldSize = _oldOffset = 0;
+            }
+            break;
+        case SOURCE_LOG_FILE:
+            _logOffset = _batchEnd;
+            if (_logOffset >= _logSize) {
+                LittleFS.remove(LOG_PATH);
+                _logSize = _logOffset = 0;
+            }
+            break;
+        case SOURCE_RAM:
+            memmove(_ram.data(), _ram.data() + _batchEnd, _ramUsed - _batchEnd);
+            _ramUsed -= _batchEnd;
+            break;
+        default:
+            break;
+    }
+    _batchSource = SOURCE_NONE;
+}
\ No newline at end of file
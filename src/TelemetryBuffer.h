@@ -0,0 +1,92 @@
+#ifndef TELEMETRY_BUFFER_H
+#define TELEMETRY_BUFFER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <vector>
+
+// Keeps exchange payloads that could not be delivered and hands them back in batches once the
+// broker is reachable again. Snapshots are staged in RAM; when the RAM buffer is full it is
+// appended to a log on LittleFS. The log is held to a size limit by rotating it into a second
+// file and dropping the previous one, so the oldest history goes first.
+//
+// Replay is at-least-once: records are only dropped by commitBatch(), and the read position is
+// not persisted, so a reboot in the middle of a replay sends part of the log again.
+class TelemetryBuffer {
+    public:
+        static const size_t HEADER_SIZE = 9;
+
+    private:
+        enum Source {
+            SOURCE_OLD_FILE = 0,
+            SOURCE_LOG_FILE,
+            SOURCE_RAM,
+            SOURCE_NONE
+        };
+
+        // Stored in front of every snapshot, little-endian.
+        struct Header {
+            uint16_t length;
+            uint8_t binary;
+            uint16_t boot;
+            uint32_t capturedAt;
+        };
+
+        std::vector<uint8_t> _ram;
+        size_t _ramUsed;
+        size_t _ramCapacity;
+        size_t _fileCapacity;
+        bool _fsReady;
+        bool _bootAssigned;
+        uint16_t _boot;
+        size_t _oldSize;
+        size_t _oldOffset;
+        size_t _logSize;
+        size_t _logOffset;
+        unsigned long _droppedBytes;
+
+        // The batch planned by beginBatch().
+        Source _batchSource;
+        size_t _batchStart;
+        size_t _batchEnd;
+        uint16_t _batchCount;
+        bool _batchBinary;
+        uint32_t _batchNow;
+
+        static void _encodeHeader(uint8_t* out, const Header& header);
+        static void _decodeHeader(const uint8_t* in, Header& header);
+        static size_t _digits(uint32_t value);
+        uint16_t _bootTag();
+        bool _isCurrentBoot(const Header& header);
+        size_t _entryOverhead(const Header& header, bool binary);
+        Source _oldestSource();
+        size_t _sourceSize(Source source);
+        size_t _sourceOffset(Source source);
+        const char* _sourcePath(Source source);
+        bool _readHeader(Source source, File* file, size_t offset, Header& header);
+        void _appendToLog(const uint8_t* data, size_t length);
+        void _rotateIfFull();
+
+    public:
+        TelemetryBuffer(size_t ramCapacity, size_t fileCapacity);
+        void begin();
+
+        // Serializes the document (JSON or MessagePack) and keeps it with the current uptime.
+        void store(JsonDocument& doc, bool binary);
+        // Moves the RAM buffer to flash, e.g. before a reboot or deep sleep.
+        void flush();
+        bool isEmpty();
+        size_t pendingBytes();
+        unsigned long getDroppedBytes();
+
+        // Plans the next batch: consecutive records of one encoding, up to maxBytes framed but
+        // always at least one record. Returns the framed size, 0 if there is nothing to replay.
+        size_t beginBatch(size_t maxBytes, bool& binary);
+        // Streams the planned batch as an array of {"ageMs": <ms ago>, "data": <payload>}.
+        // Records from an earlier boot have no "ageMs"; their time is unknown.
+        bool writeBatch(Print& out);
+        void commitBatch();
+};
+
+#endif
\ No newline at end of file
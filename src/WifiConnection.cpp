@@ -1,19 +1,37 @@
 #include "WifiConnection.h"
 #include "Logger.h"
+#include "StateFingerprint.h"
+#include "ConfigStore.h"
+
+// The resolver does not report the record's TTL, so answers are trusted for this long.
+static const unsigned long DNS_CACHE_TTL = 10UL * 60 * 1000;
+static const unsigned long DEFAULT_CONNECT_TIMEOUT = 3000;
+static const unsigned long DEFAULT_READ_TIMEOUT = 5000;
+
+// A hinted connect takes a few hundred ms; one that takes longer than this is given up.
+static const unsigned long FAST_CONNECT_TIMEOUT = 3000;
+static const uint32_t WIFI_CACHE_MAGIC = 0x57494649;
+
 #ifdef ESP32
-#include <HTTPClient.h>
-#else
-#include <ESP8266HTTPClient.h>
+RTC_DATA_ATTR static WifiLinkCache rtcLinkCache;
 #endif
-#include <WiFiClient.h>
 
-WifiConnection::WifiConnection(const char* ssid, const char* password, WiFiSleepType sleepMode) 
-    : _ssid(ssid), _password(password), _lastReconnectAttempt(0), _sleepMode(sleepMode), _wasConnected(false) {
+WifiConnection::WifiConnection(const char* ssid, const char* password, WiFiSleepType sleepMode, int eepromOffset) 
+    : _name("wifi"), _ssid(ssid), _password(password), _eepromOffset(eepromOffset), _sleepMode(sleepMode), _wasConnected(false),
+      _cacheValid(false), _reuseLease(false), _connectStart(0), _fastAttempt(false),
+      _lastConnectMs(0), _lastConnectFast(false), _fastConnects(0), _fullConnects(0), _fastFailures(0),
+      _connectTimeout(DEFAULT_CONNECT_TIMEOUT), _readTimeout(DEFAULT_READ_TIMEOUT) {
+    _http.setReuse(true);
+}
+
+void WifiConnection::setEepromOffset(int eepromOffset) {
+    _eepromOffset = eepromOffset;
 }
 
 void WifiConnection::begin() {
+    // The cached hint is managed here; the SDK does not need to write its own copy to flash.
+    WiFi.persistent(false);
     WiFi.mode(WIFI_STA);
-    WiFi.begin(_ssid, _password);
 
     if (_sleepMode) {
 #ifdef ESP32
@@ -25,61 +43,331 @@ void WifiConnection::begin() {
     }
     Log.info("Connecting to WiFi:");
     Log.info(_ssid);
+
+    _loadCache();
+    _startConnect(true);
 }
 
 void WifiConnection::update() {
+    unsigned long currentMillis = millis();
     if (WiFi.status() == WL_CONNECTED) {
         if (!_wasConnected) {
-            Log.info("WiFi Connected!");
+            _lastConnectMs = currentMillis - _connectStart;
+            _lastConnectFast = _fastAttempt;
+            if (_fastAttempt) {
+                _fastConnects++;
+            } else {
+                _fullConnects++;
+            }
+            Log.info(("WiFi Connected! " + String(_fastAttempt ? "Fast" : "Full") + " connect, ms: " + String(_lastConnectMs)).c_str());
             Log.info(WiFi.localIP().toString().c_str());
             _wasConnected = true;
+            _saveCache();
         }
         return;
     }
     
-    _wasConnected = false;
+    if (_wasConnected) {
+        // The kept-alive connection did not survive the outage.
+        _httpClient.stop();
+        _wasConnected = false;
+        Log.warn("WiFi disconnected. Attempting to reconnect...");
+        _startConnect(true);
+        return;
+    }
+
+    // A hinted attempt that has not come up in time is followed by a full scan: the AP may have
+    // changed channel, or the lease be taken. The next retry tries the hint again.
+    if (_fastAttempt && currentMillis - _connectStart >= FAST_CONNECT_TIMEOUT) {
+        Log.warn("WiFi fast connect failed, scanning.");
+        _fastFailures++;
+        _startConnect(false);
+        return;
+    }
 
     // If not connected, check if it's time to retry
-    unsigned long currentMillis = millis();
-    if (currentMillis - _lastReconnectAttempt >= _reconnectInterval) {
-        _lastReconnectAttempt = currentMillis;
+    if (currentMillis - _connectStart >= _reconnectInterval) {
         Log.warn("WiFi disconnected. Attempting to reconnect...");
-        WiFi.disconnect(); 
+        _startConnect(true);
+    }
+}
+
+void WifiConnection::_startConnect(bool useHint) {
+    _connectStart = millis();
+    WiFi.disconnect();
+    _fastAttempt = useHint && _cacheValid;
+    if (_fastAttempt && _reuseLease && _cache.ip != 0) {
+        WiFi.config(IPAddress(_cache.ip), IPAddress(_cache.gateway), IPAddress(_cache.subnet), IPAddress(_cache.dns));
+    } else {
+        // Back to DHCP.
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    }
+    if (_fastAttempt) {
+        WiFi.begin(_ssid, _password, _cache.channel, _cache.bssid);
+    } else {
         WiFi.begin(_ssid, _password);
     }
 }
 
+void WifiConnection::_loadCache() {
+#ifdef ESP32
+    if (rtcLinkCache.magic == WIFI_CACHE_MAGIC) {
+        _cache = rtcLinkCache;
+    } else if (_eepromOffset >= 0) {
+        Settings.get(_eepromOffset, _cache);
+    }
+#else
+    if ((!ESP.rtcUserMemoryRead(WIFI_RTC_OFFSET, (uint32_t*)&_cache, sizeof(_cache)) || _cache.magic != WIFI_CACHE_MAGIC) && _eepromOffset >= 0) {
+        Settings.get(_eepromOffset, _cache);
+    }
+#endif
+    _cacheValid = _cache.magic == WIFI_CACHE_MAGIC && _cache.channel > 0;
+    if (_cache.magic == WIFI_CACHE_MAGIC) {
+        _reuseLease = _cache.reuseLease != 0;
+    } else {
+        memset(&_cache, 0, sizeof(_cache));
+    }
+}
+
+void WifiConnection::_saveCache() {
+    WifiLinkCache cache;
+    memset(&cache, 0, sizeof(cache));
+    memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+    cache.reuseLease = _reuseLease ? 1 : 0;
+    cache.channel = WiFi.channel();
+    cache.ip = (uint32_t)WiFi.localIP();
+    cache.gateway = (uint32_t)WiFi.gatewayIP();
+    cache.subnet = (uint32_t)WiFi.subnetMask();
+    cache.dns = (uint32_t)WiFi.dnsIP();
+    cache.magic = WIFI_CACHE_MAGIC;
+
+    _cache = cache;
+    _cacheValid = true;
+    _storeCache();
+}
+
+// Writes _cache to both copies; _loadCache() prefers the RTC one, so they must not disagree.
+void WifiConnection::_storeCache() {
+#ifdef ESP32
+    rtcLinkCache = _cache;
+#else
+    ESP.rtcUserMemoryWrite(WIFI_RTC_OFFSET, (uint32_t*)&_cache, sizeof(_cache));
+#endif
+    // The store skips the commit when nothing changed, which is usual after the first connect.
+    if (_eepromOffset >= 0) {
+        Settings.put(_eepromOffset, _cache);
+    }
+}
+
 bool WifiConnection::isConnected() {
     return WiFi.status() == WL_CONNECTED;
 }
 
 String WifiConnection::postJson(const char* endpoint, const String& jsonBody) {
+    return postJson(endpoint, (const uint8_t*)jsonBody.c_str(), jsonBody.length());
+}
+
+String WifiConnection::postJson(const char* endpoint, const uint8_t* body, size_t length) {
     if (WiFi.status() != WL_CONNECTED) {
         Log.warn("WifiConnection: Cannot POST, WiFi not connected.");
         return "";
     }
 
-    WiFiClient client;
-    HTTPClient http;
-
     Log.info("WifiConnection: Posting to");
     Log.info(endpoint);
 
-    if (http.begin(client, endpoint)) {
-        http.addHeader("Content-Type", "application/json");
-        int httpCode = http.POST(jsonBody);
-        String response = "";
-
-        if (httpCode > 0) {
-            response = http.getString();
-            Log.info("WifiConnection: POST response code:");
-            Log.info(String(httpCode).c_str());
-        } else {
-            Log.error("WifiConnection: POST failed, error:");
-            Log.error(http.errorToString(httpCode).c_str());
+    // A kept-alive connection may have been closed by the server in the meantime; if the post
+    // fails on a reused connection, try once more on a fresh one.
+    bool reused = _httpClient.connected();
+    int httpCode = _post(endpoint, body, length);
+    if (httpCode <= 0 && reused) {
+        Log.warn("WifiConnection: Kept-alive connection failed, reconnecting.");
+        httpCode = _post(endpoint, body, length);
+    }
+
+    String response = "";
+    if (httpCode > 0) {
+        response = _http.getString();
+        Log.info("WifiConnection: POST response code:");
+        Log.info(String(httpCode).c_str());
+    } else {
+        Log.error("WifiConnection: POST failed, error:");
+        Log.error(HTTPClient::errorToString(httpCode).c_str());
+    }
+    // With reuse set, this leaves the TCP connection open for the next post.
+    _http.end();
+    return response;
+}
+
+int WifiConnection::_post(const char* endpoint, const uint8_t* body, size_t length) {
+    String host;
+    uint16_t port;
+    if (!_splitUrl(endpoint, host, port)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    // HTTPClient would resolve the host on every connect; connecting the client to the cached
+    // address first makes it reuse that connection instead.
+    if (!_httpClient.connected() && !_connectHttp(host, port)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    if (!_http.begin(_httpClient, endpoint)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    _http.setTimeout(_readTimeout);
+    _http.addHeader("Content-Type", "application/json");
+    // The ESP32 client takes a non-const pointer but does not modify the payload.
+    int httpCode = _http.POST((uint8_t*)body, length);
+    if (httpCode <= 0) {
+        _http.end();
+        _httpClient.stop();
+        forgetHost(host.c_str());
+    }
+    return httpCode;
+}
+
+bool WifiConnection::_connectHttp(const String& host, uint16_t port) {
+    IPAddress address;
+    if (!resolve(host.c_str(), address)) {
+        return false;
+    }
+#ifdef ESP32
+    bool connected = _httpClient.connect(address, port, _connectTimeout);
+#else
+    // The ESP8266 client uses its stream timeout for the connect.
+    _httpClient.setTimeout(_connectTimeout);
+    bool connected = _httpClient.connect(address, port);
+#endif
+    if (!connected) {
+        Log.error(("WifiConnection: Could not connect to " + host).c_str());
+        forgetHost(host.c_str());
+    }
+    return connected;
+}
+
+bool WifiConnection::_splitUrl(const char* url, String& host, uint16_t& port) {
+    host = url;
+    port = 80;
+    int schemeEnd = host.indexOf("://");
+    if (schemeEnd != -1) {
+        host = host.substring(schemeEnd + 3);
+    }
+    int pathStart = host.indexOf('/');
+    if (pathStart != -1) {
+        host = host.substring(0, pathStart);
+    }
+    int colonIndex = host.indexOf(':');
+    if (colonIndex != -1) {
+        port = host.substring(colonIndex + 1).toInt();
+        host = host.substring(0, colonIndex);
+    }
+    return host.length() > 0 && port > 0;
+}
+
+bool WifiConnection::resolve(const char* host, IPAddress& address) {
+    unsigned long now = millis();
+    DnsEntry* slot = &_dnsCache[0];
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        DnsEntry& entry = _dnsCache[i];
+        if (entry.host == host) {
+            if (now - entry.resolvedAt < DNS_CACHE_TTL) {
+                address = entry.address;
+                return true;
+            }
+            slot = &entry;
+            break;
+        }
+        // Otherwise reuse a free slot, or the oldest one.
+        if (slot->host.length() > 0 && (entry.host.length() == 0 || now - entry.resolvedAt > now - slot->resolvedAt)) {
+            slot = &entry;
+        }
+    }
+
+    // Addresses given as such need no lookup.
+    if (address.fromString(host)) {
+        return true;
+    }
+    if (WiFi.status() != WL_CONNECTED || !WiFi.hostByName(host, address)) {
+        Log.error(("WifiConnection: DNS lookup failed for " + String(host)).c_str());
+        return false;
+    }
+    slot->host = host;
+    slot->address = address;
+    slot->resolvedAt = now;
+    return true;
+}
+
+void WifiConnection::forgetHost(const char* host) {
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (_dnsCache[i].host == host) {
+            _dnsCache[i].host = "";
+        }
+    }
+}
+
+void WifiConnection::setTimeouts(unsigned long connectTimeout, unsigned long readTimeout) {
+    _connectTimeout = connectTimeout;
+    _readTimeout = readTimeout;
+}
+
+void WifiConnection::addToJson(JsonArray& doc) {
+    JsonObject nested = doc.createNestedObject();
+    nested["type"] = "System";
+    nested["subtype"] = "WifiConnection";
+    nested["name"] = _name;
+    nested["connectMs"] = _lastConnectMs;
+    nested["fastConnect"] = _lastConnectFast;
+    nested["fastConnects"] = _fastConnects;
+    nested["fullConnects"] = _fullConnects;
+    nested["fastFailures"] = _fastFailures;
+    nested["channel"] = _cache.channel;
+}
+
+uint32_t WifiConnection::getStateFingerprint() {
+    StateFingerprint fp;
+    fp.add(_fastConnects);
+    fp.add(_fullConnects);
+    fp.add(_fastFailures);
+    fp.add((long)_cache.channel);
+    fp.add(getConfigFingerprint());
+    return fp.value();
+}
+
+void WifiConnection::addConfigToJson(JsonObject& nested) {
+    nested["reuseLease"] = _reuseLease;
+}
+
+uint32_t WifiConnection::getConfigFingerprint() {
+    StateFingerprint fp;
+    fp.add(_reuseLease);
+    return fp.value();
+}
+
+void WifiConnection::processCommand(JsonObject& command) {
+    if (command.containsKey("setReuseLease")) {
+        bool reuseLease = command["setReuseLease"].as<bool>();
+        if (reuseLease != _reuseLease) {
+            _reuseLease = reuseLease;
+            // The setting lives in the cache record, which holds no network yet on a fresh node.
+            _cache.reuseLease = _reuseLease ? 1 : 0;
+            _cache.magic = WIFI_CACHE_MAGIC;
+            _storeCache();
+            Log.info(reuseLease ? "WifiConnection: Reusing the IP lease on reconnect" : "WifiConnection: Using DHCP on reconnect");
         }
-        http.end();
-        return response;
     }
-    return "";
+
+    if (command.containsKey("forgetNetwork")) {
+        // Next connect scans and uses DHCP, also after a reboot or deep sleep. The record stays for
+        // the lease setting; without a channel it holds no network.
+        memset(&_cache, 0, sizeof(_cache));
+        _cache.reuseLease = _reuseLease ? 1 : 0;
+        _cache.magic = WIFI_CACHE_MAGIC;
+        _cacheValid = false;
+        _storeCache();
+        Log.info("WifiConnection: Cached network forgotten");
+    }
 }
+
+const String& WifiConnection::getName() {
+    return _name;
+}
\ No newline at end of file
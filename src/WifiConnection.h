@@ -11,22 +11,105 @@ typedef bool WiFiSleepType;
 #else
 #include <ESP8266WiFi.h>
 #endif
+#ifdef ESP32
+#include <HTTPClient.h>
+#else
+#include <ESP8266HTTPClient.h>
+#endif
+#include <WiFiClient.h>
+
+#include "JsonProvider.h"
+
+// The access point and IP lease of the last good connection. Kept in RTC memory across deep
+// sleep and in EEPROM across power loss, and used as a hint so reconnects skip the scan.
+struct WifiLinkCache {
+    uint8_t bssid[6];
+    uint8_t reuseLease;  // Setting: also skip DHCP by reusing ip/gateway/subnet/dns
+    uint8_t reserved;
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint32_t magic;
+};
+
+#ifndef ESP32
+// Where the link cache is kept in the ESP8266's RTC user memory, in 4-byte words. eboot keeps
+// its OTA/boot command in words 0-31, which must be left alone; others follow WIFI_RTC_END.
+static const uint32_t WIFI_RTC_OFFSET = 32;
+static const uint32_t WIFI_RTC_END = WIFI_RTC_OFFSET + (sizeof(WifiLinkCache) + 3) / 4;
+#endif
 
-class WifiConnection {
+class WifiConnection : public JsonProvider {
   private:
+    String _name;
     const char* _ssid;
     const char* _password;
-    unsigned long _lastReconnectAttempt;
+    int _eepromOffset;
     WiFiSleepType _sleepMode;
     const unsigned long _reconnectInterval = 10000; // Retry every 10 seconds
     bool _wasConnected;
 
+    WifiLinkCache _cache;
+    bool _cacheValid;
+    bool _reuseLease;
+    // The attempt in progress: when it started and whether it used the cached hint.
+    unsigned long _connectStart;
+    bool _fastAttempt;
+    // Connect metrics.
+    unsigned long _lastConnectMs;
+    bool _lastConnectFast;
+    unsigned long _fastConnects;
+    unsigned long _fullConnects;
+    unsigned long _fastFailures;
+
+    void _startConnect(bool useHint);
+    void _loadCache();
+    void _saveCache();
+    void _storeCache();
+
+    // Host names resolved recently, shared by the HTTP fallback and the MQTT connect.
+    struct DnsEntry {
+        String host;
+        IPAddress address;
+        unsigned long resolvedAt;
+    };
+    static const int DNS_CACHE_SIZE = 4;
+    DnsEntry _dnsCache[DNS_CACHE_SIZE];
+
+    // One HTTP session for all posts; the TCP connection is kept open between them.
+    WiFiClient _httpClient;
+    HTTPClient _http;
+    unsigned long _connectTimeout;
+    unsigned long _readTimeout;
+
+    bool _connectHttp(const String& host, uint16_t port);
+    int _post(const char* endpoint, const uint8_t* body, size_t length);
+    static bool _splitUrl(const char* url, String& host, uint16_t& port);
+
   public:
-    WifiConnection(const char* ssid, const char* password, WiFiSleepType sleepMode = WIFI_NONE_SLEEP);
+    WifiConnection(const char* ssid, const char* password, WiFiSleepType sleepMode = WIFI_NONE_SLEEP, int eepromOffset = -1);
+    // Where the link cache is kept in EEPROM (-1: RTC memory only). Set from the room's
+    // EepromLayout before begin().
+    void setEepromOffset(int eepromOffset);
     void begin();
     void update();
     bool isConnected();
     String postJson(const char* endpoint, const String& jsonBody);
+    String postJson(const char* endpoint, const uint8_t* body, size_t length);
+    // Looks the host up, or answers from the cache if it was resolved recently.
+    bool resolve(const char* host, IPAddress& address);
+    // Drops a cached address, e.g. after connecting to it failed.
+    void forgetHost(const char* host);
+    void setTimeouts(unsigned long connectTimeout, unsigned long readTimeout);
+
+    void addToJson(JsonArray& doc) override;
+    void addConfigToJson(JsonObject& nested) override;
+    uint32_t getConfigFingerprint() override;
+    uint32_t getStateFingerprint() override;
+    void processCommand(JsonObject& command) override;
+    const String& getName() override;
 };
 
 #endif
@@ -1,11 +1,17 @@
 #include <Arduino.h>
-#include <EEPROM.h>
 #ifdef ESP32
 #include <esp_wifi.h>
 #endif
 
 #include "Logger.h"
 #include "Configuration.h"
+#include "LoopScheduler.h"
+#include "OneWireBus.h"
+#include "Profiler.h"
+#include "ConfigStore.h"
+#include "BistableRelayControl.h"
+
+LoopScheduler scheduler(allDevices);
 
 void turnOffLights() {
     for (auto* device : switchableDevices) {
@@ -13,16 +19,77 @@ void turnOffLights() {
     }
 }
 
+bool anyLightOn() {
+    for (auto* device : switchableDevices) {
+        if (device->isOn()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isNetworkWake() {
+    return !dutyCycle || dutyCycle->isNetworkWake();
+}
+
+// Duty-cycle mode: once this wake has done its work, deep-sleep until the next one. Nothing
+// that needs the node awake (a light that is on, a relay coil pulse) may be running.
+void endWakeIfDone() {
+    if (!dutyCycle || !dutyCycle->isEnabled() || anyLightOn() || BistableRelayControl::pulsesPending()) {
+        return;
+    }
+    if (!dutyCycle->isNetworkWake()) {
+        if (dutyCycle->sampleWindowElapsed()) {
+            dutyCycle->recordSample();
+            dutyCycle->sleep();
+        }
+        return;
+    }
+    // Publish once MQTT is up (commands queued for us have been read by then), or over the HTTP
+    // fallback once the wake has waited long enough.
+    if ((dataExchanger.isOnline() && dutyCycle->sampleWindowElapsed()) || dutyCycle->networkWindowElapsed()) {
+        dutyCycle->recordSample();
+        if (dataExchanger.exchange(true, "duty_cycle")) {
+            dutyCycle->markDelivered();
+        }
+        // A command in the reply may have ended duty-cycle mode.
+        if (dutyCycle->isEnabled()) {
+            dataExchanger.flushHistory();
+            dutyCycle->sleep();
+        }
+    }
+}
+
 void setup() {
     Log.begin();
     Log.info("Starting up...");
-    // Reserve 1024 bytes for config to accommodate larger DataExchanger and multiple devices
-    EEPROM.begin(1024);
+    // Sized by the room's EepromLayout: exactly the config records of its devices.
+    Settings.begin(EEPROM_SIZE);
+    Log.info(("EEPROM layout uses bytes: " + String((unsigned long)EEPROM_SIZE)).c_str());
     
     // Initialize configuration (instantiate objects, wire them up)
     setupConfiguration();
 
-    wifi.begin();
+    // OneWire buses are created by the DS18B20s that use them; they publish sensors nobody claimed.
+    for (auto* bus : OneWireBus::all()) {
+        if (!allDevices.add(bus)) {
+            Log.error("No device slot left for a OneWire bus; raise RUNTIME_DEVICE_SLOTS.");
+            continue;
+        }
+        dataExchanger.addProvider(bus);
+    }
+    // Connect timing of the WiFi link.
+    dataExchanger.addProvider(&wifi);
+
+    if (dutyCycle) {
+        dutyCycle->begin();
+        dataExchanger.addProvider(dutyCycle);
+    }
+
+    // Duty-cycle wakes that only take a sample leave the radio off.
+    if (isNetworkWake()) {
+        wifi.begin();
+    }
 
 #ifdef ESP32
     // Enable Modem Sleep (Automatic Radio Sleep).
@@ -43,6 +110,9 @@ void setup() {
     for (auto* device : allDevices) {
         device->begin();
     }
+    if (dutyCycle) {
+        dutyCycle->restoreDevices();
+    }
 
     // Turn off lights on startup.
     turnOffLights();
@@ -51,23 +121,34 @@ void setup() {
 }
 
 void loop() {
+    Prof.beginPass();
+
+    bool networkWake = isNetworkWake();
+
     // Turn on the internal LED during network activity.
-    if (statusIndicator) statusIndicator->turnOn();
+    if (statusIndicator && networkWake) statusIndicator->turnOn();
 
     // Check connectivity and attempt to (re)connect if needed.
-    wifi.update();
+    if (networkWake) {
+        wifi.update();
+    }
 
-    // Generic Device Update Loop
+    // Generic Device Update Loop. Only devices with work due on this pass are updated.
+    scheduler.beginPass();
     for (auto* device : allDevices) {
-        device->update();
-        
-        if (device->shouldTriggerExchange()) {
+        if (scheduler.isDue(device)) {
+            uint32_t start = Prof.start();
+            device->update();
+            Prof.record(device, PROFILE_UPDATE, start);
+        }
+
+        if (networkWake && device->shouldTriggerExchange()) {
             dataExchanger.exchange(true, device->getName().c_str());
             device->resetTriggerExchange();
         }
     }
 
-    if (!dataExchanger.exchange()) {
+    if (networkWake && !dataExchanger.exchange()) {
         Log.warn("Data exchange failed. Refreshing device states.");
         for (auto* device : allDevices) {
             device->refreshState();
@@ -97,6 +178,10 @@ void loop() {
         Log.error("Critical Battery - shutting down.");
         turnOffLights();
         dataExchanger.exchange(true, "critical_battery_shutdown");
+        dataExchanger.flushHistory();
+        Settings.flush();
+        // Latch the relays turnOffLights() just switched before the chip goes down.
+        BistableRelayControl::finishPulses();
         // 3600e6 is 3,600,000,000 microseconds (1 hour)
         #ifdef ESP32
             esp_deep_sleep(3600e6);
@@ -109,13 +194,32 @@ void loop() {
     if (systemMonitor && systemMonitor->fragmentationIsCritical()) {
         Log.error("Fragmentation is critical - rebooting.");
         dataExchanger.exchange(true, "critical_fragmentation_reboot");
+        dataExchanger.flushHistory();
+        Settings.flush();
+        BistableRelayControl::finishPulses();
         ESP.restart();
     }
     
-    // Allow the chip to go to light sleep.
-    if (systemMonitor) {
-        delay(systemMonitor->getLoopDelay());
-    } else {
-        delay(20);
+    // Commit config changes once they have settled.
+    Settings.update();
+
+    endWakeIfDone();
+
+    // Allow the chip to go to light sleep until the next device deadline or scheduled exchange.
+    // Polling devices keep the loop at the base loop delay; the max loop
+    // delay bounds the sleep so that MQTT commands and WiFi reconnects are still serviced.
+    unsigned long pollInterval = systemMonitor ? systemMonitor->getLoopDelay() : 20;
+    unsigned long maxSleep = systemMonitor ? systemMonitor->getMaxLoopDelay() : pollInterval;
+    unsigned long sleepTime = scheduler.getSleepTime(pollInterval, maxSleep);
+    unsigned long exchangeDelay = dataExchanger.getExchangeDelay();
+    if (exchangeDelay < sleepTime) {
+        sleepTime = exchangeDelay;
+    }
+    unsigned long commitDelay = Settings.getCommitDelay();
+    if (commitDelay < sleepTime) {
+        sleepTime = commitDelay;
     }
+    // Button interrupts end the sleep early so presses are handled right away.
+    Prof.endPass(sleepTime);
+    scheduler.sleep(sleepTime);
 }
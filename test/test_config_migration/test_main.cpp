@@ -0,0 +1,91 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include <vector>
+#include "ConfigStore.h"
+#include "Configuration.h"
+
+// A node updated from the EEPROM-only firmware: its config is the image that firmware left in
+// the EEPROM (EEPROM.begin(1024), records at the offsets the room's layout now pins). The first
+// boot must take it over into the backend byte for byte, and only once.
+
+static const size_t LEGACY_EEPROM_SIZE = 1024;
+
+static uint8_t legacyByte(size_t address) {
+    return (uint8_t)(address * 7 + 3);
+}
+
+static void flashLegacyImage() {
+    EEPROM.begin(LEGACY_EEPROM_SIZE);
+    for (size_t i = 0; i < LEGACY_EEPROM_SIZE; i++) {
+        EEPROM.write(i, legacyByte(i));
+    }
+    EEPROM.commit();
+    EEPROM.end();
+}
+
+static std::vector<uint8_t> readImage(ConfigStore& store) {
+    std::vector<uint8_t> image(EEPROM_SIZE);
+    store.read(0, image.data(), image.size());
+    return image;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_first_boot_takes_over_the_eeprom_image() {
+    flashLegacyImage();
+
+    ConfigStore store;
+    store.begin(EEPROM_SIZE);
+    std::vector<uint8_t> image = readImage(store);
+    for (size_t i = 0; i < image.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(legacyByte(i), image[i]);
+    }
+}
+
+void test_later_boots_load_the_backend() {
+    // Anything still written to the EEPROM after the migration is not read again.
+    EEPROM.begin(EEPROM_SIZE);
+    for (size_t i = 0; i < EEPROM_SIZE; i++) {
+        EEPROM.write(i, 0);
+    }
+    EEPROM.commit();
+    EEPROM.end();
+
+    ConfigStore store;
+    store.begin(EEPROM_SIZE);
+    uint32_t value = 0x12345678;
+    store.put(EEPROM_SIZE - sizeof(value), value);
+    store.flush();
+
+    ConfigStore rebooted;
+    rebooted.begin(EEPROM_SIZE);
+    std::vector<uint8_t> image = readImage(rebooted);
+    for (size_t i = 0; i < image.size() - sizeof(value); i++) {
+        TEST_ASSERT_EQUAL_UINT32(legacyByte(i), image[i]);
+    }
+    uint32_t stored = 0;
+    TEST_ASSERT_EQUAL_UINT32(value, rebooted.get(EEPROM_SIZE - sizeof(value), stored));
+}
+
+void test_pinned_records_keep_their_offsets() {
+    struct Small { uint32_t value; };
+    struct Large { uint8_t bytes[40]; };
+    using Layout = EepromLayout<EepromAt<32, Large>, Small, EepromAt<2, Small>, Large>;
+    static_assert(Layout::offset<0, Large>() == 32, "pinned record moved");
+    // Appended records go after the furthest record listed before them...
+    static_assert(Layout::offset<1, Small>() == 72, "appended record misplaced");
+    static_assert(Layout::offset<2, Small>() == 2, "pinned record moved");
+    // ...even when an earlier pin is lower.
+    static_assert(Layout::offset<3, Large>() == 76, "appended record misplaced");
+    TEST_ASSERT_EQUAL_UINT32(116, Layout::size());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_boot_takes_over_the_eeprom_image);
+    RUN_TEST(test_later_boots_load_the_backend);
+    RUN_TEST(test_pinned_records_keep_their_offsets);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Sim.h>
+#include <unity.h>
+#include <random>
+#include <vector>
+#include "JournalConfigBackend.h"
+
+// Cuts the power at random points of config commits and compactions, reboots and checks what
+// the journal loads: the last committed image, plus at most a leading part of the commit that
+// was cut. Records of one commit are appended in order, so any prefix of them may have made it.
+
+static const size_t IMAGE_SIZE = 160;
+static const int POWER_CUTS = 2000;
+// Roughly the bytes a boot writes before the cut; enough to reach a compaction most of the time.
+static const long MAX_STEPS_TO_CUT = 1500;
+
+static std::mt19937 rng(20260101);
+
+static size_t randomBelow(size_t n) {
+    return std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+}
+
+struct Boot {
+    JournalConfigBackend backend;
+    std::vector<uint8_t> image = std::vector<uint8_t>(IMAGE_SIZE, 0xFF);
+};
+
+// What ConfigStore::begin() does with the backend.
+static void boot(Boot& boot) {
+    TEST_ASSERT_TRUE(boot.backend.begin(IMAGE_SIZE));
+    if (!boot.backend.load(boot.image)) {
+        boot.backend.store(boot.image);
+    }
+}
+
+static std::vector<ConfigRecord> randomRecords(std::vector<uint8_t>& image) {
+    std::vector<ConfigRecord> records;
+    size_t count = 1 + randomBelow(3);
+    for (size_t i = 0; i < count; i++) {
+        uint16_t length = 1 + randomBelow(24);
+        uint16_t offset = randomBelow(IMAGE_SIZE - length + 1);
+        for (uint16_t j = 0; j < length; j++) {
+            image[offset + j] = (uint8_t)randomBelow(256);
+        }
+        records.push_back({ offset, length });
+    }
+    return records;
+}
+
+// The images a reboot may find after a cut in a commit of these records on top of committed.
+static std::vector<std::vector<uint8_t>> survivors(const std::vector<uint8_t>& committed, const std::vector<uint8_t>& target,
+                                                    const std::vector<ConfigRecord>& records) {
+    std::vector<std::vector<uint8_t>> images = { committed };
+    std::vector<uint8_t> image = committed;
+    for (const ConfigRecord& record : records) {
+        memcpy(image.data() + record.offset, target.data() + record.offset, record.length);
+        images.push_back(image);
+    }
+    return images;
+}
+
+void setUp() {
+    LittleFS.format();
+    Sim::cutPowerAfterFsSteps(-1);
+}
+
+void tearDown() {
+    Sim::cutPowerAfterFsSteps(-1);
+}
+
+void test_commits_survive_reboots() {
+    std::vector<uint8_t> committed;
+    {
+        Boot first;
+        boot(first);
+        committed = first.image;
+        for (int i = 0; i < 50; i++) {
+            std::vector<ConfigRecord> records = randomRecords(first.image);
+            TEST_ASSERT_TRUE(first.backend.commit(first.image, records));
+            first.backend.update(first.image);
+        }
+        committed = first.image;
+    }
+    Boot second;
+    boot(second);
+    TEST_ASSERT_EQUAL_MEMORY(committed.data(), second.image.data(), IMAGE_SIZE);
+}
+
+void test_power_cuts_keep_a_consistent_image() {
+    std::vector<uint8_t> committed(IMAGE_SIZE, 0xFF);
+    unsigned long cutsInCommit = 0;
+    unsigned long cutsInCompaction = 0;
+    unsigned long cutsInRecovery = 0;
+    unsigned long partialCommits = 0;
+
+    for (int cut = 0; cut < POWER_CUTS; cut++) {
+        std::vector<std::vector<uint8_t>> allowed = { committed };
+        Sim::cutPowerAfterFsSteps(randomBelow(MAX_STEPS_TO_CUT));
+        try {
+            Boot running;
+            boot(running);
+            TEST_ASSERT_EQUAL_MEMORY(committed.data(), running.image.data(), IMAGE_SIZE);
+            while (true) {
+                std::vector<uint8_t> target = running.image;
+                std::vector<ConfigRecord> records = randomRecords(target);
+                allowed = survivors(committed, target, records);
+                running.image = target;
+                TEST_ASSERT_TRUE(running.backend.commit(running.image, records));
+                committed = running.image;
+                allowed = { committed };
+                // Compacts once the journal has grown; the image does not change.
+                running.backend.update(running.image);
+            }
+        } catch (const Sim::Reset& reset) {
+            TEST_ASSERT_TRUE(reset.reason == "power cut");
+            if (allowed.size() > 1) {
+                cutsInCommit++;
+            } else if (LittleFS.exists("/config.tmp")) {
+                cutsInCompaction++;
+            }
+        }
+
+        // Power is back. The reboot may be cut as well, while it repairs a torn journal.
+        Sim::cutPowerAfterFsSteps(randomBelow(4) == 0 ? (long)randomBelow(IMAGE_SIZE) : -1);
+        std::vector<uint8_t> loaded;
+        while (true) {
+            try {
+                Boot rebooted;
+                boot(rebooted);
+                loaded = rebooted.image;
+                break;
+            } catch (const Sim::Reset& reset) {
+                cutsInRecovery++;
+                Sim::cutPowerAfterFsSteps(-1);
+            }
+        }
+
+        bool found = false;
+        for (size_t i = 0; i < allowed.size() && !found; i++) {
+            if (memcmp(allowed[i].data(), loaded.data(), IMAGE_SIZE) == 0) {
+                found = true;
+                partialCommits += i > 0 && i < allowed.size() - 1 ? 1 : 0;
+            }
+        }
+        char message[80];
+        snprintf(message, sizeof(message), "Power cut %d loaded an image that was never committed", cut);
+        TEST_ASSERT_TRUE_MESSAGE(found, message);
+        committed = loaded;
+    }
+
+    char message[160];
+    snprintf(message, sizeof(message), "Power cuts: %d, in a commit: %lu (kept part of it: %lu), in a compaction: %lu, in the repair at boot: %lu",
+             POWER_CUTS, cutsInCommit, partialCommits, cutsInCompaction, cutsInRecovery);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, cutsInCommit);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, partialCommits);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, cutsInCompaction);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, cutsInRecovery);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_commits_survive_reboots);
+    RUN_TEST(test_power_cuts_keep_a_consistent_image);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include <Sim.h>
+#include <unity.h>
+#include <algorithm>
+#include <vector>
+#include "PwmAllocator.h"
+#include "RGBControl.h"
+#include "RelayControl.h"
+
+// Lights that get a new target while the LEDC fades them (ESP32 rooms only):
+//
+//     pio test -e native_woodshed -f test_light_fade -v
+//
+// The loop sleeps like it does on the node, until the update delay is up or the fade-end
+// interrupt comes. The simulated LEDC jumps to the end of each slice, so the output may move by
+// a slice's worth of steps at once, never more.
+
+void setUp() {}
+void tearDown() {}
+
+#ifdef ESP32
+static const unsigned long FADE_MS = 1000;
+static const unsigned long RETARGET_AT_MS = 250;
+// A slice of a full-range fade: 256 steps in FADE_MS / PwmAllocator::FADE_SLICE_MS slices.
+static const int MAX_STEP = 32;
+
+struct Output {
+    int pin;
+    int duty;
+};
+
+// Runs the light until untilMillis and fails if any output jumps.
+static void run(DeviceControl& light, std::vector<Output>& outputs, unsigned long untilMillis) {
+    while (millis() < untilMillis) {
+        light.update();
+        for (Output& output : outputs) {
+            int duty = Sim::getPwm(output.pin);
+            char message[80];
+            snprintf(message, sizeof(message), "Pin %d jumped from %d to %d at %lu ms", output.pin, output.duty, duty, millis());
+            TEST_ASSERT_TRUE_MESSAGE(abs(duty - output.duty) <= MAX_STEP, message);
+            output.duty = duty;
+        }
+        unsigned long wait = std::min(light.getUpdateDelay(), untilMillis - millis());
+        Sim::advanceUntil(std::max(wait, 1UL) * 1000, [] { return true; });
+    }
+}
+
+void test_relay_retargets_without_a_jump() {
+    RelayControl light("light", 5, false, true, 5000, -1);
+    light.begin();
+    light.setFadeDuration(FADE_MS);
+    std::vector<Output> outputs = { { 5, 0 } };
+    unsigned long start = millis();
+    light.turnOn();
+    run(light, outputs, start + RETARGET_AT_MS);
+
+    light.setPercentage(50, false);
+    run(light, outputs, start + RETARGET_AT_MS + 1);
+    // Back to where the fade was heading before it got anywhere else.
+    light.setPercentage(100, false);
+    run(light, outputs, start + FADE_MS + 2 * PwmAllocator::FADE_SLICE_MS);
+    TEST_ASSERT_EQUAL(PwmAllocator::MAX_DUTY, Sim::getPwm(5));
+
+    light.setPercentage(20, false);
+    run(light, outputs, millis() + RETARGET_AT_MS);
+    light.setPercentage(60, false);
+    run(light, outputs, millis() + 2 * FADE_MS);
+    TEST_ASSERT_EQUAL(PwmAllocator::MAX_DUTY * 60 / 100, Sim::getPwm(5));
+}
+
+void test_rgb_retargets_without_a_jump() {
+    RGBControl strip("strip", 12, 13, 14, false, 5000, -1);
+    strip.begin();
+    strip.setFadeDuration(FADE_MS);
+    strip.setRGB(255, 255, 255);
+    std::vector<Output> outputs = { { 12, Sim::getPwm(12) }, { 13, Sim::getPwm(13) }, { 14, Sim::getPwm(14) } };
+    unsigned long start = millis();
+    strip.turnOn();
+    run(strip, outputs, start + RETARGET_AT_MS);
+
+    strip.setRGB(255, 0, 255);
+    run(strip, outputs, start + RETARGET_AT_MS + 2 * PwmAllocator::FADE_SLICE_MS);
+    // Red and blue go on fading in while green turns back.
+    TEST_ASSERT_GREATER_THAN_UINT32(outputs[1].duty, outputs[0].duty);
+    run(strip, outputs, start + 3 * FADE_MS);
+    TEST_ASSERT_EQUAL(PwmAllocator::MAX_DUTY, Sim::getPwm(12));
+    TEST_ASSERT_EQUAL(0, Sim::getPwm(13));
+    TEST_ASSERT_EQUAL(PwmAllocator::MAX_DUTY, Sim::getPwm(14));
+}
+
+#endif
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    #ifdef ESP32
+        RUN_TEST(test_relay_retargets_without_a_jump);
+        RUN_TEST(test_rgb_retargets_without_a_jump);
+    #endif
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <Arduino.h>
+#include <Sim.h>
+#include <unity.h>
+#include "Device.h"
+#include "DeviceList.h"
+#include "LoopScheduler.h"
+
+// Counts the loop passes (wakeups) an hour of sensor work takes on the simulated clock: the
+// fixed-delay loop that updated every device every 20 ms, against the LoopScheduler sleeping
+// until the next device deadline.
+
+static const unsigned long LOOP_DELAY = 20;
+static const unsigned long MAX_LOOP_DELAY = 1000;
+static const unsigned long HOUR = 3600000;
+
+// A sensor read on an interval, like the DS18B20, SHT31, BME280 and INA219 readers.
+class IntervalDevice : public Device {
+    private:
+        String _name;
+        unsigned long _interval;
+        unsigned long _lastUpdateTime;
+        unsigned long _reads;
+
+    public:
+        IntervalDevice(const char* name, unsigned long interval) : _name(name), _interval(interval), _lastUpdateTime(0), _reads(0) {}
+
+        void begin() override {
+            _lastUpdateTime = millis();
+            _reads = 0;
+        }
+
+        void update() override {
+            if (millis() - _lastUpdateTime >= _interval) {
+                _lastUpdateTime = millis();
+                _reads++;
+            }
+        }
+
+        unsigned long getUpdateDelay() override {
+            return timeUntil(_lastUpdateTime, _interval);
+        }
+
+        void addToJson(JsonArray& doc) override {}
+        const String& getName() override { return _name; }
+        unsigned long getReads() { return _reads; }
+};
+
+// A device that polls, like a push button: it keeps the default delay of 0.
+class PollingDevice : public Device {
+    private:
+        String _name = "button";
+
+    public:
+        void addToJson(JsonArray& doc) override {}
+        const String& getName() override { return _name; }
+};
+
+static IntervalDevice tempSensor("tempSensor", 60000);
+static IntervalDevice climateSensor("climateSensor", 60000);
+static IntervalDevice bmeSensor("bmeSensor", 60000);
+static IntervalDevice loadMeter("loadMeter", 1000);
+static IntervalDevice chargeMeter("chargeMeter", 1000);
+static Device* deviceSlots[] = { &tempSensor, &climateSensor, &bmeSensor, &loadMeter, &chargeMeter };
+static DeviceList<Device> devices(deviceSlots, 5, 5);
+
+static void beginAll() {
+    for (auto* device : devices) {
+        device->begin();
+    }
+}
+
+// The loop before the scheduler: every device on every pass, then a flat delay.
+static unsigned long runFixedDelayLoop(unsigned long duration) {
+    unsigned long start = millis();
+    unsigned long passes = 0;
+    while (millis() - start < duration) {
+        for (auto* device : devices) {
+            device->update();
+        }
+        delay(LOOP_DELAY);
+        passes++;
+    }
+    return passes;
+}
+
+// The loop of main.cpp: due devices only, then sleep until the earliest deadline.
+static unsigned long runScheduledLoop(LoopScheduler& scheduler, unsigned long duration) {
+    unsigned long start = millis();
+    while (millis() - start < duration) {
+        scheduler.beginPass();
+        for (auto* device : devices) {
+            if (scheduler.isDue(device)) {
+                device->update();
+            }
+        }
+        scheduler.sleep(scheduler.getSleepTime(LOOP_DELAY, MAX_LOOP_DELAY));
+    }
+    return scheduler.getPasses();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_scheduler_saves_wakeups() {
+    beginAll();
+    unsigned long fixedPasses = runFixedDelayLoop(HOUR);
+    unsigned long fixedReads[5];
+    for (int i = 0; i < 5; i++) {
+        fixedReads[i] = static_cast<IntervalDevice*>(deviceSlots[i])->getReads();
+    }
+
+    LoopScheduler scheduler(devices);
+    beginAll();
+    unsigned long scheduledPasses = runScheduledLoop(scheduler, HOUR);
+
+    char message[120];
+    snprintf(message, sizeof(message), "Wakeups per hour: fixed %lu, scheduled %lu, saved %lu", fixedPasses, scheduledPasses, fixedPasses - scheduledPasses);
+    TEST_MESSAGE(message);
+
+    // Reading the simulated clock costs a little time, so the fixed loop ends a few passes short.
+    TEST_ASSERT_UINT32_WITHIN(HOUR / LOOP_DELAY / 100, HOUR / LOOP_DELAY, fixedPasses);
+    // The meters wake the loop about once a second each instead of fifty times.
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(fixedPasses / 10, scheduledPasses);
+    // No reading is lost: each device is read as often as before, give or take the last interval.
+    for (int i = 0; i < 5; i++) {
+        unsigned long reads = static_cast<IntervalDevice*>(deviceSlots[i])->getReads();
+        TEST_ASSERT_UINT32_WITHIN(1, fixedReads[i], reads);
+    }
+}
+
+void test_polling_device_keeps_the_loop_delay() {
+    PollingDevice poller;
+    Device* slots[] = { &tempSensor, &poller };
+    DeviceList<Device> withPoller(slots, 2, 2);
+    LoopScheduler scheduler(withPoller);
+    tempSensor.begin();
+    TEST_ASSERT_EQUAL_UINT32(LOOP_DELAY, scheduler.getSleepTime(LOOP_DELAY, MAX_LOOP_DELAY));
+}
+
+void test_wake_ends_sleep_early() {
+    LoopScheduler scheduler(devices);
+    unsigned long start = millis();
+    // A button interrupt 137 ms into a sleep of a second.
+    Sim::at(start + 137, []() { LoopScheduler::wake(); });
+    scheduler.sleep(MAX_LOOP_DELAY);
+    TEST_ASSERT_UINT32_WITHIN(1, 137, millis() - start);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getWakeups());
+
+    // Without a wake the sleep runs to the end, in one piece.
+    unsigned long delayCalls = Sim::stats().delayCalls;
+    start = millis();
+    scheduler.sleep(MAX_LOOP_DELAY);
+    TEST_ASSERT_UINT32_WITHIN(1, MAX_LOOP_DELAY, millis() - start);
+    TEST_ASSERT_EQUAL_UINT32(1, Sim::stats().delayCalls - delayCalls);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getWakeups());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scheduler_saves_wakeups);
+    RUN_TEST(test_polling_device_keeps_the_loop_delay);
+    RUN_TEST(test_wake_ends_sleep_early);
+    return UNITY_END();
+}
\ No newline at end of file
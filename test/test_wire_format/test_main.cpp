@@ -0,0 +1,85 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Sim.h>
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "Configuration.h"
+#include "JsonProvider.h"
+
+void setup();
+void loop();
+
+// Bytes and encode time of a keyframe (every provider of the room) in both wire formats. The
+// room boots on the simulated hardware and runs for a while first, so every sensor has readings:
+//
+//     pio test -e native_woodshed -f test_wire_format -v
+//
+// Encode times are host times; they rank the formats, not what the node spends.
+
+static const unsigned long WARM_UP_MS = 120000;
+static const int ENCODE_RUNS = 500;
+
+struct Encoding {
+    size_t bytes;
+    double encodeMicros;
+};
+
+static void buildKeyframe(DynamicJsonDocument& doc, bool binary) {
+    // Fixed-decimal fields differ between the formats, so the document is built for each.
+    JsonProvider::setBinaryFormat(binary);
+    doc.clear();
+    JsonArray root = doc.to<JsonArray>();
+    dataExchanger.addToJson(root);
+    for (auto* device : allDevices) {
+        device->addToJson(root);
+    }
+}
+
+static Encoding encode(bool binary) {
+    DynamicJsonDocument doc(4096);
+    buildKeyframe(doc, binary);
+    Encoding result;
+    result.bytes = binary ? measureMsgPack(doc) : measureJson(doc);
+    std::vector<char> buffer(result.bytes + 1);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ENCODE_RUNS; i++) {
+        if (binary) {
+            serializeMsgPack(doc, buffer.data(), buffer.size());
+        } else {
+            serializeJson(doc, buffer.data(), buffer.size());
+        }
+    }
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    result.encodeMicros = nanos / 1000.0 / ENCODE_RUNS;
+    JsonProvider::setBinaryFormat(false);
+    return result;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_msgpack_keyframe_is_smaller() {
+    setup();
+    while (millis() < WARM_UP_MS) {
+        loop();
+    }
+
+    Encoding json = encode(false);
+    Encoding msgpack = encode(true);
+
+    char message[160];
+    snprintf(message, sizeof(message), "%s keyframe: json %u bytes, %.1f us; msgpack %u bytes, %.1f us (%.0f%% of the json bytes)", DEVICE_ID,
+             (unsigned)json.bytes, json.encodeMicros, (unsigned)msgpack.bytes, msgpack.encodeMicros, 100.0 * msgpack.bytes / json.bytes);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_GREATER_THAN_UINT32(0, json.bytes);
+    TEST_ASSERT_LESS_THAN_UINT32(json.bytes, msgpack.bytes);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_msgpack_keyframe_is_smaller);
+    return UNITY_END();
+}
\ No newline at end of file